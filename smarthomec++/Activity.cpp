@@ -1,5 +1,6 @@
 #include "activity.hpp"
 #include "user.hpp"
+#include "FieldTokenizer.hpp"
 #include <iostream>
 #include <iomanip>
 #include <ctime>
@@ -20,20 +21,20 @@ Activity::Activity(const Activity& other)
 Activity::~Activity() {}
 
 void Activity::logActivity() {
-    std::cout << " : " << action;
+    std::cout << " Активность: " << action;
     if (user) {
-        std::cout << "  " << user->getUsername();
+        std::cout << " пользователем " << user->getUsername();
     }
     if (!relatedObject.empty()) {
-        std::cout << "  " << relatedObject;
+        std::cout << " на " << relatedObject;
     }
     std::cout << std::endl;
 }
 
 void Activity::displayInfo() const {
-    std::cout << ": " << action;
+    std::cout << "Активность: " << action;
     if (user) {
-        std::cout << " (: " << user->getUsername() << ")";
+        std::cout << " (Пользователь: " << user->getUsername() << ")";
     }
     std::cout << std::endl;
 }
@@ -66,22 +67,15 @@ std::string Activity::serialize() const {
 }
 
 std::shared_ptr<Activity> Activity::deserialize(const std::string& data, User* user) {
-    try {
-        std::stringstream ss(data);
-        std::string id, userId, action, timestampStr, relatedObject;
-
-        std::getline(ss, id, '|');
-        std::getline(ss, userId, '|');
-        std::getline(ss, action, '|');
-        std::getline(ss, timestampStr, '|');
-        std::getline(ss, relatedObject, '|');
-
-        auto activity = std::make_shared<Activity>(id, user, action);
-        activity->setRelatedObject(relatedObject);
-        return activity;
-    }
-    catch (const std::exception& e) {
-        std::cerr << "  : " << e.what() << std::endl;
+    FieldTokenizer fields(data);
+    int64_t timestamp = 0;
+    if (!fields.getInt64(3, timestamp)) {
+        std::cerr << "Ошибка десериализации активности: " << fields.errorText() << std::endl;
         return nullptr;
     }
+
+    auto activity = std::make_shared<Activity>(fields.text(0), user, fields.text(2));
+    activity->timestamp = static_cast<std::time_t>(timestamp);
+    activity->setRelatedObject(fields.text(4));
+    return activity;
 }
\ No newline at end of file
@@ -0,0 +1,586 @@
+﻿#include "AggregateKernels.hpp"
+#include <bitset>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define KERNELS_X86 0
+#endif
+
+// MSVC компилирует интринсики любого набора без ключей /arch, GCC и Clang - только
+// в функциях с атрибутом target. Вызов идет лишь после проверки процессора
+#if defined(__GNUC__)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+
+const size_t PowerSummary::TYPE_COUNT;
+const size_t PowerSummary::NONE;
+
+PowerSummary::PowerSummary()
+    : count(0), activeCount(0), onlineCount(0), activePower(0.0), totalPower(0.0),
+    minPower(0.0), maxPower(0.0), minIndex(NONE), maxIndex(NONE) {
+    for (size_t t = 0; t < TYPE_COUNT; ++t) {
+        byType[t] = 0;
+    }
+}
+
+void PowerSummary::merge(const PowerSummary& block, size_t base) {
+    count += block.count;
+    activeCount += block.activeCount;
+    onlineCount += block.onlineCount;
+    activePower += block.activePower;
+    totalPower += block.totalPower;
+    // Блоки идут по порядку, строгое сравнение сохраняет первое вхождение
+    if (block.minIndex != NONE && (minIndex == NONE || block.minPower < minPower)) {
+        minPower = block.minPower;
+        minIndex = base + block.minIndex;
+    }
+    if (block.maxIndex != NONE && (maxIndex == NONE || block.maxPower > maxPower)) {
+        maxPower = block.maxPower;
+        maxIndex = base + block.maxIndex;
+    }
+    for (size_t t = 0; t < TYPE_COUNT; ++t) {
+        byType[t] += block.byType[t];
+    }
+}
+
+namespace {
+
+size_t popcount(uint64_t word) {
+    return std::bitset<64>(word).count();
+}
+
+bool maskBit(const uint64_t* mask, size_t i) {
+    return (mask[i / 64] >> (i % 64)) & 1;
+}
+
+// Биты mask для записей [i, i + width), width <= 32
+uint32_t maskBits(const uint64_t* mask, size_t i, size_t width) {
+    return static_cast<uint32_t>((mask[i / 64] >> (i % 64)) & ((uint64_t(1) << width) - 1));
+}
+
+// ---- Скалярная реализация: она же обрабатывает хвосты векторных ----
+
+double sumScalar(const double* values, const uint64_t* mask, size_t begin, size_t count) {
+    double total = 0.0;
+    for (size_t i = begin; i < count; ++i) {
+        if (maskBit(mask, i)) {
+            total += values[i];
+        }
+    }
+    return total;
+}
+
+// Продолжает поиск с позиции begin; найденное ранее не заменяется равным значением
+void minMaxScalar(const double* values, const uint64_t* mask, size_t begin, size_t count,
+    double& minValue, size_t& minIndex, double& maxValue, size_t& maxIndex) {
+    for (size_t i = begin; i < count; ++i) {
+        if (!maskBit(mask, i)) continue;
+        if (values[i] < minValue) {
+            minValue = values[i];
+            minIndex = i;
+        }
+        if (values[i] > maxValue) {
+            maxValue = values[i];
+            maxIndex = i;
+        }
+    }
+}
+
+void countScalar(const uint8_t* types, const uint64_t* mask, size_t begin, size_t count, size_t* counts) {
+    for (size_t i = begin; i < count; ++i) {
+        if (maskBit(mask, i) && types[i] < PowerSummary::TYPE_COUNT) {
+            counts[types[i]]++;
+        }
+    }
+}
+
+void resetMinMax(double& minValue, size_t& minIndex, double& maxValue, size_t& maxIndex) {
+    minValue = HUGE_VAL;
+    maxValue = -HUGE_VAL;
+    minIndex = PowerSummary::NONE;
+    maxIndex = PowerSummary::NONE;
+}
+
+double maskedSumScalar(const double* values, const uint64_t* mask, size_t count) {
+    return sumScalar(values, mask, 0, count);
+}
+
+void minMaxFullScalar(const double* values, const uint64_t* mask, size_t count,
+    double& minValue, size_t& minIndex, double& maxValue, size_t& maxIndex) {
+    resetMinMax(minValue, minIndex, maxValue, maxIndex);
+    minMaxScalar(values, mask, 0, count, minValue, minIndex, maxValue, maxIndex);
+}
+
+void countByTypeScalar(const uint8_t* types, const uint64_t* mask, size_t count, size_t* counts) {
+    countScalar(types, mask, 0, count, counts);
+}
+
+// Счетчики сводки по словам битовых наборов
+void countBits(const KernelBlock& block, PowerSummary& out) {
+    for (size_t w = 0; w * 64 < block.count; ++w) {
+        size_t rest = block.count - w * 64;
+        uint64_t limit = rest >= 64 ? ~uint64_t(0) : (uint64_t(1) << rest) - 1;
+        uint64_t included = block.included[w] & limit;
+        out.count += popcount(included);
+        out.activeCount += popcount(included & block.on[w]);
+        out.onlineCount += popcount(included & block.online[w]);
+    }
+}
+
+// Суммы, минимум/максимум и типы для записей [begin, count)
+void accumulateScalar(const KernelBlock& block, size_t begin, PowerSummary& out) {
+    for (size_t i = begin; i < block.count; ++i) {
+        if (!maskBit(block.included, i)) continue;
+        double value = block.power[i];
+        out.totalPower += value;
+        if (maskBit(block.on, i)) {
+            out.activePower += value;
+        }
+        if (value < out.minPower) {
+            out.minPower = value;
+            out.minIndex = i;
+        }
+        if (value > out.maxPower) {
+            out.maxPower = value;
+            out.maxIndex = i;
+        }
+        if (block.type[i] < PowerSummary::TYPE_COUNT) {
+            out.byType[block.type[i]]++;
+        }
+    }
+}
+
+// Новый минимум или максимум в блоке встречается редко: только тогда ищется его
+// первая позиция. low и high - минимум и максимум отмеченных записей блока.
+// Векторные ядра вызывают ее лишь при улучшении, чтобы не платить за переход AVX/SSE
+void updateExtremes(const KernelBlock& block, size_t begin, size_t width,
+    double low, double high, PowerSummary& out) {
+    if (low < out.minPower) {
+        for (size_t i = begin; i < begin + width; ++i) {
+            if (maskBit(block.included, i) && block.power[i] == low) {
+                out.minPower = low;
+                out.minIndex = i;
+                break;
+            }
+        }
+    }
+    if (high > out.maxPower) {
+        for (size_t i = begin; i < begin + width; ++i) {
+            if (maskBit(block.included, i) && block.power[i] == high) {
+                out.maxPower = high;
+                out.maxIndex = i;
+                break;
+            }
+        }
+    }
+}
+
+void summarizeScalar(const KernelBlock& block, PowerSummary& out) {
+    resetMinMax(out.minPower, out.minIndex, out.maxPower, out.maxIndex);
+    countBits(block, out);
+    accumulateScalar(block, 0, out);
+}
+
+// Сводит результаты векторных дорожек: меньшее значение, при равенстве - меньший индекс.
+// Индексы дорожек хранятся как double (точно до 2^53), -1 - дорожка пуста
+void reduceLanes(const double* laneMin, const double* laneMinIndex,
+    const double* laneMax, const double* laneMaxIndex, size_t lanes,
+    double& minValue, size_t& minIndex, double& maxValue, size_t& maxIndex) {
+    for (size_t j = 0; j < lanes; ++j) {
+        if (laneMinIndex[j] >= 0) {
+            size_t index = static_cast<size_t>(laneMinIndex[j]);
+            if (minIndex == PowerSummary::NONE || laneMin[j] < minValue ||
+                (laneMin[j] == minValue && index < minIndex)) {
+                minValue = laneMin[j];
+                minIndex = index;
+            }
+        }
+        if (laneMaxIndex[j] >= 0) {
+            size_t index = static_cast<size_t>(laneMaxIndex[j]);
+            if (maxIndex == PowerSummary::NONE || laneMax[j] > maxValue ||
+                (laneMax[j] == maxValue && index < maxIndex)) {
+                maxValue = laneMax[j];
+                maxIndex = index;
+            }
+        }
+    }
+}
+
+#if KERNELS_X86
+
+// ---- SSE2: по 2 значения, выбор по маске через and/andnot ----
+
+alignas(16) const uint64_t SELECT2[4][2] = {
+    { 0, 0 }, { ~uint64_t(0), 0 }, { 0, ~uint64_t(0) }, { ~uint64_t(0), ~uint64_t(0) }
+};
+
+TARGET_SSE2 __m128d select2(uint32_t bits) {
+    return _mm_castsi128_pd(_mm_load_si128(reinterpret_cast<const __m128i*>(SELECT2[bits])));
+}
+
+TARGET_SSE2 __m128d blend2(__m128d a, __m128d b, __m128d selector) {
+    return _mm_or_pd(_mm_and_pd(selector, b), _mm_andnot_pd(selector, a));
+}
+
+TARGET_SSE2 double maskedSumSse2(const double* values, const uint64_t* mask, size_t count) {
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    size_t i = 0;
+    while (i + 4 <= count) {
+        if (i % 64 == 0 && mask[i / 64] == 0 && i + 64 <= count) {
+            i += 64;
+            continue;
+        }
+        uint32_t bits = maskBits(mask, i, 4);
+        if (bits) {
+            acc0 = _mm_add_pd(acc0, _mm_and_pd(_mm_loadu_pd(values + i), select2(bits & 3)));
+            acc1 = _mm_add_pd(acc1, _mm_and_pd(_mm_loadu_pd(values + i + 2), select2(bits >> 2)));
+        }
+        i += 4;
+    }
+    alignas(16) double lanes[2];
+    _mm_store_pd(lanes, _mm_add_pd(acc0, acc1));
+    return lanes[0] + lanes[1] + sumScalar(values, mask, i, count);
+}
+
+TARGET_SSE2 void minMaxSse2(const double* values, const uint64_t* mask, size_t count,
+    double& minValue, size_t& minIndex, double& maxValue, size_t& maxIndex) {
+    resetMinMax(minValue, minIndex, maxValue, maxIndex);
+    const __m128d positive = _mm_set1_pd(HUGE_VAL);
+    const __m128d negative = _mm_set1_pd(-HUGE_VAL);
+    const __m128d step = _mm_set1_pd(2.0);
+    __m128d vmin = positive, vmax = negative;
+    __m128d imin = _mm_set1_pd(-1.0), imax = _mm_set1_pd(-1.0);
+    __m128d index = _mm_set_pd(1.0, 0.0);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128d selector = select2(maskBits(mask, i, 2));
+        __m128d x = _mm_loadu_pd(values + i);
+        __m128d forMin = blend2(positive, x, selector);
+        __m128d forMax = blend2(negative, x, selector);
+        __m128d less = _mm_cmplt_pd(forMin, vmin);
+        __m128d greater = _mm_cmpgt_pd(forMax, vmax);
+        vmin = blend2(vmin, forMin, less);
+        imin = blend2(imin, index, less);
+        vmax = blend2(vmax, forMax, greater);
+        imax = blend2(imax, index, greater);
+        index = _mm_add_pd(index, step);
+    }
+    alignas(16) double laneMin[2], laneMinIndex[2], laneMax[2], laneMaxIndex[2];
+    _mm_store_pd(laneMin, vmin);
+    _mm_store_pd(laneMinIndex, imin);
+    _mm_store_pd(laneMax, vmax);
+    _mm_store_pd(laneMaxIndex, imax);
+    reduceLanes(laneMin, laneMinIndex, laneMax, laneMaxIndex, 2, minValue, minIndex, maxValue, maxIndex);
+    minMaxScalar(values, mask, i, count, minValue, minIndex, maxValue, maxIndex);
+}
+
+TARGET_SSE2 void countByTypeSse2(const uint8_t* types, const uint64_t* mask, size_t count, size_t* counts) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint32_t bits = maskBits(mask, i, 16);
+        if (!bits) continue;
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(types + i));
+        for (size_t t = 0; t < PowerSummary::TYPE_COUNT; ++t) {
+            __m128i equal = _mm_cmpeq_epi8(chunk, _mm_set1_epi8(static_cast<char>(t)));
+            counts[t] += popcount(static_cast<uint32_t>(_mm_movemask_epi8(equal)) & bits);
+        }
+    }
+    countScalar(types, mask, i, count, counts);
+}
+
+// Один проход: на каждые 16 записей - типы одним сравнением, мощность парами
+TARGET_SSE2 void summarizeSse2(const KernelBlock& block, PowerSummary& out) {
+    resetMinMax(out.minPower, out.minIndex, out.maxPower, out.maxIndex);
+    countBits(block, out);
+    const __m128d positive = _mm_set1_pd(HUGE_VAL);
+    const __m128d negative = _mm_set1_pd(-HUGE_VAL);
+    __m128d total = _mm_setzero_pd(), active = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= block.count; i += 16) {
+        uint32_t included = maskBits(block.included, i, 16);
+        if (!included) continue;
+        uint32_t on = included & maskBits(block.on, i, 16);
+
+        __m128i types = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block.type + i));
+        for (size_t t = 0; t < PowerSummary::TYPE_COUNT; ++t) {
+            __m128i equal = _mm_cmpeq_epi8(types, _mm_set1_epi8(static_cast<char>(t)));
+            out.byType[t] += popcount(static_cast<uint32_t>(_mm_movemask_epi8(equal)) & included);
+        }
+
+        __m128d low = positive, high = negative;
+        for (size_t j = 0; j < 16; j += 2) {
+            uint32_t pair = (included >> j) & 3;
+            if (!pair) continue;
+            __m128d selector = select2(pair);
+            __m128d x = _mm_loadu_pd(block.power + i + j);
+            total = _mm_add_pd(total, _mm_and_pd(x, selector));
+            active = _mm_add_pd(active, _mm_and_pd(x, select2((on >> j) & 3)));
+            low = _mm_min_pd(low, blend2(positive, x, selector));
+            high = _mm_max_pd(high, blend2(negative, x, selector));
+        }
+        low = _mm_min_pd(low, _mm_unpackhi_pd(low, low));
+        high = _mm_max_pd(high, _mm_unpackhi_pd(high, high));
+        double lowValue = _mm_cvtsd_f64(low), highValue = _mm_cvtsd_f64(high);
+        if (lowValue < out.minPower || highValue > out.maxPower) {
+            updateExtremes(block, i, 16, lowValue, highValue, out);
+        }
+    }
+    __m128d sums = _mm_add_pd(_mm_unpacklo_pd(total, active), _mm_unpackhi_pd(total, active));
+    alignas(16) double lanes[2];
+    _mm_store_pd(lanes, sums);
+    out.totalPower += lanes[0];
+    out.activePower += lanes[1];
+    accumulateScalar(block, i, out);
+}
+
+// ---- AVX2: по 4 значения, маска дорожек из 4 бит сравнением ----
+
+TARGET_AVX2 __m256d select4(uint32_t bits) {
+    const __m256i lane = _mm256_set_epi64x(8, 4, 2, 1);
+    __m256i spread = _mm256_and_si256(_mm256_set1_epi64x(bits), lane);
+    return _mm256_castsi256_pd(_mm256_cmpeq_epi64(spread, lane));
+}
+
+TARGET_AVX2 double maskedSumAvx2(const double* values, const uint64_t* mask, size_t count) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    while (i + 8 <= count) {
+        if (i % 64 == 0 && mask[i / 64] == 0 && i + 64 <= count) {
+            i += 64;
+            continue;
+        }
+        uint32_t bits = maskBits(mask, i, 8);
+        if (bits) {
+            acc0 = _mm256_add_pd(acc0, _mm256_and_pd(_mm256_loadu_pd(values + i), select4(bits & 15)));
+            acc1 = _mm256_add_pd(acc1, _mm256_and_pd(_mm256_loadu_pd(values + i + 4), select4(bits >> 4)));
+        }
+        i += 8;
+    }
+    __m256d acc = _mm256_add_pd(acc0, acc1);
+    __m128d half = _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+    alignas(16) double lanes[2];
+    _mm_store_pd(lanes, half);
+    return lanes[0] + lanes[1] + sumScalar(values, mask, i, count);
+}
+
+TARGET_AVX2 void minMaxAvx2(const double* values, const uint64_t* mask, size_t count,
+    double& minValue, size_t& minIndex, double& maxValue, size_t& maxIndex) {
+    resetMinMax(minValue, minIndex, maxValue, maxIndex);
+    const __m256d positive = _mm256_set1_pd(HUGE_VAL);
+    const __m256d negative = _mm256_set1_pd(-HUGE_VAL);
+    const __m256d step = _mm256_set1_pd(4.0);
+    __m256d vmin = positive, vmax = negative;
+    __m256d imin = _mm256_set1_pd(-1.0), imax = _mm256_set1_pd(-1.0);
+    __m256d index = _mm256_set_pd(3.0, 2.0, 1.0, 0.0);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d selector = select4(maskBits(mask, i, 4));
+        __m256d x = _mm256_loadu_pd(values + i);
+        __m256d forMin = _mm256_blendv_pd(positive, x, selector);
+        __m256d forMax = _mm256_blendv_pd(negative, x, selector);
+        __m256d less = _mm256_cmp_pd(forMin, vmin, _CMP_LT_OQ);
+        __m256d greater = _mm256_cmp_pd(forMax, vmax, _CMP_GT_OQ);
+        vmin = _mm256_blendv_pd(vmin, forMin, less);
+        imin = _mm256_blendv_pd(imin, index, less);
+        vmax = _mm256_blendv_pd(vmax, forMax, greater);
+        imax = _mm256_blendv_pd(imax, index, greater);
+        index = _mm256_add_pd(index, step);
+    }
+    alignas(32) double laneMin[4], laneMinIndex[4], laneMax[4], laneMaxIndex[4];
+    _mm256_store_pd(laneMin, vmin);
+    _mm256_store_pd(laneMinIndex, imin);
+    _mm256_store_pd(laneMax, vmax);
+    _mm256_store_pd(laneMaxIndex, imax);
+    reduceLanes(laneMin, laneMinIndex, laneMax, laneMaxIndex, 4, minValue, minIndex, maxValue, maxIndex);
+    minMaxScalar(values, mask, i, count, minValue, minIndex, maxValue, maxIndex);
+}
+
+TARGET_AVX2 void countByTypeAvx2(const uint8_t* types, const uint64_t* mask, size_t count, size_t* counts) {
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        uint32_t bits = maskBits(mask, i, 32);
+        if (!bits) continue;
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(types + i));
+        for (size_t t = 0; t < PowerSummary::TYPE_COUNT; ++t) {
+            __m256i equal = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(static_cast<char>(t)));
+            counts[t] += popcount(static_cast<uint32_t>(_mm256_movemask_epi8(equal)) & bits);
+        }
+    }
+    countScalar(types, mask, i, count, counts);
+}
+
+// Один проход: на каждые 32 записи - типы одним сравнением, мощность четверками
+TARGET_AVX2 void summarizeAvx2(const KernelBlock& block, PowerSummary& out) {
+    resetMinMax(out.minPower, out.minIndex, out.maxPower, out.maxIndex);
+    countBits(block, out);
+    const __m256d positive = _mm256_set1_pd(HUGE_VAL);
+    const __m256d negative = _mm256_set1_pd(-HUGE_VAL);
+    __m256d total = _mm256_setzero_pd(), active = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 32 <= block.count; i += 32) {
+        uint32_t included = maskBits(block.included, i, 32);
+        if (!included) continue;
+        uint32_t on = included & maskBits(block.on, i, 32);
+
+        __m256i types = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block.type + i));
+        for (size_t t = 0; t < PowerSummary::TYPE_COUNT; ++t) {
+            __m256i equal = _mm256_cmpeq_epi8(types, _mm256_set1_epi8(static_cast<char>(t)));
+            out.byType[t] += popcount(static_cast<uint32_t>(_mm256_movemask_epi8(equal)) & included);
+        }
+
+        __m256d low = positive, high = negative;
+        for (size_t j = 0; j < 32; j += 4) {
+            uint32_t quad = (included >> j) & 15;
+            if (!quad) continue;
+            __m256d selector = select4(quad);
+            __m256d x = _mm256_loadu_pd(block.power + i + j);
+            total = _mm256_add_pd(total, _mm256_and_pd(x, selector));
+            active = _mm256_add_pd(active, _mm256_and_pd(x, select4((on >> j) & 15)));
+            low = _mm256_min_pd(low, _mm256_blendv_pd(positive, x, selector));
+            high = _mm256_max_pd(high, _mm256_blendv_pd(negative, x, selector));
+        }
+        __m128d low2 = _mm_min_pd(_mm256_castpd256_pd128(low), _mm256_extractf128_pd(low, 1));
+        __m128d high2 = _mm_max_pd(_mm256_castpd256_pd128(high), _mm256_extractf128_pd(high, 1));
+        low2 = _mm_min_pd(low2, _mm_unpackhi_pd(low2, low2));
+        high2 = _mm_max_pd(high2, _mm_unpackhi_pd(high2, high2));
+        double lowValue = _mm_cvtsd_f64(low2), highValue = _mm_cvtsd_f64(high2);
+        if (lowValue < out.minPower || highValue > out.maxPower) {
+            updateExtremes(block, i, 32, lowValue, highValue, out);
+        }
+    }
+    __m256d sums = _mm256_hadd_pd(total, active);
+    __m128d pairs = _mm_add_pd(_mm256_castpd256_pd128(sums), _mm256_extractf128_pd(sums, 1));
+    alignas(16) double lanes[2];
+    _mm_store_pd(lanes, pairs);
+    out.totalPower += lanes[0];
+    out.activePower += lanes[1];
+    accumulateScalar(block, i, out);
+}
+
+#endif
+
+typedef AggregateKernels::Level Level;
+
+struct KernelSet {
+    Level level;
+    const char* name;
+    double (*maskedSum)(const double*, const uint64_t*, size_t);
+    void (*minMax)(const double*, const uint64_t*, size_t, double&, size_t&, double&, size_t&);
+    void (*countByType)(const uint8_t*, const uint64_t*, size_t, size_t*);
+    void (*summarize)(const KernelBlock&, PowerSummary&);
+};
+
+const KernelSet SCALAR_KERNELS = {
+    Level::SCALAR, "scalar", maskedSumScalar, minMaxFullScalar, countByTypeScalar, summarizeScalar
+};
+#if KERNELS_X86
+const KernelSet SSE2_KERNELS = {
+    Level::SSE2, "SSE2", maskedSumSse2, minMaxSse2, countByTypeSse2, summarizeSse2
+};
+const KernelSet AVX2_KERNELS = {
+    Level::AVX2, "AVX2", maskedSumAvx2, minMaxAvx2, countByTypeAvx2, summarizeAvx2
+};
+#endif
+
+Level detectLevel() {
+#if KERNELS_X86
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    // AVX можно использовать, только если ОС сохраняет регистры YMM
+    if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6) {
+        __cpuidex(info, 7, 0);
+        if (info[1] & (1 << 5)) {
+            return Level::AVX2;
+        }
+    }
+    return sse2 ? Level::SSE2 : Level::SCALAR;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return Level::AVX2;
+    }
+    return __builtin_cpu_supports("sse2") ? Level::SSE2 : Level::SCALAR;
+#endif
+#else
+    return Level::SCALAR;
+#endif
+}
+
+Level availableLevel() {
+    static const Level available = detectLevel();
+    return available;
+}
+
+const KernelSet& kernelsFor(Level level) {
+#if KERNELS_X86
+    if (level == Level::AVX2) return AVX2_KERNELS;
+    if (level == Level::SSE2) return SSE2_KERNELS;
+#endif
+    (void)level;
+    return SCALAR_KERNELS;
+}
+
+std::atomic<const KernelSet*> selected(nullptr);
+
+const KernelSet& kernels() {
+    const KernelSet* set = selected.load(std::memory_order_acquire);
+    if (!set) {
+        set = &kernelsFor(availableLevel());
+        selected.store(set, std::memory_order_release);
+    }
+    return *set;
+}
+
+} // namespace
+
+AggregateKernels::Level AggregateKernels::level() {
+    return kernels().level;
+}
+
+const char* AggregateKernels::levelName() {
+    return kernels().name;
+}
+
+void AggregateKernels::setLevel(Level requested) {
+    Level level = std::min(requested, availableLevel());
+    selected.store(&kernelsFor(level), std::memory_order_release);
+}
+
+double AggregateKernels::maskedSum(const double* values, const uint64_t* mask, size_t count) {
+    return kernels().maskedSum(values, mask, count);
+}
+
+void AggregateKernels::minMax(const double* values, const uint64_t* mask, size_t count,
+    double& minValue, size_t& minIndex, double& maxValue, size_t& maxIndex) {
+    kernels().minMax(values, mask, count, minValue, minIndex, maxValue, maxIndex);
+}
+
+void AggregateKernels::countByType(const uint8_t* types, const uint64_t* mask, size_t count, size_t* counts) {
+    kernels().countByType(types, mask, count, counts);
+}
+
+void AggregateKernels::summarize(const KernelBlock& block, PowerSummary& out) {
+    PowerSummary part;
+    kernels().summarize(block, part);
+    out.merge(part, 0);
+}
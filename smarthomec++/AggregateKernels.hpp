@@ -0,0 +1,69 @@
+﻿#ifndef AGGREGATEKERNELS_HPP
+#define AGGREGATEKERNELS_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include "deviceType.hpp"
+
+// Сводка по набору устройств за один проход
+struct PowerSummary {
+    static const size_t TYPE_COUNT = static_cast<size_t>(DeviceType::MULTIMEDIA) + 1;
+    static const size_t NONE = static_cast<size_t>(-1);
+
+    size_t count;               // учтено устройств
+    size_t activeCount;
+    size_t onlineCount;
+    double activePower;         // сумма мощности включенных
+    double totalPower;          // сумма мощности всех
+    double minPower;
+    double maxPower;
+    size_t minIndex;            // первое устройство с минимальной мощностью, NONE - нет устройств
+    size_t maxIndex;
+    size_t byType[TYPE_COUNT];
+
+    PowerSummary();
+
+    // Добавляет сводку следующего блока; индексы блока сдвигаются на base
+    void merge(const PowerSummary& block, size_t base);
+};
+
+// Блок устройств для ядер: параллельные массивы и битовые наборы (64 записи на слово)
+struct KernelBlock {
+    const double* power;
+    const uint8_t* type;
+    const uint64_t* included;   // какие записи учитывать
+    const uint64_t* on;
+    const uint64_t* online;
+    size_t count;
+};
+
+// Векторизованные агрегаты по массивам DeviceStateTable.
+//
+// Реализация выбирается один раз при первом вызове по возможностям процессора:
+// AVX2, SSE2 или скалярная. Все варианты дают одинаковые индексы минимума и
+// максимума (первое вхождение); суммы могут отличаться в последних знаках из-за
+// другого порядка сложения
+class AggregateKernels {
+public:
+    enum class Level { SCALAR, SSE2, AVX2 };
+
+    static Level level();
+    static const char* levelName();
+    // Принудительный выбор реализации (не выше доступной), например для сравнения скорости
+    static void setLevel(Level requested);
+
+    // Сумма values[i], для которых установлен бит i в mask
+    static double maskedSum(const double* values, const uint64_t* mask, size_t count);
+
+    // Минимум и максимум среди отмеченных записей; индексы NONE, если таких нет
+    static void minMax(const double* values, const uint64_t* mask, size_t count,
+        double& minValue, size_t& minIndex, double& maxValue, size_t& maxIndex);
+
+    // counts[t] += число отмеченных записей типа t (t < PowerSummary::TYPE_COUNT)
+    static void countByType(const uint8_t* types, const uint64_t* mask, size_t count, size_t* counts);
+
+    // Все агрегаты за один проход по блоку; результат добавляется к out (merge с base 0)
+    static void summarize(const KernelBlock& block, PowerSummary& out);
+};
+
+#endif
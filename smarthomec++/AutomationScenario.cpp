@@ -1,5 +1,6 @@
 #include "automationScenario.hpp"
 #include "scenarioAction.hpp"
+#include "FieldTokenizer.hpp"
 #include <iostream>
 #include <iomanip>
 #include <sstream>
@@ -14,31 +15,35 @@ AutomationScenario::~AutomationScenario() {
 }
 
 void AutomationScenario::activate() {
+    touch();
     isActive = true;
-    std::cout << " '" << name << "' " << std::endl;
+    std::cout << "Сценарий '" << name << "' активирован" << std::endl;
 }
 
 void AutomationScenario::deactivate() {
+    touch();
     isActive = false;
-    std::cout << " '" << name << "' " << std::endl;
+    std::cout << "Сценарий '" << name << "' деактивирован" << std::endl;
 }
 
 void AutomationScenario::execute() {
     if (!isActive) {
-        std::cout << " '" << name << "'  " << std::endl;
+        std::cout << "Сценарий '" << name << "' не активен" << std::endl;
         return;
     }
-    std::cout << " : " << name << std::endl;
+    std::cout << "Выполнение сценария: " << name << std::endl;
     for (auto& action : actions) {
         action->execute();
     }
 }
 
 void AutomationScenario::addAction(std::unique_ptr<ScenarioAction> action) {
+    touch();
     actions.push_back(std::move(action));
 }
 
 void AutomationScenario::removeAction(ScenarioAction* action) {
+    touch();
     for (auto it = actions.begin(); it != actions.end(); ++it) {
         if (it->get() == action) {
             actions.erase(it);
@@ -48,13 +53,13 @@ void AutomationScenario::removeAction(ScenarioAction* action) {
 }
 
 void AutomationScenario::displayInfo() const {
-    std::cout << ": " << name << " (" << (isActive ? "" : "") << ")\n";
-    std::cout << " : " << triggerTime << "\n";
-    std::cout << ": " << actions.size() << "\n";
+    std::cout << "Сценарий: " << name << " (" << (isActive ? "Активен" : "Неактивен") << ")\n";
+    std::cout << "Время запуска: " << triggerTime << "\n";
+    std::cout << "Действий: " << actions.size() << "\n";
 }
 
 void AutomationScenario::displayActions() const {
-    std::cout << "  '" << name << "':\n";
+    std::cout << "Действия сценария '" << name << "':\n";
     for (size_t i = 0; i < actions.size(); i++) {
         std::cout << "  " << i + 1 << ". ";
         actions[i]->displayInfo();
@@ -81,6 +86,10 @@ int AutomationScenario::getActionCount() const {
     return actions.size();
 }
 
+std::time_t AutomationScenario::getCreatedDate() const {
+    return createdDate;
+}
+
 std::string AutomationScenario::serialize() const {
     std::stringstream ss;
     ss << scenarioId << "|" << name << "|" << triggerTime << "|" << isActive << "|" << createdDate;
@@ -88,14 +97,23 @@ std::string AutomationScenario::serialize() const {
 }
 
 std::unique_ptr<AutomationScenario> AutomationScenario::deserialize(const std::string& data) {
-    std::stringstream ss(data);
-    std::string id, name, time, activeStr, dateStr;
-    std::getline(ss, id, '|');
-    std::getline(ss, name, '|');
-    std::getline(ss, time, '|');
-    std::getline(ss, activeStr, '|');
-    std::getline(ss, dateStr, '|');
-    auto scenario = std::make_unique<AutomationScenario>(id, name, time);
-    if (activeStr == "1") scenario->activate();
+    FieldTokenizer fields(data);
+    auto scenario = std::make_unique<AutomationScenario>(fields.text(0), fields.text(1), fields.text(2));
+    if (fields.flag(3)) scenario->activate();
+
+    // Дата создания необязательна: в старых файлах ее может не быть
+    int64_t created = 0;
+    if (fields.size() > 4 && fields.getInt64(4, created)) {
+        scenario->createdDate = static_cast<std::time_t>(created);
+    }
+    return scenario;
+}
+
+// Восстановление сценария из уже разобранных полей (используется бинарным снимком)
+std::unique_ptr<AutomationScenario> AutomationScenario::restore(const std::string& id, const std::string& scenarioName,
+    const std::string& time, bool active, std::time_t created) {
+    auto scenario = std::make_unique<AutomationScenario>(id, scenarioName, time);
+    scenario->isActive = active;
+    scenario->createdDate = created;
     return scenario;
 }
\ No newline at end of file
@@ -5,10 +5,11 @@
 #include <vector>
 #include <ctime>
 #include <memory>
+#include "Versioned.hpp"
 
 class ScenarioAction;
 
-class AutomationScenario {
+class AutomationScenario : public Versioned<AutomationScenario> {
 private:
     std::string scenarioId;
     std::string name;
@@ -35,9 +36,12 @@ public:
     std::string getTriggerTime() const;
     bool getIsActive() const;
     int getActionCount() const;
+    std::time_t getCreatedDate() const;
 
     std::string serialize() const;
     static std::unique_ptr<AutomationScenario> deserialize(const std::string& data);
+    static std::unique_ptr<AutomationScenario> restore(const std::string& id, const std::string& scenarioName,
+        const std::string& time, bool active, std::time_t created);
 };
 
 #endif
\ No newline at end of file
@@ -3,7 +3,7 @@
 #include <sstream>
 
 BaseEntity::BaseEntity(const std::string& id, const std::string& name)
-    : id(id), name(name), createdDate(std::time(nullptr)) {}
+    : id(id), name(name), createdDate(std::time(nullptr)), nameKey(name) {}
 
 std::string BaseEntity::getId() const {
     return this->id;
@@ -13,6 +13,15 @@ std::string BaseEntity::getName() const {
     return this->name;
 }
 
+const CollationKey& BaseEntity::getNameKey() const {
+    return this->nameKey;
+}
+
+void BaseEntity::rename(const std::string& newName) {
+    this->name = newName;
+    this->nameKey = CollationKey(newName);
+}
+
 std::time_t BaseEntity::getCreatedDate() const {
     return this->createdDate;
 }
@@ -1,15 +1,21 @@
-#ifndef BASEENTITY_HPP
+﻿#ifndef BASEENTITY_HPP
 #define BASEENTITY_HPP
 
 #include <string>
 #include <memory>
 #include <ctime>
+#include "CollationKey.hpp"
 
 class BaseEntity {
 protected:
     std::string id;
     std::string name;
     std::time_t createdDate;
+    CollationKey nameKey;
+
+    // Смена названия вместе с ключом сортировки. Только для присваивания объекта:
+    // индексы реестра и DeviceManager по названию при этом не перестраиваются
+    void rename(const std::string& newName);
 
 public:
     BaseEntity(const std::string& id, const std::string& name);
@@ -17,6 +23,7 @@ public:
 
     std::string getId() const;
     std::string getName() const;
+    const CollationKey& getNameKey() const;
     std::time_t getCreatedDate() const;
 
     virtual std::string serialize() const = 0;
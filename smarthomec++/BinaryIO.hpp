@@ -0,0 +1,94 @@
+﻿#ifndef BINARYIO_HPP
+#define BINARYIO_HPP
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
+
+// Запись бинарных данных в буфер памяти.
+// Числа пишутся в порядке байт хоста (проект собирается только под x86/x64, little-endian)
+class BinaryWriter {
+private:
+    std::vector<char> buffer;
+
+public:
+    template<typename T>
+    void write(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "Только тривиально копируемые типы");
+        writeBytes(&value, sizeof(T));
+    }
+
+    void writeBytes(const void* bytes, size_t count) {
+        const char* begin = static_cast<const char*>(bytes);
+        buffer.insert(buffer.end(), begin, begin + count);
+    }
+
+    // Перезапись уже записанного значения (например, длины секции)
+    template<typename T>
+    void patch(size_t offset, const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "Только тривиально копируемые типы");
+        std::memcpy(buffer.data() + offset, &value, sizeof(T));
+    }
+
+    size_t size() const { return buffer.size(); }
+    const std::vector<char>& data() const { return buffer; }
+    void clear() { buffer.clear(); }
+};
+
+// Чтение бинарных данных из буфера памяти с проверкой границ.
+// После первой ошибки все дальнейшие чтения возвращают false
+class BinaryReader {
+private:
+    const char* data;
+    size_t length;
+    size_t position;
+    bool failed;
+
+public:
+    BinaryReader(const char* bytes, size_t size)
+        : data(bytes), length(size), position(0), failed(false) {}
+
+    template<typename T>
+    bool read(T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "Только тривиально копируемые типы");
+        return readBytes(&value, sizeof(T));
+    }
+
+    bool readBytes(void* out, size_t count) {
+        if (failed || count > length - position) {
+            failed = true;
+            return false;
+        }
+        std::memcpy(out, data + position, count);
+        position += count;
+        return true;
+    }
+
+    bool readString(std::string& out, size_t count) {
+        if (failed || count > length - position) {
+            failed = true;
+            return false;
+        }
+        out.assign(data + position, count);
+        position += count;
+        return true;
+    }
+
+    bool skip(size_t count) {
+        if (failed || count > length - position) {
+            failed = true;
+            return false;
+        }
+        position += count;
+        return true;
+    }
+
+    const char* current() const { return data + position; }
+    size_t remaining() const { return length - position; }
+    size_t offset() const { return position; }
+    bool ok() const { return !failed; }
+};
+
+#endif
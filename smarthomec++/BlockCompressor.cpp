@@ -0,0 +1,127 @@
+﻿#include "BlockCompressor.hpp"
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+const size_t MIN_MATCH = 4;
+const size_t MAX_OFFSET = 65535;
+// Последние байты блока всегда литералы: распаковщику не нужно проверять хвост совпадения
+const size_t LAST_LITERALS = 5;
+const int HASH_BITS = 14;
+
+uint32_t read32(const char* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+size_t hash4(const char* p) {
+    return (read32(p) * 2654435761u) >> (32 - HASH_BITS);
+}
+
+void writeLength(std::vector<char>& out, size_t length) {
+    while (length >= 255) {
+        out.push_back(static_cast<char>(255));
+        length -= 255;
+    }
+    out.push_back(static_cast<char>(length));
+}
+
+void writeCommand(std::vector<char>& out, const char* literals, size_t literalCount,
+    size_t offset, size_t matchLength) {
+    size_t matchCode = matchLength >= MIN_MATCH ? matchLength - MIN_MATCH : 0;
+    uint8_t token = static_cast<uint8_t>((literalCount < 15 ? literalCount : 15) << 4);
+    token |= static_cast<uint8_t>(matchCode < 15 ? matchCode : 15);
+    out.push_back(static_cast<char>(token));
+    if (literalCount >= 15) writeLength(out, literalCount - 15);
+    out.insert(out.end(), literals, literals + literalCount);
+
+    if (matchLength == 0) return;  // последняя команда
+    out.push_back(static_cast<char>(offset & 0xFF));
+    out.push_back(static_cast<char>(offset >> 8));
+    if (matchCode >= 15) writeLength(out, matchCode - 15);
+}
+
+bool readLength(const uint8_t*& in, const uint8_t* end, size_t& length) {
+    uint8_t next;
+    do {
+        if (in >= end) return false;
+        next = *in++;
+        length += next;
+    } while (next == 255);
+    return true;
+}
+
+} // namespace
+
+void BlockCompressor::compress(const char* data, size_t size, std::vector<char>& out) {
+    out.clear();
+    out.reserve(size / 2 + 16);
+
+    size_t anchor = 0;
+    if (size > MIN_MATCH + LAST_LITERALS) {
+        std::vector<uint32_t> table(size_t(1) << HASH_BITS, 0);
+        size_t limit = size - LAST_LITERALS;
+        size_t position = 1;
+        table[hash4(data)] = 0;
+
+        while (position + MIN_MATCH <= limit) {
+            size_t slot = hash4(data + position);
+            size_t candidate = table[slot];
+            table[slot] = static_cast<uint32_t>(position);
+
+            if (position - candidate > MAX_OFFSET || read32(data + candidate) != read32(data + position)) {
+                position++;
+                continue;
+            }
+
+            size_t length = MIN_MATCH;
+            while (position + length < limit && data[candidate + length] == data[position + length]) {
+                length++;
+            }
+            writeCommand(out, data + anchor, position - anchor, position - candidate, length);
+            position += length;
+            anchor = position;
+        }
+    }
+    writeCommand(out, data + anchor, size - anchor, 0, 0);
+}
+
+bool BlockCompressor::decompress(const char* data, size_t size, size_t rawSize, std::vector<char>& out) {
+    out.resize(rawSize);
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(data);
+    const uint8_t* end = in + size;
+    size_t written = 0;
+
+    while (in < end) {
+        uint8_t token = *in++;
+        size_t literals = token >> 4;
+        if (literals == 15 && !readLength(in, end, literals)) return false;
+        if (literals > static_cast<size_t>(end - in) || literals > rawSize - written) return false;
+        if (literals > 0) {
+            std::memcpy(out.data() + written, in, literals);
+        }
+        in += literals;
+        written += literals;
+
+        if (in == end) break;  // последняя команда без совпадения
+
+        if (end - in < 2) return false;
+        size_t offset = in[0] | (static_cast<size_t>(in[1]) << 8);
+        in += 2;
+        size_t length = token & 0x0F;
+        if (length == 15 && !readLength(in, end, length)) return false;
+        length += MIN_MATCH;
+        if (offset == 0 || offset > written || length > rawSize - written) return false;
+
+        // Совпадение может перекрывать записываемые байты, поэтому копируем побайтно
+        char* target = out.data() + written;
+        const char* source = target - offset;
+        for (size_t i = 0; i < length; ++i) {
+            target[i] = source[i];
+        }
+        written += length;
+    }
+    return written == rawSize;
+}
@@ -0,0 +1,22 @@
+﻿#ifndef BLOCKCOMPRESSOR_HPP
+#define BLOCKCOMPRESSOR_HPP
+
+#include <vector>
+#include <cstddef>
+
+// Сжатие блоков данных по схеме LZ77 (формат близок к блокам LZ4).
+//
+// Блок - последовательность команд: байт-токен (старшие 4 бита - число литералов,
+// младшие - длина совпадения минус 4), при значении 15 длина продолжается
+// байтами до первого байта меньше 255; затем литералы, затем uint16 смещение
+// совпадения назад. Последняя команда содержит только литералы.
+// Предназначено для архива: сжатие выполняется один раз, распаковка - по требованию
+class BlockCompressor {
+public:
+    static void compress(const char* data, size_t size, std::vector<char>& out);
+
+    // rawSize - исходный размер; false, если блок поврежден
+    static bool decompress(const char* data, size_t size, size_t rawSize, std::vector<char>& out);
+};
+
+#endif
@@ -1,5 +1,7 @@
 #include "climateDevice.hpp"
 #include "room.hpp"
+#include "BinaryIO.hpp"
+#include "ObjectPool.hpp"
 #include <sstream>
 #include <iostream>
 #include <cmath>
@@ -16,13 +18,12 @@ ClimateDevice::ClimateDevice(const std::string& id, const std::string& deviceNam
 
 ClimateDevice::ClimateDevice(const ClimateDevice& other)
     : Device(other.id + "_copy", other.name + " (Copy)", other.manufacturer,
-        other.deviceType, other.location, other.powerConsumption),
+        other.getDeviceType(), other.location, other.getPowerConsumption()),
     targetTemperature(other.targetTemperature),
     currentTemperature(other.currentTemperature),
     humidity(other.humidity),
     autoMode(other.autoMode) {
-    this->isOn = other.isOn;
-    this->isOnline = other.isOnline;
+    copyState(other);
 }
 
 ClimateDevice::~ClimateDevice() {
@@ -42,16 +43,14 @@ ClimateDevice& ClimateDevice::operator=(const ClimateDevice& other) {
 
 ClimateDevice& ClimateDevice::operator=(const Device& other) {
     if (this != &other) {
+        touch();
         this->id = other.getId() + "_from_base";
         this->name = other.getName() + " (From Base)";
 
         const Device& deviceRef = static_cast<const Device&>(other);
         this->manufacturer = deviceRef.getManufacturer();
-        this->deviceType = deviceRef.getDeviceType();
-        this->location = deviceRef.getLocation();
-        this->isOn = deviceRef.getIsOn();
-        this->isOnline = deviceRef.getIsOnline();
-        this->powerConsumption = deviceRef.getPowerConsumption();
+        this->location = deviceRef.getLocationHandle();
+        copyState(deviceRef);
 
         this->targetTemperature = 22.0;
         this->currentTemperature = 20.0;
@@ -62,42 +61,44 @@ ClimateDevice& ClimateDevice::operator=(const Device& other) {
 }
 
 void ClimateDevice::turnOn() {
-    isOn = true;
+    touch();
+    setOnFlag(true);
     if (autoMode) {
         adjustTemperature();
     }
-    std::cout << "  " << name << " " << std::endl;
+    std::cout << "Климатическое устройство " << name << " включено" << std::endl;
 }
 
 void ClimateDevice::turnOff() {
-    isOn = false;
-    std::cout << "  " << name << " " << std::endl;
+    touch();
+    setOnFlag(false);
+    std::cout << "Климатическое устройство " << name << " выключено" << std::endl;
 }
 
 std::string ClimateDevice::getDetails() const {
     std::stringstream ss;
-    ss << " : " << name << "\n"
-        << " : " << targetTemperature << "C\n"
-        << " : " << currentTemperature << "C\n"
-        << ": " << humidity << "%\n"
-        << " : " << (autoMode ? "" : "") << "\n";
+    ss << "Климатическое устройство: " << name << "\n"
+        << "Целевая температура: " << targetTemperature << "°C\n"
+        << "Текущая температура: " << currentTemperature << "°C\n"
+        << "Влажность: " << humidity << "%\n"
+        << "Автоматический режим: " << (autoMode ? "ВКЛ" : "ВЫКЛ") << "\n";
     return ss.str();
 }
 
 void ClimateDevice::performSelfCheck() const {
-    std::cout << "  : " << name << std::endl;
-    std::cout << "  : " << currentTemperature << "/" << targetTemperature << "C" << std::endl;
-    std::cout << "  : " << humidity << "%" << std::endl;
-    std::cout << "  : " << (autoMode ? "" : "") << std::endl;
+    std::cout << "Проверка климатического устройства: " << name << std::endl;
+    std::cout << "  Температура: " << currentTemperature << "/" << targetTemperature << "°C" << std::endl;
+    std::cout << "  Влажность: " << humidity << "%" << std::endl;
+    std::cout << "  Авторежим: " << (autoMode ? "ВКЛ" : "ВЫКЛ") << std::endl;
 }
 
 double ClimateDevice::calculateEfficiency() const {
-    if (!isOn) return 0.0;
+    if (!getIsOn()) return 0.0;
 
     double tempDiff = std::abs(currentTemperature - targetTemperature);
     double efficiency = (tempDiff < 2.0) ? 0.9 : (tempDiff < 5.0) ? 0.7 : 0.5;
 
-    return powerConsumption * efficiency;
+    return getPowerConsumption() * efficiency;
 }
 
 ClimateDevice* ClimateDevice::clone() const {
@@ -105,18 +106,21 @@ ClimateDevice* ClimateDevice::clone() const {
 }
 
 void ClimateDevice::setTargetTemperature(double temp) {
+    touch();
     targetTemperature = temp;
-    if (isOn && autoMode) {
+    if (getIsOn() && autoMode) {
         adjustTemperature();
     }
 }
 
 void ClimateDevice::setAutoMode(bool enabled) {
+    touch();
     autoMode = enabled;
 }
 
 void ClimateDevice::adjustTemperature() {
-    if (!isOn) return;
+    touch();
+    if (!getIsOn()) return;
 
     if (currentTemperature < targetTemperature) {
         currentTemperature += 0.5;
@@ -128,7 +132,7 @@ void ClimateDevice::adjustTemperature() {
     if (humidity < 45) humidity += 1;
     else if (humidity > 55) humidity -= 1;
 
-    std::cout << " : " << currentTemperature << "C" << std::endl;
+    std::cout << "Температура отрегулирована: " << currentTemperature << "°C" << std::endl;
 }
 
 double ClimateDevice::getTargetTemperature() const {
@@ -147,56 +151,76 @@ bool ClimateDevice::isAutoMode() const {
     return autoMode;
 }
 
+bool ClimateDevice::hasExtraState() const {
+    return true;
+}
+
+void ClimateDevice::writeExtraState(BinaryWriter& out) const {
+    out.write(targetTemperature);
+    out.write(currentTemperature);
+    out.write(humidity);
+    out.write(static_cast<uint8_t>(autoMode));
+}
+
+bool ClimateDevice::readExtraState(BinaryReader& in) {
+    touch();
+    uint8_t mode = 0;
+    if (!in.read(targetTemperature) || !in.read(currentTemperature) || !in.read(humidity) || !in.read(mode)) {
+        return false;
+    }
+    autoMode = mode != 0;
+    return true;
+}
+
 std::string ClimateDevice::serialize() const {
+    Room* room = getLocation();
     std::stringstream ss;
     ss << id << "|" << name << "|" << manufacturer << "|"
-        << static_cast<int>(deviceType) << "|" << (location ? location->getId() : "NULL") << "|"
-        << isOn << "|" << isOnline << "|" << powerConsumption << "|"
+        << static_cast<int>(getDeviceType()) << "|" << (room ? room->getId() : "NULL") << "|"
+        << getIsOn() << "|" << getIsOnline() << "|" << getPowerConsumption() << "|"
         << targetTemperature << "|" << currentTemperature << "|" << humidity << "|" << autoMode;
     return ss.str();
 }
 
 void ClimateDevice::displayInfo() const {
-    std::cout << " : " << name << " (ID: " << id << ")" << std::endl;
-    std::cout << "  : " << manufacturer << std::endl;
-    std::cout << "  : " << getStatus() << std::endl;
-    std::cout << "  : " << powerConsumption << " " << std::endl;
-    std::cout << "  : " << currentTemperature << "C (: " << targetTemperature << "C)" << std::endl;
-    std::cout << "  : " << humidity << "%" << std::endl;
-    std::cout << "  : " << (autoMode ? "" : "") << std::endl;
+    std::cout << "Климатическое устройство: " << name << " (ID: " << id << ")" << std::endl;
+    std::cout << "  Производитель: " << manufacturer << std::endl;
+    std::cout << "  Статус: " << getStatus() << std::endl;
+    std::cout << "  Потребление: " << getPowerConsumption() << " Вт" << std::endl;
+    std::cout << "  Температура: " << currentTemperature << "°C (цель: " << targetTemperature << "°C)" << std::endl;
+    std::cout << "  Влажность: " << humidity << "%" << std::endl;
+    std::cout << "  Авторежим: " << (autoMode ? "ВКЛ" : "ВЫКЛ") << std::endl;
 }
 
 std::shared_ptr<ClimateDevice> ClimateDevice::deserialize(const std::string& data,
     std::shared_ptr<Room> location) {
-    try {
-        std::stringstream ss(data);
-        std::string id, name, manufacturer, typeStr, locationId, isOnStr, isOnlineStr,
-            powerStr, targetTempStr, currentTempStr, humidityStr, autoModeStr;
-
-        std::getline(ss, id, '|');
-        std::getline(ss, name, '|');
-        std::getline(ss, manufacturer, '|');
-        std::getline(ss, typeStr, '|');
-        std::getline(ss, locationId, '|');
-        std::getline(ss, isOnStr, '|');
-        std::getline(ss, isOnlineStr, '|');
-        std::getline(ss, powerStr, '|');
-        std::getline(ss, targetTempStr, '|');
-        std::getline(ss, currentTempStr, '|');
-        std::getline(ss, humidityStr, '|');
-        std::getline(ss, autoModeStr, '|');
-
-        auto device = std::make_shared<ClimateDevice>(id, name, manufacturer, location,
-            std::stod(powerStr), std::stod(targetTempStr));
-
-        device->setIsOnline(isOnlineStr == "1");
-        if (isOnStr == "1") device->turnOn();
-        device->setAutoMode(autoModeStr == "1");
-
-        return device;
+    DeviceFields fields(data);
+    std::shared_ptr<ClimateDevice> device;
+    if (fields.require(FIELD_COUNT)) {
+        device = fromFields(fields, location);
     }
-    catch (const std::exception& e) {
-        std::cerr << "   : " << e.what() << std::endl;
+    if (!device) {
+        std::cerr << "Ошибка десериализации климатического устройства: " << fields.errorText() << std::endl;
+    }
+    return device;
+}
+
+std::shared_ptr<ClimateDevice> ClimateDevice::fromFields(DeviceFields& fields,
+    std::shared_ptr<Room> location) {
+    double power = 0.0, target = 0.0, current = 0.0, humidity = 0.0;
+    if (!fields.getDouble(7, power) || !fields.getDouble(8, target) ||
+        !fields.getDouble(9, current) || !fields.getDouble(10, humidity)) {
         return nullptr;
     }
+
+    auto device = makePooled<ClimateDevice>(fields.text(0), fields.text(1), fields.text(2), location,
+        power, target);
+
+    // Состояние переносится напрямую: turnOn() сдвинул бы сохраненную температуру
+    device->restoreState(fields.flag(5), fields.flag(6));
+    device->currentTemperature = current;
+    device->humidity = humidity;
+    device->autoMode = fields.flag(11);
+
+    return device;
 }
\ No newline at end of file
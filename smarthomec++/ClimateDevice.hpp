@@ -1,11 +1,11 @@
-#ifndef CLIMATEDEVICE_HPP
+﻿#ifndef CLIMATEDEVICE_HPP
 #define CLIMATEDEVICE_HPP
 
 #include "device.hpp"
 #include <string>
 #include <memory>
 
-class ClimateDevice : public Device {
+class ClimateDevice final : public Device {
 private:
     double targetTemperature;
     double currentTemperature;
@@ -13,6 +13,9 @@ private:
     bool autoMode;
 
 public:
+    // Базовые поля + цель, текущая температура, влажность, авторежим
+    static const size_t FIELD_COUNT = 12;
+
     ClimateDevice(const std::string& id, const std::string& deviceName,
         const std::string& manuf, std::shared_ptr<Room> room,
         double power = 0.0, double targetTemp = 22.0);
@@ -40,11 +43,17 @@ public:
     double getHumidity() const;
     bool isAutoMode() const;
 
+    bool hasExtraState() const override;
+    void writeExtraState(BinaryWriter& out) const override;
+    bool readExtraState(BinaryReader& in) override;
+
     std::string serialize() const override;
     void displayInfo() const override;
 
     static std::shared_ptr<ClimateDevice> deserialize(const std::string& data,
         std::shared_ptr<Room> location);
+    static std::shared_ptr<ClimateDevice> fromFields(DeviceFields& fields,
+        std::shared_ptr<Room> location);
 };
 
 #endif
\ No newline at end of file
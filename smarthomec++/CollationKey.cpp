@@ -0,0 +1,38 @@
+﻿#include "CollationKey.hpp"
+#include "TextIndex.hpp"
+
+CollationKey::CollationKey() : head(0) {
+}
+
+namespace {
+    const uint8_t BELOW_CYRILLIC = 128;
+    const uint8_t ABOVE_CYRILLIC = 161;
+
+    // Вес символа в префиксе: ASCII и а-я - каждый свой, в порядке кодов;
+    // остальные символы делят общий вес со своими соседями по диапазону
+    uint8_t weight(char32_t symbol) {
+        if (symbol < 0x80) return static_cast<uint8_t>(symbol);
+        if (symbol < 0x0430) return BELOW_CYRILLIC;
+        if (symbol <= 0x044F) return static_cast<uint8_t>(129 + (symbol - 0x0430));
+        return ABOVE_CYRILLIC;
+    }
+}
+
+CollationKey::CollationKey(const std::string& text) : head(0), symbols(TextIndex::fold(text)) {
+    // Веса не убывают вместе с кодом символа, поэтому меньший префикс означает
+    // меньший ключ. После первого общего веса символы уже неразличимы, так что
+    // дальше префикс заполняется нулями, и такие ключи различает полное сравнение.
+    // Короткие названия тоже дополняются нулями и идут раньше своих продолжений
+    size_t packed = 0;
+    for (; packed < PREFIX_SYMBOLS && packed < symbols.size(); packed++) {
+        uint8_t value = weight(symbols[packed]);
+        head = (head << 8) | value;
+        if (value == BELOW_CYRILLIC || value == ABOVE_CYRILLIC) {
+            packed++;
+            break;
+        }
+    }
+    if (packed > 0 && packed < PREFIX_SYMBOLS) {
+        head <<= 8 * (PREFIX_SYMBOLS - packed);
+    }
+}
@@ -0,0 +1,100 @@
+﻿#ifndef COLLATIONKEY_HPP
+#define COLLATIONKEY_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+// Ключ сортировки названий.
+//
+// Строится один раз из названия через TextIndex::fold: UTF-8 или CP1251, без учета
+// регистра, "ё" равна "е", кириллица идет в порядке алфавита (после латиницы и
+// цифр). Первые PREFIX_SYMBOLS символов упакованы по байту в одно целое, поэтому
+// большинство сравнений - сравнение двух чисел; полный ключ нужен только при
+// равных префиксах. Владелец названия пересоздает ключ при переименовании
+class CollationKey {
+public:
+    static const size_t PREFIX_SYMBOLS = 8;
+
+private:
+    uint64_t head;              // по байту на символ, старшие - первые
+    std::u32string symbols;
+
+public:
+    CollationKey();
+    explicit CollationKey(const std::string& text);
+
+    uint64_t prefix() const {
+        return head;
+    }
+
+    // <0, 0, >0 как у std::string::compare
+    int compare(const CollationKey& other) const {
+        if (head != other.head) {
+            return head < other.head ? -1 : 1;
+        }
+        return symbols.compare(other.symbols);
+    }
+
+    bool operator<(const CollationKey& other) const {
+        return compare(other) < 0;
+    }
+
+    bool operator==(const CollationKey& other) const {
+        return head == other.head && symbols == other.symbols;
+    }
+
+    // Сортирует [first, last) по ключам keyOf(элемент) (const CollationKey&), равные -
+    // по less. Префиксы выписываются в непрерывный массив и сортируются как целые
+    // числа; затем полным сравнением досортировываются только группы с равными
+    // префиксами. С limit упорядочиваются лишь первые limit элементов.
+    // Ключ не должен лежать в самом элементе: элементы на время сортировки перемещаются
+    template <typename RandomIterator, typename KeyOf, typename Less>
+    static void sort(RandomIterator first, RandomIterator last, KeyOf keyOf, Less less,
+        size_t limit = static_cast<size_t>(-1)) {
+        using Value = typename std::iterator_traits<RandomIterator>::value_type;
+        struct Item {
+            uint64_t head;
+            const CollationKey* key;
+            Value value;
+        };
+        std::vector<Item> items;
+        items.reserve(static_cast<size_t>(last - first));
+        for (RandomIterator it = first; it != last; ++it) {
+            const CollationKey& key = keyOf(*it);
+            items.push_back(Item{ key.head, &key, std::move(*it) });
+        }
+        auto byKey = [&less](const Item& a, const Item& b) {
+            if (a.head != b.head) return a.head < b.head;
+            int compared = a.key->symbols.compare(b.key->symbols);
+            return compared != 0 ? compared < 0 : less(a.value, b.value);
+        };
+        if (limit < items.size()) {
+            std::partial_sort(items.begin(), items.begin() + limit, items.end(), byKey);
+        }
+        else {
+            std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+                return a.head < b.head;
+                });
+            for (auto run = items.begin(); run != items.end();) {
+                auto end = run + 1;
+                while (end != items.end() && end->head == run->head) {
+                    ++end;
+                }
+                if (end - run > 1) {
+                    std::sort(run, end, byKey);
+                }
+                run = end;
+            }
+        }
+        for (auto& item : items) {
+            *first++ = std::move(item.value);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,112 @@
+﻿#ifndef CURSOR_HPP
+#define CURSOR_HPP
+
+#include <string>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+
+// Постраничный обход списка (vector и подобных) без копирования.
+//
+// Записи выдаются в порядке контейнера, page() передает их в колбэк по ссылке.
+// Токен продолжения непрозрачен для вызывающего кода: в нем позиция следующей
+// записи, размер списка и ключ последней выданной (ключ уникален, например ID).
+// Между страницами список может меняться: добавленные в конец записи попадут в
+// следующие страницы, удаление уже выданных записей не сдвигает курсор - позиция
+// уточняется по ключу. Если удалена сама последняя выданная запись, курсор
+// отступает на число удаленных записей: часть строк может повториться, но без
+// одновременных добавлений ни одна не будет пропущена
+template <typename Container, typename KeyOf>
+class Cursor {
+private:
+    const Container& items;
+    KeyOf keyOf;
+    size_t pageSize;
+
+    // Токен: "позиция:размер:ключ"
+    static std::string encode(size_t position, size_t size, const std::string& key) {
+        return std::to_string(position) + ":" + std::to_string(size) + ":" + key;
+    }
+
+    static bool decodeNumber(const std::string& token, size_t from, size_t& value, size_t& next) {
+        size_t colon = token.find(':', from);
+        if (colon == from || colon == std::string::npos) return false;
+        char* end = nullptr;
+        unsigned long long parsed = std::strtoull(token.c_str() + from, &end, 10);
+        if (end != token.c_str() + colon) return false;
+        value = static_cast<size_t>(parsed);
+        next = colon + 1;
+        return true;
+    }
+
+    static bool decode(const std::string& token, size_t& position, size_t& size, std::string& key) {
+        size_t next = 0;
+        if (!decodeNumber(token, 0, position, next) || position == 0) return false;
+        if (!decodeNumber(token, next, size, next)) return false;
+        key = token.substr(next);
+        return true;
+    }
+
+    // Позиция, с которой продолжается обход после записи с ключом key
+    size_t resume(size_t position, size_t previousSize, const std::string& key) const {
+        size_t size = items.size();
+        if (position <= size && keyOf(items[position - 1]) == key) {
+            return position;
+        }
+        // Записи могли только сдвинуться влево
+        for (size_t i = (position < size ? position : size); i > 0; i--) {
+            if (keyOf(items[i - 1]) == key) {
+                return i;
+            }
+        }
+        size_t removed = previousSize > size ? previousSize - size : 1;
+        size_t result = removed < position ? position - removed : 0;
+        return result < size ? result : size;
+    }
+
+public:
+    Cursor(const Container& items, KeyOf keyOf, size_t pageSize)
+        : items(items), keyOf(keyOf), pageSize(pageSize > 0 ? pageSize : 1) {}
+
+    // Пустой токен - первая страница. func(номер, запись), номер - позиция в
+    // списке начиная с 1. Возвращает токен следующей страницы; пустой, если
+    // записей больше нет или токен некорректен
+    template <typename Func>
+    std::string page(const std::string& token, Func func) const {
+        size_t first = 0;
+        if (!token.empty()) {
+            size_t position = 0;
+            size_t previousSize = 0;
+            std::string key;
+            if (!decode(token, position, previousSize, key)) {
+                std::cerr << "Некорректный токен страницы: " << token << std::endl;
+                return "";
+            }
+            first = resume(position, previousSize, key);
+        }
+
+        size_t last = first + pageSize;
+        if (last > items.size()) {
+            last = items.size();
+        }
+        for (size_t i = first; i < last; i++) {
+            func(i + 1, items[i]);
+        }
+
+        if (last >= items.size() || last == first) {
+            return "";
+        }
+        return encode(last, items.size(), keyOf(items[last - 1]));
+    }
+
+    size_t getPageSize() const {
+        return pageSize;
+    }
+};
+
+template <typename Container, typename KeyOf>
+Cursor<Container, KeyOf> makeCursor(const Container& items, KeyOf keyOf, size_t pageSize) {
+    return Cursor<Container, KeyOf>(items, keyOf, pageSize);
+}
+
+#endif
@@ -1,75 +1,114 @@
 ﻿#include "device.hpp"
 #include "room.hpp"
+#include "BinaryIO.hpp"
+#include "DeviceStateTable.hpp"
+#include "ObjectPool.hpp"
 #include <sstream>
 #include <memory>
 #include <stdexcept>
 #include <iostream>
 #include <utility>
+#include <cmath>
 
-int Device::deviceCount = 0;
+std::atomic<int> Device::deviceCount(0);
+
+namespace {
+    SlotMap<Device>& slots() {
+        static SlotMap<Device> map;
+        return map;
+    }
+}
 
 Device::Device(const std::string& id, const std::string& deviceName,
     const std::string& manuf, DeviceType type,
     std::shared_ptr<Room> room, double power)
+    : Device(id, deviceName, manuf, type, room ? room->getHandle() : Handle<Room>(), power) {
+}
+
+Device::Device(const std::string& id, const std::string& deviceName,
+    const std::string& manuf, DeviceType type,
+    Handle<Room> room, double power)
     : BaseEntity(id, deviceName),
     manufacturer(manuf),
-    deviceType(type),
     location(room),
-    isOn(false),
-    isOnline(true),
-    powerConsumption(power) {
+    handle(slots().insert(this)) {
+    DeviceStateTable::instance().activate(handle.index, type, power);
     deviceCount++;
 }
 
 Device::Device(Device&& other) noexcept
-    : BaseEntity(std::move(other.id), std::move(other.name)),
-    manufacturer(std::move(other.manufacturer)),
-    deviceType(other.deviceType),
-    location(std::move(other.location)),
-    isOn(other.isOn),
-    isOnline(other.isOnline),
-    powerConsumption(other.powerConsumption) {
-    deviceCount++;
-
-    other.deviceType = DeviceType::SENSOR;
-    other.isOn = false;
-    other.isOnline = false;
-    other.powerConsumption = 0.0;
+    : Device(std::move(other.id), std::move(other.name), std::move(other.manufacturer),
+        other.getDeviceType(), other.location, other.getPowerConsumption()) {
+    copyState(other);
+    other.resetState();
 }
 
 Device::~Device() {
+    // Владелец выводит устройство из комнаты до удаления (deleteDevice, журнал);
+    // здесь - запасной путь для прочих владельцев. К этому моменту деструкторы
+    // подклассов уже отработали, но читатели комнаты закрепляют устройства через
+    // weak_from_this() и такое устройство не получат
+    DeviceStateTable& table = DeviceStateTable::instance();
+    Room* room = Room::atSlot(table.room(handle.index));
+    if (room) {
+        room->removeDevice(*this);
+    }
+    table.release(handle.index);
+    slots().erase(handle);
     deviceCount--;
 }
 
+void* Device::operator new(size_t size) {
+    return ObjectPool::allocate(size);
+}
+
+void Device::operator delete(void* pointer, size_t size) noexcept {
+    ObjectPool::deallocate(pointer, size);
+}
+
+void Device::setOnFlag(bool on) {
+    DeviceStateTable::instance().setOn(handle.index, on);
+}
+
+void Device::copyState(const Device& other) {
+    DeviceStateTable& table = DeviceStateTable::instance();
+    table.setType(handle.index, other.getDeviceType());
+    table.setPower(handle.index, other.getPowerConsumption());
+    table.setOn(handle.index, other.getIsOn());
+    table.setOnline(handle.index, other.getIsOnline());
+}
+
+void Device::resetState() {
+    DeviceStateTable& table = DeviceStateTable::instance();
+    table.setType(handle.index, DeviceType::SENSOR);
+    table.setPower(handle.index, 0.0);
+    table.setOn(handle.index, false);
+    table.setOnline(handle.index, false);
+}
+
 Device& Device::operator=(const Device& other) {
     if (this != &other) {
+        touch();
         this->id = other.id + "_assigned";
-        this->name = other.name + " (Assigned)";
+        rename(other.name + " (Assigned)");
         this->manufacturer = other.manufacturer;
-        this->deviceType = other.deviceType;
         this->location = other.location;
-        this->isOn = other.isOn;
-        this->isOnline = other.isOnline;
-        this->powerConsumption = other.powerConsumption;
+        copyState(other);
     }
     return *this;
 }
 
 Device& Device::operator=(Device&& other) noexcept {
     if (this != &other) {
+        touch();
         this->id = std::move(other.id);
         this->name = std::move(other.name);
+        this->nameKey = std::move(other.nameKey);
+        other.nameKey = CollationKey();
         this->manufacturer = std::move(other.manufacturer);
-        this->deviceType = other.deviceType;
         this->location = std::move(other.location);
-        this->isOn = other.isOn;
-        this->isOnline = other.isOnline;
-        this->powerConsumption = other.powerConsumption;
-
-        other.deviceType = DeviceType::SENSOR;
-        other.isOn = false;
-        other.isOnline = false;
-        other.powerConsumption = 0.0;
+        copyState(other);
+        other.resetState();
     }
     return *this;
 }
@@ -79,44 +118,46 @@ Device Device::operator+(double additionalPower) const {
         this->id + "_added",
         this->name + " (Power+)",
         this->manufacturer,
-        this->deviceType,
+        this->getDeviceType(),
         this->location,
-        this->powerConsumption + additionalPower
+        this->getPowerConsumption() + additionalPower
     );
-    newDevice.isOn = this->isOn;
-    newDevice.isOnline = this->isOnline;
+    newDevice.setOnFlag(this->getIsOn());
+    DeviceStateTable::instance().setOnline(newDevice.handle.index, this->getIsOnline());
 
     return newDevice;
 }
 
 bool Device::operator>(const Device& other) const {
-    return this->powerConsumption > other.powerConsumption;
+    return this->getPowerConsumption() > other.getPowerConsumption();
 }
 
 Device::operator std::string() const {
-    return this->name + " [" + this->manufacturer + "] - " + std::to_string(this->powerConsumption) + "W";
+    return this->name + " [" + this->manufacturer + "] - " + std::to_string(this->getPowerConsumption()) + "W";
 }
 
 void Device::turnOn() {
-    isOn = true;
+    touch();
+    setOnFlag(true);
 }
 
 void Device::turnOff() {
-    isOn = false;
+    touch();
+    setOnFlag(false);
 }
 
 std::string Device::getStatus() const {
-    return isOn ? "ВКЛ" : "ВЫКЛ";
+    return getIsOn() ? "ВКЛ" : "ВЫКЛ";
 }
 
 void Device::performSelfCheck() const {
     std::cout << "Выполнение базовой проверки устройства: " << name << std::endl;
-    std::cout << "  Статус: " << (isOnline ? "Онлайн" : "Офлайн") << std::endl;
-    std::cout << "  Питание: " << (isOn ? "ВКЛ" : "ВЫКЛ") << std::endl;
+    std::cout << "  Статус: " << (getIsOnline() ? "Онлайн" : "Офлайн") << std::endl;
+    std::cout << "  Питание: " << (getIsOn() ? "ВКЛ" : "ВЫКЛ") << std::endl;
 }
 
 double Device::calculateEfficiency() const {
-    return isOn ? powerConsumption : 0.0;
+    return getIsOn() ? getPowerConsumption() : 0.0;
 }
 
 std::string Device::getDetails() const {
@@ -133,37 +174,56 @@ Device* Device::clone() const {
         this->id + "_clone",
         this->name + " (Clone)",
         this->manufacturer,
-        this->deviceType,
+        this->getDeviceType(),
         this->location,
-        this->powerConsumption
+        this->getPowerConsumption()
     );
-    cloned->isOn = this->isOn;
-    cloned->isOnline = this->isOnline;
+    cloned->copyState(*this);
     return cloned;
 }
 
 void Device::updateCurrentValue(double value) {
-    try {
-        if (value < 0) {
-            throw std::invalid_argument("Потребляемая мощность не может быть отрицательной");
-        }
-        if (value > 10000) {
-            throw std::out_of_range("Слишком высокая мощность");
-        }
-        powerConsumption = value;
+    switch (applyReading(value)) {
+    case ReadingStatus::NEGATIVE:
+        std::cerr << "Ошибка: Потребляемая мощность не может быть отрицательной. Установлено значение 0." << std::endl;
+        break;
+    case ReadingStatus::TOO_HIGH:
+        std::cerr << "Ошибка: Слишком высокая мощность. Установлено максимальное значение 10000." << std::endl;
+        break;
+    case ReadingStatus::INVALID:
+        std::cerr << "Ошибка: Некорректное значение мощности. Значение не изменено." << std::endl;
+        break;
+    default:
+        break;
+    }
+}
+
+ReadingStatus Device::applyReading(double value) noexcept {
+    ReadingStatus status = clampReading(value);
+    if (status != ReadingStatus::INVALID) {
+        touch();
+        DeviceStateTable::instance().setPower(handle.index, value);
+    }
+    return status;
+}
+
+ReadingStatus Device::clampReading(double& value) noexcept {
+    if (!std::isfinite(value)) {
+        return ReadingStatus::INVALID;
     }
-    catch (const std::invalid_argument& e) {
-        std::cerr << "Ошибка: " << e.what() << ". Установлено значение 0." << std::endl;
-        powerConsumption = 0;
+    if (value < 0) {
+        value = 0;
+        return ReadingStatus::NEGATIVE;
     }
-    catch (const std::out_of_range& e) {
-        std::cerr << "Ошибка: " << e.what() << ". Установлено максимальное значение 10000." << std::endl;
-        powerConsumption = 10000;
+    if (value > MAX_POWER) {
+        value = MAX_POWER;
+        return ReadingStatus::TOO_HIGH;
     }
+    return ReadingStatus::OK;
 }
 
 std::string Device::getDeviceTypeString() const {
-    switch (deviceType) {
+    switch (getDeviceType()) {
     case DeviceType::SENSOR: return "Датчик";
     case DeviceType::ACTUATOR: return "Исполнительное устройство";
     case DeviceType::CLIMATE_CONTROL: return "Климат-контроль";
@@ -178,42 +238,82 @@ std::string Device::getManufacturer() const {
 }
 
 DeviceType Device::getDeviceType() const {
-    return deviceType;
+    return DeviceStateTable::instance().type(handle.index);
 }
 
-std::shared_ptr<Room> Device::getLocation() const {
+Room* Device::getLocation() const {
+    return Room::find(location);
+}
+
+Handle<Room> Device::getLocationHandle() const {
     return location;
 }
 
 bool Device::getIsOn() const {
-    return isOn;
+    return DeviceStateTable::instance().isOn(handle.index);
 }
 
 bool Device::getIsOnline() const {
-    return isOnline;
+    return DeviceStateTable::instance().isOnline(handle.index);
 }
 
 double Device::getPowerConsumption() const {
-    return powerConsumption;
+    return DeviceStateTable::instance().power(handle.index);
 }
 
 void Device::setPowerConsumption(double power) {
-    powerConsumption = power;
+    touch();
+    DeviceStateTable::instance().setPower(handle.index, power);
 }
 
 void Device::setIsOnline(bool online) {
-    isOnline = online;
+    touch();
+    DeviceStateTable::instance().setOnline(handle.index, online);
+}
+
+void Device::setLocation(const std::shared_ptr<Room>& newLocation) {
+    touch();
+    location = newLocation ? newLocation->getHandle() : Handle<Room>();
 }
 
-void Device::setLocation(std::shared_ptr<Room> newLocation) {
-    location = newLocation;
+void Device::assignRoom(Handle<Room> room) {
+    if (location == room) return;
+    touch();
+    location = room;
+}
+
+uint32_t Device::getStateIndex() const {
+    return handle.index;
+}
+
+Handle<Device> Device::getHandle() const {
+    return handle;
+}
+
+void Device::restoreState(bool on, bool online) {
+    touch();
+    setOnFlag(on);
+    DeviceStateTable::instance().setOnline(handle.index, online);
+}
+
+bool Device::hasExtraState() const {
+    return false;
+}
+
+void Device::writeExtraState(BinaryWriter&) const {
+}
+
+bool Device::readExtraState(BinaryReader&) {
+    touch();
+    return true;
 }
 
 std::string Device::serialize() const {
+    Room* room = getLocation();
     std::stringstream ss;
     ss << id << "|" << name << "|" << manufacturer << "|"
-        << static_cast<int>(deviceType) << "|" << (location ? location->getId() : "NULL") << "|"
-        << isOn << "|" << isOnline << "|" << powerConsumption;
+        << static_cast<int>(getDeviceType()) << "|" << (room ? room->getId() : "NULL") << "|"
+        << getIsOn() << "|" << getIsOnline() << "|" << getPowerConsumption();
     return ss.str();
 }
 
@@ -222,13 +322,21 @@ void Device::displayInfo() const {
     std::cout << "  Производитель: " << manufacturer << std::endl;
     std::cout << "  Тип: " << getDeviceTypeString() << std::endl;
     std::cout << "  Статус: " << getStatus() << std::endl;
-    std::cout << "  Потребление: " << powerConsumption << " Вт" << std::endl;
+    std::cout << "  Потребление: " << getPowerConsumption() << " Вт" << std::endl;
 }
 
 int Device::getDeviceCount() {
     return deviceCount;
 }
 
+Device* Device::find(Handle<Device> handle) {
+    return slots().get(handle);
+}
+
+Device* Device::atSlot(uint32_t index) {
+    return slots().at(index);
+}
+
 void validateDevice(const Device& device) {
     std::cout << "Проверка устройства:" << std::endl;
     std::cout << "  ID: " << device.id << std::endl;
@@ -237,7 +345,7 @@ void validateDevice(const Device& device) {
         std::cout << "  ВНИМАНИЕ: Устройство может быть тестовым!" << std::endl;
     }
 
-    if (device.powerConsumption > 1000) {
+    if (device.getPowerConsumption() > 1000) {
         std::cout << "  ВНИМАНИЕ: Высокое энергопотребление!" << std::endl;
     }
 
@@ -246,29 +354,20 @@ void validateDevice(const Device& device) {
 
 std::shared_ptr<Device> Device::deserialize(const std::string& data,
     std::shared_ptr<Room> location) {
-    try {
-        std::stringstream ss(data);
-        std::string id, name, manufacturer, typeStr, locationId, isOnStr, isOnlineStr, powerStr;
-
-        std::getline(ss, id, '|');
-        std::getline(ss, name, '|');
-        std::getline(ss, manufacturer, '|');
-        std::getline(ss, typeStr, '|');
-        std::getline(ss, locationId, '|');
-        std::getline(ss, isOnStr, '|');
-        std::getline(ss, isOnlineStr, '|');
-        std::getline(ss, powerStr, '|');
-
-        DeviceType type = static_cast<DeviceType>(std::stoi(typeStr));
-        auto device = std::make_shared<Device>(id, name, manufacturer, type, location, std::stod(powerStr));
-
-        device->setIsOnline(isOnlineStr == "1");
-        if (isOnStr == "1") device->turnOn();
-
-        return device;
-    }
-    catch (const std::exception& e) {
-        std::cerr << "Ошибка десериализации устройства: " << e.what() << std::endl;
+    DeviceFields fields(data);
+    return DeviceFactory::create(fields, location);
+}
+
+std::shared_ptr<Device> Device::fromFields(DeviceFields& fields,
+    std::shared_ptr<Room> location) {
+    int type = 0;
+    double power = 0.0;
+    if (!fields.getInt(3, type) || !fields.getDouble(7, power)) {
         return nullptr;
     }
+
+    auto device = makePooled<Device>(fields.text(0), fields.text(1), fields.text(2),
+        static_cast<DeviceType>(type), location, power);
+    device->restoreState(fields.flag(5), fields.flag(6));
+    return device;
 }
\ No newline at end of file
@@ -4,23 +4,63 @@
 #include <string>
 #include <memory>
 #include <stdexcept>
+#include <atomic>
+#include <cstdint>
 #include "deviceType.hpp"
 #include "BaseEntity.hpp"
+#include "DeviceFactory.hpp"
+#include "Versioned.hpp"
+#include "SlotMap.hpp"
 
 class Room;
+class BinaryWriter;
+class BinaryReader;
+
+// Результат проверки показания мощности
+enum class ReadingStatus {
+    OK,
+    NEGATIVE,       // заменено на 0
+    TOO_HIGH,       // заменено на MAX_POWER
+    INVALID         // NaN или бесконечность, не применяется
+};
 
-class Device : public BaseEntity {
+// enable_shared_from_this: комната не владеет устройствами и выдает их читателям
+// через weak_from_this().lock(), пропуская те, чье удаление уже началось
+class Device : public BaseEntity, public Versioned<Device>,
+    public std::enable_shared_from_this<Device> {
 protected:
     std::string manufacturer;
-    DeviceType deviceType;
-    std::shared_ptr<Room> location;
-    bool isOn;
-    bool isOnline;
-    double powerConsumption;
+    // Комната хранится дескриптором: владеют комнатами система и реестр, а
+    // shared_ptr в обе стороны (комната <-> устройство) давал цикл ссылок
+    Handle<Room> location;
+    // Индекс слота общий для Device::slots() и DeviceStateTable (тип, мощность,
+    // флаги вкл/онлайн)
+    Handle<Device> handle;
+
+    // Устройства создаются и в потоках загрузчика
+    static std::atomic<int> deviceCount;
+
+    // Запись флага без touch(): вызывающий метод отмечает изменение сам
+    void setOnFlag(bool on);
+    // Копирование состояния из слота другого устройства и сброс своего
+    void copyState(const Device& other);
+    void resetState();
+
+    // Room::attach записывает комнату сюда вместе с колонкой комнаты в
+    // DeviceStateTable, чтобы getLocation() и список комнаты не расходились
+    friend class Room;
+    void assignRoom(Handle<Room> room);
 
-    static int deviceCount;
+    Device(const std::string& id, const std::string& deviceName,
+        const std::string& manuf, DeviceType type,
+        Handle<Room> room, double power);
 
 public:
+    // Число полей в строке serialize() базового устройства
+    static const size_t FIELD_COUNT = 8;
+    // Верхняя граница показания мощности, Вт
+    static constexpr double MAX_POWER = 10000.0;
+
     Device(const std::string& id, const std::string& deviceName,
         const std::string& manuf, DeviceType type,
         std::shared_ptr<Room> room, double power = 0.0);
@@ -29,16 +69,24 @@ public:
     Device(Device&& other) noexcept;
     virtual ~Device();
 
+    // Устройства и подклассы, созданные через new (clone()), размещаются в ObjectPool;
+    // для shared_ptr - makePooled вместо make_shared
+    static void* operator new(size_t size);
+    static void operator delete(void* pointer, size_t size) noexcept;
+
+    // Присваивание меняет ID, название и производителя. Индексы реестра и
+    // DeviceManager по ним не перестраиваются: присваивать можно только
+    // устройству, которое еще не добавлено ни в реестр, ни в менеджер
     Device& operator=(const Device& other);
     Device& operator=(Device&& other) noexcept;
 
-    //    
+    // Операторы сравнения для сортировки
     bool operator<(const Device& other) const {
-        return this->powerConsumption < other.powerConsumption;
+        return this->getPowerConsumption() < other.getPowerConsumption();
     }
 
     Device operator+(double additionalPower) const;
-    bool operator>(const Device& other) const;  // 
+    bool operator>(const Device& other) const;  // Объявление
     explicit operator std::string() const;
 
     virtual void turnOn();
@@ -53,25 +101,47 @@ public:
     virtual Device* clone() const override;
 
     void updateCurrentValue(double value);
+    // То же без вывода ошибок и исключений (пакетное применение телеметрии)
+    ReadingStatus applyReading(double value) noexcept;
+    // Приводит показание к допустимому диапазону
+    static ReadingStatus clampReading(double& value) noexcept;
     std::string getDeviceTypeString() const;
     std::string getManufacturer() const;
     DeviceType getDeviceType() const;
-    std::shared_ptr<Room> getLocation() const;
+    // Комната по дескриптору; nullptr, если не задана или уже удалена
+    Room* getLocation() const;
+    Handle<Room> getLocationHandle() const;
     bool getIsOn() const;
     bool getIsOnline() const;
     double getPowerConsumption() const;
     void setPowerConsumption(double power);
     void setIsOnline(bool online);
-    void setLocation(std::shared_ptr<Room> newLocation);
+    void setLocation(const std::shared_ptr<Room>& newLocation);
+    uint32_t getStateIndex() const;
+    Handle<Device> getHandle() const;
+
+    // Восстановление состояния при загрузке без побочных эффектов turnOn()/turnOff()
+    void restoreState(bool on, bool online);
+
+    // Дополнительное состояние подкласса в бинарном снимке
+    virtual bool hasExtraState() const;
+    virtual void writeExtraState(BinaryWriter& out) const;
+    virtual bool readExtraState(BinaryReader& in);
 
     std::string serialize() const override;
     void displayInfo() const override;
 
     static int getDeviceCount();
+    // Живое устройство по дескриптору или по индексу слота; nullptr, если удалено
+    static Device* find(Handle<Device> handle);
+    static Device* atSlot(uint32_t index);
     friend void validateDevice(const Device& device);
 
+    // Создает подкласс по полю типа через DeviceFactory
     static std::shared_ptr<Device> deserialize(const std::string& data,
         std::shared_ptr<Room> location);
+    static std::shared_ptr<Device> fromFields(DeviceFields& fields,
+        std::shared_ptr<Room> location);
 };
 
 #endif
\ No newline at end of file
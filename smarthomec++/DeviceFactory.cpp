@@ -0,0 +1,107 @@
+﻿#include "DeviceFactory.hpp"
+#include "Device.hpp"
+#include "ClimateDevice.hpp"
+#include "SecurityDevice.hpp"
+#include "Room.hpp"
+#include "EntityRegistry.hpp"
+#include "ObjectPool.hpp"
+#include <iostream>
+
+namespace {
+
+std::shared_ptr<Device> climateFromFields(DeviceFields& fields, std::shared_ptr<Room> location) {
+    return ClimateDevice::fromFields(fields, location);
+}
+
+std::shared_ptr<Device> securityFromFields(DeviceFields& fields, std::shared_ptr<Room> location) {
+    return SecurityDevice::fromFields(fields, location);
+}
+
+std::shared_ptr<Device> blankClimate(const std::string& id, const std::string& name,
+    const std::string& manufacturer, std::shared_ptr<Room> location, double power) {
+    return makePooled<ClimateDevice>(id, name, manufacturer, location, power);
+}
+
+std::shared_ptr<Device> blankSecurity(const std::string& id, const std::string& name,
+    const std::string& manufacturer, std::shared_ptr<Room> location, double power) {
+    return makePooled<SecurityDevice>(id, name, manufacturer, location, power);
+}
+
+} // namespace
+
+std::map<DeviceType, DeviceFactory::Registration>& DeviceFactory::registrations() {
+    // Встроенные подклассы регистрируются при первом обращении
+    static std::map<DeviceType, Registration> entries = {
+        { DeviceType::CLIMATE_CONTROL, { ClimateDevice::FIELD_COUNT, climateFromFields, blankClimate } },
+        { DeviceType::SECURITY, { SecurityDevice::FIELD_COUNT, securityFromFields, blankSecurity } }
+    };
+    return entries;
+}
+
+void DeviceFactory::registerType(DeviceType type, size_t minFields, FieldsCreator fromFields, BlankCreator blank) {
+    registrations()[type] = { minFields, fromFields, blank };
+}
+
+std::shared_ptr<Device> DeviceFactory::create(const std::string& line, const EntityRegistry& registry) {
+    DeviceFields fields(line);
+    if (!fields.require(Device::FIELD_COUNT)) {
+        std::cerr << "Ошибка десериализации устройства: " << fields.errorText() << std::endl;
+        return nullptr;
+    }
+
+    auto location = registry.findRoom(fields.text(LOCATION_FIELD));
+    if (!location) {
+        return nullptr;
+    }
+
+    return create(fields, location);
+}
+
+DeviceFactory::PendingDevice DeviceFactory::parse(const std::string& line) {
+    DeviceFields fields(line);
+    PendingDevice pending;
+    pending.device = create(fields, nullptr);
+    if (pending.device) {
+        pending.roomId = fields.text(LOCATION_FIELD);
+    }
+    return pending;
+}
+
+std::shared_ptr<Device> DeviceFactory::create(DeviceFields& fields, std::shared_ptr<Room> location) {
+    int type = 0;
+    std::shared_ptr<Device> device;
+    if (fields.require(Device::FIELD_COUNT) && fields.getInt(TYPE_FIELD, type)) {
+        auto& entries = registrations();
+        auto it = entries.find(static_cast<DeviceType>(type));
+        if (it == entries.end()) {
+            device = Device::fromFields(fields, location);
+        }
+        else if (fields.size() >= it->second.minFields) {
+            device = it->second.fromFields(fields, location);
+        }
+        else {
+            // Устройство было сохранено как базовое: подкласс с состоянием по умолчанию,
+            // как и при загрузке снимка версии 1
+            double power = 0.0;
+            if (fields.getDouble(7, power)) {
+                device = it->second.blank(fields.text(0), fields.text(1), fields.text(2), location, power);
+                device->restoreState(fields.flag(5), fields.flag(6));
+            }
+        }
+    }
+
+    if (!device) {
+        std::cerr << "Ошибка десериализации устройства: " << fields.errorText() << std::endl;
+    }
+    return device;
+}
+
+std::shared_ptr<Device> DeviceFactory::createBlank(DeviceType type, const std::string& id, const std::string& name,
+    const std::string& manufacturer, std::shared_ptr<Room> location, double power) {
+    auto& entries = registrations();
+    auto it = entries.find(type);
+    if (it != entries.end()) {
+        return it->second.blank(id, name, manufacturer, location, power);
+    }
+    return makePooled<Device>(id, name, manufacturer, type, location, power);
+}
@@ -0,0 +1,66 @@
+﻿#ifndef DEVICEFACTORY_HPP
+#define DEVICEFACTORY_HPP
+
+#include <string>
+#include <memory>
+#include <map>
+#include "DeviceType.hpp"
+#include "FieldTokenizer.hpp"
+
+class Device;
+class Room;
+class EntityRegistry;
+
+// Поля сериализованной строки устройства (разделитель '|')
+typedef FieldTokenizer DeviceFields;
+
+// Фабрика устройств с регистрацией по типу из сериализованной строки.
+//
+// Строка разбивается на поля один раз, без копирования; по полю типа (индекс 3) выбирается
+// зарегистрированный подкласс. Если подкласс не зарегистрирован, создается обычный
+// Device; если в строке нет дополнительных полей подкласса (устройство было
+// сохранено как базовое), они получают значения по умолчанию
+class DeviceFactory {
+public:
+    // Создание из разобранных полей (текстовый формат)
+    typedef std::shared_ptr<Device>(*FieldsCreator)(DeviceFields& fields, std::shared_ptr<Room> location);
+    // Создание "пустого" объекта подкласса, состояние которого затем читается из снимка
+    typedef std::shared_ptr<Device>(*BlankCreator)(const std::string& id, const std::string& name,
+        const std::string& manufacturer, std::shared_ptr<Room> location, double power);
+
+    static const size_t TYPE_FIELD = 3;
+    static const size_t LOCATION_FIELD = 4;
+
+    // Устройство, разобранное до загрузки комнат; комната привязывается позже по roomId
+    struct PendingDevice {
+        std::shared_ptr<Device> device;
+        std::string roomId;
+
+        explicit operator bool() const { return device != nullptr; }
+    };
+
+    static void registerType(DeviceType type, size_t minFields, FieldsCreator fromFields, BlankCreator blank);
+
+    // Разбор строки с поиском комнаты в реестре; nullptr, если комната не найдена.
+    // Устройство в комнату не добавляется - это делает вызывающий код,
+    // поэтому метод можно вызывать из нескольких потоков
+    static std::shared_ptr<Device> create(const std::string& line, const EntityRegistry& registry);
+    // Ошибка разбора выводится с номером поля; возвращается nullptr
+    static std::shared_ptr<Device> create(DeviceFields& fields, std::shared_ptr<Room> location);
+    // Разбор без реестра: не ждет загрузки комнат
+    static PendingDevice parse(const std::string& line);
+
+    static std::shared_ptr<Device> createBlank(DeviceType type, const std::string& id, const std::string& name,
+        const std::string& manufacturer, std::shared_ptr<Room> location, double power);
+
+private:
+    struct Registration {
+        size_t minFields;
+        FieldsCreator fromFields;
+        BlankCreator blank;
+    };
+
+    static std::map<DeviceType, Registration>& registrations();
+};
+
+#endif
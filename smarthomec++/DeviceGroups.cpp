@@ -0,0 +1,93 @@
+﻿#include "DeviceGroups.hpp"
+#include "DeviceStateTable.hpp"
+#include <typeinfo>
+#include <algorithm>
+
+namespace {
+
+// T - точный класс устройств группы: вызов T:: не проходит через vtable
+template <typename T>
+double efficiencyOfGroup(const std::vector<T*>& group) {
+    double total = 0.0;
+    for (const T* device : group) {
+        total += device->T::calculateEfficiency();
+    }
+    return total;
+}
+
+template <typename T>
+bool eraseFromGroup(std::vector<T*>& group, const Device* device) {
+    auto it = std::find(group.begin(), group.end(), device);
+    if (it == group.end()) {
+        return false;
+    }
+    *it = group.back();
+    group.pop_back();
+    return true;
+}
+
+} // namespace
+
+DeviceGroups::DeviceGroups(const std::vector<std::shared_ptr<Device>>& devices) {
+    assign(devices);
+}
+
+void DeviceGroups::assign(const std::vector<std::shared_ptr<Device>>& devices) {
+    clear();
+    for (const auto& device : devices) {
+        add(device.get());
+    }
+}
+
+void DeviceGroups::add(Device* device) {
+    const std::type_info& type = typeid(*device);
+    if (type == typeid(Device)) {
+        plain.push_back(device);
+        plainSlots.push_back(device->getStateIndex());
+    }
+    else if (type == typeid(ClimateDevice)) {
+        climate.push_back(static_cast<ClimateDevice*>(device));
+    }
+    else if (type == typeid(SecurityDevice)) {
+        security.push_back(static_cast<SecurityDevice*>(device));
+    }
+    else {
+        other.push_back(device);
+    }
+}
+
+bool DeviceGroups::remove(const Device* device) {
+    auto it = std::find(plain.begin(), plain.end(), device);
+    if (it != plain.end()) {
+        size_t position = it - plain.begin();
+        plain[position] = plain.back();
+        plainSlots[position] = plainSlots.back();
+        plain.pop_back();
+        plainSlots.pop_back();
+        return true;
+    }
+    return eraseFromGroup(climate, device) || eraseFromGroup(security, device)
+        || eraseFromGroup(other, device);
+}
+
+void DeviceGroups::clear() {
+    plain.clear();
+    plainSlots.clear();
+    climate.clear();
+    security.clear();
+    other.clear();
+}
+
+size_t DeviceGroups::size() const {
+    return plain.size() + climate.size() + security.size() + other.size();
+}
+
+double DeviceGroups::totalEfficiency() const {
+    // Device::calculateEfficiency - мощность включенного устройства
+    double total = DeviceStateTable::instance().activePowerOf(plainSlots)
+        + efficiencyOfGroup(climate) + efficiencyOfGroup(security);
+    for (const Device* device : other) {
+        total += device->calculateEfficiency();
+    }
+    return total;
+}
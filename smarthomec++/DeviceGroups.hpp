@@ -0,0 +1,55 @@
+﻿#ifndef DEVICEGROUPS_HPP
+#define DEVICEGROUPS_HPP
+
+#include <vector>
+#include <memory>
+#include "Device.hpp"
+#include "ClimateDevice.hpp"
+#include "SecurityDevice.hpp"
+
+// Устройства, разложенные по конкретным классам для массовых обходов.
+//
+// Класс определяется один раз при добавлении (typeid). Дальше каждая группа
+// обходится своим циклом: ClimateDevice и SecurityDevice объявлены final, поэтому
+// их методы вызываются без таблицы виртуальных функций и встраиваются, а для
+// группы базовых Device totalEfficiency берет мощность включенных прямо из
+// DeviceStateTable без обращения к объектам. Подклассы, зарегистрированные вне
+// этого файла, попадают в группу other с обычным виртуальным вызовом.
+//
+// Группы хранят невладеющие указатели: ими владеет исходный список устройств,
+// и удаляемое из него устройство убирается и отсюда (remove)
+class DeviceGroups {
+private:
+    std::vector<Device*> plain;             // ровно Device
+    std::vector<uint32_t> plainSlots;       // их слоты в DeviceStateTable
+    std::vector<ClimateDevice*> climate;
+    std::vector<SecurityDevice*> security;
+    std::vector<Device*> other;
+
+public:
+    DeviceGroups() {}
+    explicit DeviceGroups(const std::vector<std::shared_ptr<Device>>& devices);
+
+    void assign(const std::vector<std::shared_ptr<Device>>& devices);
+    void add(Device* device);
+    // Последнее устройство группы занимает место удаленного; false, если его нет
+    bool remove(const Device* device);
+    void clear();
+    size_t size() const;
+
+    // kernel вызывается для каждого устройства со ссылкой его группы:
+    // Device&, ClimateDevice&, SecurityDevice&, затем Device& для прочих.
+    // Обобщенная лямбда ([](auto& device) {...}) получает отдельный цикл на каждый класс
+    template <typename Kernel>
+    void forEach(Kernel kernel) const {
+        for (Device* device : plain) kernel(*device);
+        for (ClimateDevice* device : climate) kernel(*device);
+        for (SecurityDevice* device : security) kernel(*device);
+        for (Device* device : other) kernel(*device);
+    }
+
+    // Сумма calculateEfficiency() по всем устройствам
+    double totalEfficiency() const;
+};
+
+#endif
@@ -6,52 +6,337 @@
 #include <iostream>
 #include <functional>
 #include <iterator>
+#include <string>
+#include <set>
+#include <utility>
+#include <unordered_map>
+#include <unordered_set>
 #include "device.hpp"
 #include "BaseEntity.hpp"
+#include "DeviceStateTable.hpp"
+#include "Parallel.hpp"
+#include "Cursor.hpp"
 
-//      
+// Шаблонный класс для управления коллекцией устройств.
+//
+// Позиция каждого устройства хранится по его слоту DeviceStateTable, поэтому
+// удаление - O(1): последнее устройство списка занимает место удаленного.
+//
+// По умолчанию поиск - линейный проход. enableIndexes() включает вторичные индексы:
+// хеш по названию и производителю, корзины по типу и упорядоченные индексы по
+// мощности и названию (сортированные представления для forEachByPower/forEachByName:
+// список выводится по порядку без копирования и сортировки, порядок хранения не
+// меняется). Они обновляются при добавлении и удалении, а изменения мощности и типа
+// приходят из DeviceStateTable (StateObserver). Название и производитель
+// индексируются при добавлении и дальше не перестраиваются: устройству из
+// менеджера нельзя присваивать другое (Device::operator= меняет оба поля).
+// Менеджер используется из одного потока.
+//
+// Перегрузки с Execution выполняют сплошной проход по списку и сортировку на
+// нескольких ядрах (Parallel); с Execution::AUTO меньшие списки обрабатываются
+// последовательно. Перегрузки без Execution используют AUTO: их предикаты только
+// читают устройства. Включенные индексы по-прежнему заменяют проход
 template<typename T>
 class DeviceManager {
 private:
+    // Вторичные индексы по слотам DeviceStateTable
+    class Indexes : public StateObserver {
+    public:
+        std::unordered_multimap<std::string, uint32_t> byName;
+        std::unordered_multimap<std::string, uint32_t> byManufacturer;
+        std::unordered_set<uint32_t> byType[PowerSummary::TYPE_COUNT];
+        std::set<std::pair<double, uint32_t>> byPower;
+        std::set<std::pair<CollationKey, uint32_t>> byNameOrder;
+        // Позиции менеджера: результаты выдаются в порядке devices
+        const std::unordered_map<uint32_t, size_t>& positions;
+
+        explicit Indexes(const std::unordered_map<uint32_t, size_t>& owner) : positions(owner) {}
+
+        static void eraseFrom(std::unordered_multimap<std::string, uint32_t>& index,
+            const std::string& key, uint32_t slot) {
+            auto range = index.equal_range(key);
+            for (auto it = range.first; it != range.second; ++it) {
+                if (it->second == slot) {
+                    index.erase(it);
+                    return;
+                }
+            }
+        }
+
+        void insert(const T& device) {
+            uint32_t slot = device.getStateIndex();
+            byName.emplace(device.getName(), slot);
+            byManufacturer.emplace(device.getManufacturer(), slot);
+            size_t type = static_cast<size_t>(device.getDeviceType());
+            if (type < PowerSummary::TYPE_COUNT) {
+                byType[type].insert(slot);
+            }
+            byPower.emplace(device.getPowerConsumption(), slot);
+            byNameOrder.emplace(device.getNameKey(), slot);
+        }
+
+        void erase(const T& device) {
+            uint32_t slot = device.getStateIndex();
+            eraseFrom(byName, device.getName(), slot);
+            eraseFrom(byManufacturer, device.getManufacturer(), slot);
+            size_t type = static_cast<size_t>(device.getDeviceType());
+            if (type < PowerSummary::TYPE_COUNT) {
+                byType[type].erase(slot);
+            }
+            byPower.erase(std::make_pair(device.getPowerConsumption(), slot));
+            byNameOrder.erase(std::make_pair(device.getNameKey(), slot));
+        }
+
+        void powerChanged(uint32_t index, double before, double after) override {
+            if (positions.find(index) == positions.end()) return;
+            byPower.erase(std::make_pair(before, index));
+            byPower.emplace(after, index);
+        }
+
+        void typeChanged(uint32_t index, DeviceType before, DeviceType after) override {
+            if (positions.find(index) == positions.end()) return;
+            size_t from = static_cast<size_t>(before);
+            size_t to = static_cast<size_t>(after);
+            if (from < PowerSummary::TYPE_COUNT) byType[from].erase(index);
+            if (to < PowerSummary::TYPE_COUNT) byType[to].insert(index);
+        }
+    };
+
     std::vector<std::shared_ptr<T>> devices;
+    // Слоты DeviceStateTable в том же порядке, что и devices: агрегаты не обходят объекты
+    std::vector<uint32_t> stateIndices;
+    // Слот -> позиция в devices: удаление по слоту за O(1)
+    std::unordered_map<uint32_t, size_t> positions;
     std::string managerName;
+    std::unique_ptr<Indexes> indexes;
+
+    // Планировщик запросов читает индексы напрямую
+    template<typename> friend class DeviceQuery;
+
+    // Обновляет слоты и позиции устройств, начиная с first (после сдвига или
+    // перестановки хвоста списка); записи остальных не трогаются
+    void renumberFrom(size_t first) {
+        stateIndices.resize(devices.size());
+        for (size_t i = first; i < devices.size(); ++i) {
+            stateIndices[i] = devices[i]->getStateIndex();
+            positions[stateIndices[i]] = i;
+        }
+    }
+
+    // Устройства слотов в порядке devices
+    std::vector<std::shared_ptr<T>> inDeviceOrder(std::vector<size_t>& found) const {
+        std::sort(found.begin(), found.end());
+        std::vector<std::shared_ptr<T>> result;
+        result.reserve(found.size());
+        for (size_t position : found) {
+            result.push_back(devices[position]);
+        }
+        return result;
+    }
+
+    // Первое в порядке devices устройство с ключом key
+    std::shared_ptr<T> firstByKey(const std::unordered_multimap<std::string, uint32_t>& index,
+        const std::string& key) const {
+        auto range = index.equal_range(key);
+        size_t best = devices.size();
+        for (auto it = range.first; it != range.second; ++it) {
+            best = (std::min)(best, positions.at(it->second));
+        }
+        return best < devices.size() ? devices[best] : nullptr;
+    }
+
+    // Позиции devices, упорядоченные по key, без перестановки самого списка
+    template <typename Key>
+    std::vector<size_t> orderedPositions(Key key) const {
+        std::vector<size_t> order(devices.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [this, &key](size_t a, size_t b) {
+            return key(*devices[a]) < key(*devices[b]);
+            });
+        return order;
+    }
+
+    // Устройства диапазона byPower в порядке обхода
+    template <typename Iterator>
+    std::vector<std::shared_ptr<T>> collect(Iterator first, Iterator last) const {
+        std::vector<std::shared_ptr<T>> result;
+        for (; first != last; ++first) {
+            result.push_back(devices[positions.at(first->second)]);
+        }
+        return result;
+    }
 
 public:
     DeviceManager(const std::string& name) : managerName(name) {}
 
-    //     
+    ~DeviceManager() {
+        disableIndexes();
+    }
+
+    // Индексы подписаны на DeviceStateTable по адресу менеджера
+    DeviceManager(const DeviceManager&) = delete;
+    DeviceManager& operator=(const DeviceManager&) = delete;
+
+    // Построение индексов за O(n log n); дальше они ведутся инкрементально
+    void enableIndexes() {
+        if (indexes) return;
+        indexes.reset(new Indexes(positions));
+        for (const auto& device : devices) {
+            indexes->insert(*device);
+        }
+        DeviceStateTable::instance().addObserver(indexes.get());
+    }
+
+    void disableIndexes() {
+        if (!indexes) return;
+        DeviceStateTable::instance().removeObserver(indexes.get());
+        indexes.reset();
+    }
+
+    bool hasIndexes() const {
+        return indexes != nullptr;
+    }
+
+    // Шаблонный метод для добавления устройства
     template<typename U>
     void addDevice(U&& device) {
         devices.push_back(std::forward<U>(device));
-        //  : std::cout << "   : " << managerName << std::endl;
+        stateIndices.push_back(devices.back()->getStateIndex());
+        positions[stateIndices.back()] = devices.size() - 1;
+        if (indexes) {
+            indexes->insert(*devices.back());
+        }
+        // УБРАЛИ ВЫВОД: std::cout << "Устройство добавлено в менеджер: " << managerName << std::endl;
     }
 
-    //   
-    void removeDevice(const std::string& deviceId) {
-        auto it = std::remove_if(devices.begin(), devices.end(),
+    // Замена всего списка без вывода сообщений (например, после загрузки)
+    void assignDevices(const std::vector<std::shared_ptr<T>>& list) {
+        bool indexed = hasIndexes();
+        disableIndexes();
+        devices = list;
+        positions.clear();
+        positions.reserve(devices.size());
+        renumberFrom(0);
+        if (indexed) {
+            enableIndexes();
+        }
+    }
+
+    // Удаление без вывода сообщений за O(1): позиция находится по слоту устройства,
+    // последнее устройство списка занимает место удаленного (как в Room).
+    // false, если устройства нет в менеджере
+    bool detachDevice(const T& device) {
+        auto found = positions.find(device.getStateIndex());
+        if (found == positions.end()) {
+            return false;
+        }
+        size_t position = found->second;
+        if (indexes) {
+            indexes->erase(device);
+        }
+        positions.erase(found);
+        size_t last = devices.size() - 1;
+        if (position != last) {
+            devices[position] = std::move(devices[last]);
+            stateIndices[position] = stateIndices[last];
+            positions[stateIndices[position]] = position;
+        }
+        devices.pop_back();
+        stateIndices.pop_back();
+        return true;
+    }
+
+    // По ID устройство сначала ищется проходом; при известном объекте дешевле detachDevice(device)
+    bool detachDevice(const std::string& deviceId) {
+        auto it = std::find_if(devices.begin(), devices.end(),
             [&deviceId](const std::shared_ptr<T>& device) {
                 return device->getId() == deviceId;
             });
-        if (it != devices.end()) {
-            devices.erase(it, devices.end());
-            std::cout << " " << deviceId << " " << std::endl;
+        if (it == devices.end()) {
+            return false;
+        }
+        std::shared_ptr<T> device = *it;
+        return detachDevice(*device);
+    }
+
+    // Не шаблонный метод
+    void removeDevice(const std::string& deviceId) {
+        if (detachDevice(deviceId)) {
+            std::cout << "Устройство " << deviceId << " удалено" << std::endl;
         }
         else {
-            std::cout << "  " << std::endl;
+            std::cout << "Устройство не найдено" << std::endl;
         }
     }
 
-    //       (STL  sort)
+    // Обход по мощности (func получает const std::shared_ptr<T>&). С индексами -
+    // по упорядоченному индексу за O(n), без индексов - через сортировку позиций;
+    // порядок devices в обоих случаях не меняется
+    template <typename Func>
+    void forEachByPower(bool ascending, Func func) const {
+        if (indexes) {
+            if (ascending) {
+                for (const auto& entry : indexes->byPower) {
+                    func(devices[positions.at(entry.second)]);
+                }
+            }
+            else {
+                for (auto it = indexes->byPower.rbegin(); it != indexes->byPower.rend(); ++it) {
+                    func(devices[positions.at(it->second)]);
+                }
+            }
+            return;
+        }
+        std::vector<size_t> order = orderedPositions([](const T& device) { return device.getPowerConsumption(); });
+        if (!ascending) {
+            std::reverse(order.begin(), order.end());
+        }
+        for (size_t position : order) {
+            func(devices[position]);
+        }
+    }
+
+    // Обход по названию в порядке возрастания (по ключам сортировки, без учета регистра)
+    template <typename Func>
+    void forEachByName(Func func) const {
+        if (indexes) {
+            for (const auto& entry : indexes->byNameOrder) {
+                func(devices[positions.at(entry.second)]);
+            }
+            return;
+        }
+        std::vector<size_t> order(devices.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        CollationKey::sort(order.begin(), order.end(),
+            [this](size_t position) -> const CollationKey& { return devices[position]->getNameKey(); },
+            std::less<size_t>());
+        for (size_t position : order) {
+            func(devices[position]);
+        }
+    }
+
+    // Метод для сортировки устройств по потреблению (STL алгоритм sort)
     void sortByPowerConsumption() {
-        std::sort(devices.begin(), devices.end(),
+        sortByPowerConsumption(Execution::AUTO);
+    }
+
+    void sortByPowerConsumption(Execution policy) {
+        Parallel::sort(policy, devices.begin(), devices.end(),
             [](const std::shared_ptr<T>& a, const std::shared_ptr<T>& b) {
                 return a->getPowerConsumption() < b->getPowerConsumption();
             });
-        //  : std::cout << "    " << std::endl;
+        // Ключи positions не меняются, поэтому таблица не перестраивается
+        renumberFrom(0);
+        // УБРАЛИ ВЫВОД: std::cout << "Устройства отсортированы по потреблению энергии" << std::endl;
     }
 
-    //       (STL  find_if)
+    // Метод для поиска устройства по имени (STL алгоритм find_if)
     std::shared_ptr<T> findDeviceByName(const std::string& name) const {
+        if (indexes) return firstByKey(indexes->byName, name);
         auto it = std::find_if(devices.begin(), devices.end(),
             [&name](const std::shared_ptr<T>& device) {
                 return device->getName() == name;
@@ -59,74 +344,125 @@ public:
         return (it != devices.end()) ? *it : nullptr;
     }
 
-    //       (STL  copy_if)
+    // Метод для поиска устройств по типу (STL алгоритм copy_if)
     std::vector<std::shared_ptr<T>> findDevicesByType(DeviceType type) const {
-        std::vector<std::shared_ptr<T>> result;
-        std::copy_if(devices.begin(), devices.end(), std::back_inserter(result),
+        return findDevicesByType(Execution::AUTO, type);
+    }
+
+    std::vector<std::shared_ptr<T>> findDevicesByType(Execution policy, DeviceType type) const {
+        size_t bucket = static_cast<size_t>(type);
+        if (indexes && bucket < PowerSummary::TYPE_COUNT) {
+            std::vector<size_t> found;
+            found.reserve(indexes->byType[bucket].size());
+            for (uint32_t slot : indexes->byType[bucket]) {
+                found.push_back(positions.at(slot));
+            }
+            return inDeviceOrder(found);
+        }
+        return Parallel::copyIf(policy, devices.begin(), devices.end(),
             [type](const std::shared_ptr<T>& device) {
                 return device->getDeviceType() == type;
             });
-        return result;
     }
 
-    //        (STL  max_element)
+    // Устройство с максимальным потреблением (первое из равных, как max_element)
     std::shared_ptr<T> getMaxPowerDevice() const {
         if (devices.empty()) return nullptr;
-        auto it = std::max_element(devices.begin(), devices.end(),
-            [](const std::shared_ptr<T>& a, const std::shared_ptr<T>& b) {
-                return a->getPowerConsumption() < b->getPowerConsumption();
-            });
-        return *it;
+        PowerSummary summary = getSummary();
+        return summary.maxIndex != PowerSummary::NONE ? devices[summary.maxIndex] : devices.front();
     }
 
-    //        (STL  min_element)
+    // Устройство с минимальным потреблением (первое из равных, как min_element)
     std::shared_ptr<T> getMinPowerDevice() const {
         if (devices.empty()) return nullptr;
-        auto it = std::min_element(devices.begin(), devices.end(),
-            [](const std::shared_ptr<T>& a, const std::shared_ptr<T>& b) {
-                return a->getPowerConsumption() < b->getPowerConsumption();
-            });
-        return *it;
+        PowerSummary summary = getSummary();
+        return summary.minIndex != PowerSummary::NONE ? devices[summary.minIndex] : devices.front();
     }
 
-    //      (STL  copy_if)
+    // Метод для фильтрации включенных устройств по битам состояния
     std::vector<std::shared_ptr<T>> getActiveDevices() const {
+        std::vector<size_t> active;
+        DeviceStateTable::instance().collectActive(stateIndices, active);
         std::vector<std::shared_ptr<T>> activeDevices;
-        std::copy_if(devices.begin(), devices.end(), std::back_inserter(activeDevices),
-            [](const std::shared_ptr<T>& device) {
-                return device->getIsOn();
-            });
+        activeDevices.reserve(active.size());
+        for (size_t position : active) {
+            activeDevices.push_back(devices[position]);
+        }
         return activeDevices;
     }
 
-    //     (STL  any_of)
+    // Проверка наличия онлайн устройств (STL алгоритм any_of)
     bool hasOnlineDevices() const {
-        return std::any_of(devices.begin(), devices.end(),
+        return hasOnlineDevices(Execution::AUTO);
+    }
+
+    bool hasOnlineDevices(Execution policy) const {
+        return Parallel::anyOf(policy, devices.begin(), devices.end(),
             [](const std::shared_ptr<T>& device) {
                 return device->getIsOnline();
             });
     }
 
-    //    (STL  remove_if)
+    // Удаление отключенных устройств (STL алгоритм remove_if)
     void removeOfflineDevices() {
-        auto new_end = std::remove_if(devices.begin(), devices.end(),
+        removeOfflineDevices(Execution::AUTO);
+    }
+
+    // Порядок оставшихся сохраняется; перенумеровывается только хвост от первого удаленного
+    void removeOfflineDevices(Execution policy) {
+        size_t first = devices.size();
+        for (size_t i = 0; i < devices.size(); ++i) {
+            if (devices[i]->getIsOnline()) continue;
+            first = (std::min)(first, i);
+            if (indexes) indexes->erase(*devices[i]);
+            positions.erase(stateIndices[i]);
+        }
+        if (first == devices.size()) {
+            return;
+        }
+        auto new_end = Parallel::removeIf(policy, devices.begin(), devices.end(),
             [](const std::shared_ptr<T>& device) {
                 return !device->getIsOnline();
             });
-        if (new_end != devices.end()) {
-            devices.erase(new_end, devices.end());
-            std::cout << "  " << std::endl;
-        }
+        devices.erase(new_end, devices.end());
+        renumberFrom(first);
+        std::cout << "Офлайн устройства удалены" << std::endl;
     }
 
-    //      (STL  for_each) - 
+    // Применение функции ко всем устройствам (STL алгоритм for_each) - ДОБАВЛЕНО
     template<typename Func>
     void forEachDevice(Func func) const {
         std::for_each(devices.begin(), devices.end(), func);
     }
 
-    //     (STL  find_if)
+    // func вызывается из нескольких потоков одновременно
+    template<typename Func>
+    void forEachDevice(Execution policy, Func func) const {
+        Parallel::forEach(policy, devices.begin(), devices.end(), func);
+    }
+
+    // Число устройств, для которых predicate(const std::shared_ptr<T>&) истинен
+    template<typename Predicate>
+    size_t countDevicesIf(Execution policy, Predicate predicate) const {
+        return Parallel::countIf(policy, devices.begin(), devices.end(), predicate);
+    }
+
+    // Отобранные устройства в порядке списка
+    template<typename Predicate>
+    std::vector<std::shared_ptr<T>> filterDevices(Execution policy, Predicate predicate) const {
+        return Parallel::copyIf(policy, devices.begin(), devices.end(), predicate);
+    }
+
+    // Первое из наибольших по less, как max_element
+    template<typename Compare>
+    std::shared_ptr<T> maxDevice(Execution policy, Compare less) const {
+        auto it = Parallel::maxElement(policy, devices.begin(), devices.end(), less);
+        return it != devices.end() ? *it : nullptr;
+    }
+
+    // Поиск устройства по производителю (STL алгоритм find_if)
     std::shared_ptr<T> findDeviceByManufacturer(const std::string& manufacturer) const {
+        if (indexes) return firstByKey(indexes->byManufacturer, manufacturer);
         auto it = std::find_if(devices.begin(), devices.end(),
             [&manufacturer](const std::shared_ptr<T>& device) {
                 return device->getManufacturer() == manufacturer;
@@ -134,83 +470,166 @@ public:
         return (it != devices.end()) ? *it : nullptr;
     }
 
-    //     (STL  count_if)
+    // Подсчет устройств определенного типа (STL алгоритм count_if)
     int countDevicesByType(DeviceType type) const {
-        return std::count_if(devices.begin(), devices.end(),
-            [type](const std::shared_ptr<T>& device) {
-                return device->getDeviceType() == type;
+        size_t index = static_cast<size_t>(type);
+        if (index >= PowerSummary::TYPE_COUNT) return 0;
+        if (indexes) return static_cast<int>(indexes->byType[index].size());
+        return static_cast<int>(getSummary().byType[index]);
+    }
+
+    // Все устройства производителя в порядке devices
+    std::vector<std::shared_ptr<T>> findDevicesByManufacturer(const std::string& manufacturer) const {
+        return findDevicesByManufacturer(Execution::AUTO, manufacturer);
+    }
+
+    std::vector<std::shared_ptr<T>> findDevicesByManufacturer(Execution policy, const std::string& manufacturer) const {
+        if (indexes) {
+            std::vector<size_t> found;
+            auto range = indexes->byManufacturer.equal_range(manufacturer);
+            for (auto it = range.first; it != range.second; ++it) {
+                found.push_back(positions.at(it->second));
+            }
+            return inDeviceOrder(found);
+        }
+        return Parallel::copyIf(policy, devices.begin(), devices.end(),
+            [&manufacturer](const std::shared_ptr<T>& device) {
+                return device->getManufacturer() == manufacturer;
+            });
+    }
+
+    // Устройства с мощностью строго выше threshold, по убыванию мощности.
+    // С индексами - O(log n + k)
+    std::vector<std::shared_ptr<T>> findDevicesAbovePower(double threshold) const {
+        if (indexes) {
+            auto first = indexes->byPower.upper_bound(std::make_pair(threshold, uint32_t(0xFFFFFFFF)));
+            return collect(indexes->byPower.rbegin(),
+                std::reverse_iterator<decltype(first)>(first));
+        }
+        std::vector<std::shared_ptr<T>> result;
+        std::copy_if(devices.begin(), devices.end(), std::back_inserter(result),
+            [threshold](const std::shared_ptr<T>& device) {
+                return device->getPowerConsumption() > threshold;
+            });
+        std::sort(result.begin(), result.end(),
+            [](const std::shared_ptr<T>& a, const std::shared_ptr<T>& b) {
+                return a->getPowerConsumption() > b->getPowerConsumption();
+            });
+        return result;
+    }
+
+    // Устройства с мощностью в [low, high], по возрастанию мощности
+    std::vector<std::shared_ptr<T>> findDevicesInPowerRange(double low, double high) const {
+        if (indexes) {
+            auto first = indexes->byPower.lower_bound(std::make_pair(low, uint32_t(0)));
+            auto last = indexes->byPower.upper_bound(std::make_pair(high, uint32_t(0xFFFFFFFF)));
+            return collect(first, last);
+        }
+        std::vector<std::shared_ptr<T>> result;
+        std::copy_if(devices.begin(), devices.end(), std::back_inserter(result),
+            [low, high](const std::shared_ptr<T>& device) {
+                double power = device->getPowerConsumption();
+                return power >= low && power <= high;
+            });
+        std::sort(result.begin(), result.end(),
+            [](const std::shared_ptr<T>& a, const std::shared_ptr<T>& b) {
+                return a->getPowerConsumption() < b->getPowerConsumption();
             });
+        return result;
     }
 
-    //     
+    // Вывод информации о всех устройствах
     void displayAllDevices() const {
-        std::cout << "\n===   : " << managerName << " ===" << std::endl;
+        std::cout << "\n=== Устройства в менеджере: " << managerName << " ===" << std::endl;
         for (size_t i = 0; i < devices.size(); ++i) {
             std::cout << i + 1 << ". ";
             devices[i]->displayInfo();
             std::cout << "---" << std::endl;
         }
-        std::cout << " : " << devices.size() << std::endl;
+        std::cout << "Всего устройств: " << devices.size() << std::endl;
+    }
+
+    // Страница устройств в порядке списка менеджера без копирования (см. Cursor).
+    // Пустой токен - первая страница; возвращает токен следующей или пустую строку
+    template <typename Func>
+    std::string forEachDevicePage(const std::string& token, size_t pageSize, Func func) const {
+        auto cursor = makeCursor(devices,
+            [](const std::shared_ptr<T>& device) { return device->getId(); }, pageSize);
+        return cursor.page(token, func);
     }
 
-    //     
+    std::string displayDevicesPage(const std::string& token, size_t pageSize) const {
+        std::cout << "\n=== Устройства в менеджере: " << managerName << " ===" << std::endl;
+        std::string next = forEachDevicePage(token, pageSize,
+            [](size_t number, const std::shared_ptr<T>& device) {
+                std::cout << number << ". ";
+                device->displayInfo();
+                std::cout << "---" << std::endl;
+            });
+        std::cout << "Всего устройств: " << devices.size() << std::endl;
+        return next;
+    }
+
+    // Вывод краткой информации об устройствах
     void displayDevicesSummary() const {
-        std::cout << "\n===     ===" << std::endl;
+        std::cout << "\n=== Краткая информация об устройствах ===" << std::endl;
         this->forEachDevice([](const std::shared_ptr<T>& device) {
             std::cout << "  - " << device->getName() << ": "
-                << device->getPowerConsumption() << "  ("
+                << device->getPowerConsumption() << " Вт ("
                 << device->getStatus() << ")" << std::endl;
             });
     }
 
-    //    
+    // Получение общего потребления энергии
     double getTotalPowerConsumption() const {
-        double total = 0.0;
-        for (const auto& device : devices) {
-            if (device->getIsOn()) {
-                total += device->getPowerConsumption();
-            }
-        }
-        return total;
+        return getSummary().activePower;
     }
 
-    //   
+    // Получение среднего потребления
     double getAveragePowerConsumption() const {
         if (devices.empty()) return 0.0;
-        double total = 0.0;
-        for (const auto& device : devices) {
-            total += device->getPowerConsumption();
-        }
-        return total / devices.size();
+        return getSummary().totalPower / devices.size();
+    }
+
+    // Сводка за один проход: суммы, минимум и максимум, счетчики по типам.
+    // Индексы минимума и максимума - позиции в getAllDevices()
+    PowerSummary getSummary() const {
+        return DeviceStateTable::instance().summarize(stateIndices);
     }
 
-    //   
+    // Получение количества устройств
     size_t getDeviceCount() const {
         return devices.size();
     }
 
-    //   
+    // Получение всех устройств
     const std::vector<std::shared_ptr<T>>& getAllDevices() const {
         return devices;
     }
 
-    //   
+    // Получение имени менеджера
     std::string getManagerName() const {
         return managerName;
     }
 
-    //  
+    // Проверка пустоты
     bool isEmpty() const {
         return devices.empty();
     }
 
-    //   
+    // Очистка всех устройств
     void clear() {
         devices.clear();
-        std::cout << "    " << std::endl;
+        stateIndices.clear();
+        positions.clear();
+        if (indexes) {
+            disableIndexes();
+            enableIndexes();
+        }
+        std::cout << "Все устройства удалены из менеджера" << std::endl;
     }
 
-    //    
+    // Получение устройства по индексу
     std::shared_ptr<T> getDeviceByIndex(size_t index) const {
         if (index < devices.size()) {
             return devices[index];
@@ -0,0 +1,398 @@
+﻿#ifndef DEVICEQUERY_HPP
+#define DEVICEQUERY_HPP
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+#include <sstream>
+#include "DeviceManager.hpp"
+#include "DeviceStateTable.hpp"
+#include "Parallel.hpp"
+#include "room.hpp"
+
+// Порядок результатов запроса
+enum class QueryOrder {
+    NONE,           // порядок списка менеджера
+    POWER_ASC,
+    POWER_DESC,
+    NAME
+};
+
+// Составной запрос к DeviceManager: условия объединяются по "И".
+//
+// Планировщик выбирает источник кандидатов - самый избирательный из индексов
+// менеджера (название, производитель, тип, диапазон мощности, список устройств
+// комнаты) или полный проход. Остальные условия проверяются по колонкам
+// DeviceStateTable, к объекту устройства запрос обращается только за строками.
+// forEach выдает результаты по одному и останавливается на limit. Если источник
+// уже дает нужный порядок, сортировки нет; иначе подходящие позиции сортируются,
+// при limit - частично. Полный проход перед сортировкой проверяет условия на
+// нескольких ядрах (Execution::AUTO, порог Parallel::setCutoff).
+//
+// Запрос не владеет менеджером и комнатой: он действителен, пока они живы и
+// менеджер не меняется
+template<typename T>
+class DeviceQuery {
+public:
+    enum class Source {
+        SCAN,           // все устройства по порядку
+        NAME,           // хеш названий
+        MANUFACTURER,   // хеш производителей
+        TYPE,           // корзина типа
+        ROOM,           // список устройств комнаты
+        POWER,          // диапазон упорядоченного индекса мощности
+        POWER_ORDER,    // весь индекс мощности (ради порядка)
+        NAME_ORDER      // весь индекс названий (ради порядка)
+    };
+
+    struct Plan {
+        Source source;
+        size_t estimate;    // кандидатов в источнике
+        bool sorted;        // результаты сортируются после отбора
+    };
+
+private:
+    const DeviceManager<T>& manager;
+
+    bool hasName;
+    std::string nameValue;
+    bool hasManufacturer;
+    std::string manufacturerValue;
+    bool hasType;
+    DeviceType typeValue;
+    const Room* room;
+    bool hasOn;
+    bool onValue;
+    bool hasOnline;
+    bool onlineValue;
+    bool hasPower;
+    double lowPower;
+    double highPower;
+    QueryOrder order;
+    size_t limitValue;
+
+    template <typename Iterator>
+    static size_t countUpTo(Iterator first, Iterator last, size_t bound) {
+        size_t count = 0;
+        for (; first != last && count < bound; ++first) {
+            ++count;
+        }
+        return count;
+    }
+
+    static void consider(Plan& best, Source source, size_t estimate) {
+        if (estimate < best.estimate) {
+            best.source = source;
+            best.estimate = estimate;
+        }
+    }
+
+    // Совпадает ли порядок источника с запрошенным
+    bool ordered(Source source) const {
+        switch (order) {
+        case QueryOrder::NONE: return source == Source::SCAN;
+        case QueryOrder::POWER_ASC:
+        case QueryOrder::POWER_DESC: return source == Source::POWER || source == Source::POWER_ORDER;
+        case QueryOrder::NAME: return source == Source::NAME_ORDER;
+        default: return false;
+        }
+    }
+
+    bool matches(uint32_t slot, size_t position) const {
+        const DeviceStateTable& table = DeviceStateTable::instance();
+        if (hasType && table.type(slot) != typeValue) return false;
+        if (room && table.room(slot) != room->getStateIndex()) return false;
+        if (hasOn && table.isOn(slot) != onValue) return false;
+        if (hasOnline && table.isOnline(slot) != onlineValue) return false;
+        if (hasPower) {
+            double power = table.power(slot);
+            if (power < lowPower || power > highPower) return false;
+        }
+        const T& device = *manager.devices[position];
+        if (hasName && device.getName() != nameValue) return false;
+        if (hasManufacturer && device.getManufacturer() != manufacturerValue) return false;
+        return true;
+    }
+
+    // Обходит кандидатов источника: visit(slot, position) возвращает false для остановки
+    template <typename Visit>
+    void visitSource(Source source, Visit visit) const {
+        const auto* indexes = manager.indexes.get();
+        bool descending = order == QueryOrder::POWER_DESC;
+        switch (source) {
+        case Source::NAME:
+        case Source::MANUFACTURER: {
+            auto range = source == Source::NAME ? indexes->byName.equal_range(nameValue)
+                : indexes->byManufacturer.equal_range(manufacturerValue);
+            for (auto it = range.first; it != range.second; ++it) {
+                if (!visit(it->second, manager.positions.at(it->second))) return;
+            }
+            return;
+        }
+        case Source::TYPE:
+            for (uint32_t slot : indexes->byType[static_cast<size_t>(typeValue)]) {
+                if (!visit(slot, manager.positions.at(slot))) return;
+            }
+            return;
+        case Source::ROOM:
+            // В комнате могут быть устройства, которых нет в менеджере
+            for (const std::shared_ptr<Device>& device : room->getDevices()) {
+                auto it = manager.positions.find(device->getStateIndex());
+                if (it != manager.positions.end() && !visit(it->first, it->second)) return;
+            }
+            return;
+        case Source::POWER:
+        case Source::POWER_ORDER: {
+            auto first = indexes->byPower.begin();
+            auto last = indexes->byPower.end();
+            if (source == Source::POWER) {
+                first = indexes->byPower.lower_bound(std::make_pair(lowPower, uint32_t(0)));
+                last = indexes->byPower.upper_bound(std::make_pair(highPower, uint32_t(0xFFFFFFFF)));
+            }
+            if (descending) {
+                while (first != last) {
+                    --last;
+                    if (!visit(last->second, manager.positions.at(last->second))) return;
+                }
+                return;
+            }
+            for (; first != last; ++first) {
+                if (!visit(first->second, manager.positions.at(first->second))) return;
+            }
+            return;
+        }
+        case Source::NAME_ORDER:
+            for (const auto& entry : indexes->byNameOrder) {
+                if (!visit(entry.second, manager.positions.at(entry.second))) return;
+            }
+            return;
+        default:
+            for (size_t position = 0; position < manager.stateIndices.size(); ++position) {
+                if (!visit(manager.stateIndices[position], position)) return;
+            }
+            return;
+        }
+    }
+
+    // Подходящие позиции полного прохода по порядку списка: части проверяются
+    // параллельно и склеиваются в своем порядке
+    std::vector<size_t> scanMatches() const {
+        const auto& slots = manager.stateIndices;
+        size_t count = slots.size();
+        size_t parts = Parallel::workerCount(count, Execution::AUTO);
+        std::vector<std::vector<size_t>> found(parts);
+        Parallel::forRanges(count, parts, [this, &slots, &found](size_t part, size_t begin, size_t end) {
+            for (size_t position = begin; position < end; ++position) {
+                if (matches(slots[position], position)) found[part].push_back(position);
+            }
+            });
+        if (parts == 1) {
+            return std::move(found[0]);
+        }
+        std::vector<size_t> result;
+        for (const auto& part : found) {
+            result.insert(result.end(), part.begin(), part.end());
+        }
+        return result;
+    }
+
+    // Сортирует позиции по запрошенному порядку. Равные упорядочены по слоту, как в
+    // индексах мощности и названий; убывание - точно обратный порядок возрастания
+    void sortPositions(std::vector<size_t>& positions) const {
+        auto last = positions.size() > limitValue ? positions.begin() + limitValue : positions.end();
+        const DeviceStateTable& table = DeviceStateTable::instance();
+        const auto& slots = manager.stateIndices;
+        const auto& devices = manager.devices;
+        switch (order) {
+        case QueryOrder::POWER_ASC:
+        case QueryOrder::POWER_DESC: {
+            bool descending = order == QueryOrder::POWER_DESC;
+            std::partial_sort(positions.begin(), last, positions.end(),
+                [&table, &slots, descending](size_t a, size_t b) {
+                    double powerA = table.power(slots[a]);
+                    double powerB = table.power(slots[b]);
+                    if (powerA != powerB) return descending ? powerA > powerB : powerA < powerB;
+                    return descending ? slots[a] > slots[b] : slots[a] < slots[b];
+                });
+            return;
+        }
+        case QueryOrder::NAME:
+            CollationKey::sort(positions.begin(), positions.end(),
+                [&devices](size_t position) -> const CollationKey& { return devices[position]->getNameKey(); },
+                [&slots](size_t a, size_t b) { return slots[a] < slots[b]; },
+                limitValue);
+            return;
+        default:
+            std::partial_sort(positions.begin(), last, positions.end());
+            return;
+        }
+    }
+
+    static const char* sourceName(Source source) {
+        switch (source) {
+        case Source::NAME: return "индекс названий";
+        case Source::MANUFACTURER: return "индекс производителей";
+        case Source::TYPE: return "индекс типов";
+        case Source::ROOM: return "список устройств комнаты";
+        case Source::POWER: return "диапазон индекса мощности";
+        case Source::POWER_ORDER: return "индекс мощности";
+        case Source::NAME_ORDER: return "упорядоченный индекс названий";
+        default: return "полный проход";
+        }
+    }
+
+public:
+    explicit DeviceQuery(const DeviceManager<T>& source)
+        : manager(source), hasName(false), hasManufacturer(false), hasType(false),
+        typeValue(DeviceType::SENSOR), room(nullptr), hasOn(false), onValue(false),
+        hasOnline(false), onlineValue(false), hasPower(false),
+        lowPower(-std::numeric_limits<double>::infinity()),
+        highPower(std::numeric_limits<double>::infinity()),
+        order(QueryOrder::NONE), limitValue((std::numeric_limits<size_t>::max)()) {
+    }
+
+    DeviceQuery& named(const std::string& name) {
+        hasName = true;
+        nameValue = name;
+        return *this;
+    }
+
+    DeviceQuery& fromManufacturer(const std::string& manufacturer) {
+        hasManufacturer = true;
+        manufacturerValue = manufacturer;
+        return *this;
+    }
+
+    DeviceQuery& ofType(DeviceType type) {
+        hasType = true;
+        typeValue = type;
+        return *this;
+    }
+
+    DeviceQuery& inRoom(const Room& target) {
+        room = &target;
+        return *this;
+    }
+
+    DeviceQuery& whereOn(bool on) {
+        hasOn = true;
+        onValue = on;
+        return *this;
+    }
+
+    DeviceQuery& whereOnline(bool online) {
+        hasOnline = true;
+        onlineValue = online;
+        return *this;
+    }
+
+    // Мощность в [low, high]; повторные условия сужают диапазон
+    DeviceQuery& powerBetween(double low, double high) {
+        hasPower = true;
+        // В скобках: Main.cpp подключает windows.h с макросами min/max
+        lowPower = (std::max)(lowPower, low);
+        highPower = (std::min)(highPower, high);
+        return *this;
+    }
+
+    // Мощность строго выше threshold
+    DeviceQuery& powerAbove(double threshold) {
+        return powerBetween(std::nextafter(threshold, std::numeric_limits<double>::infinity()),
+            std::numeric_limits<double>::infinity());
+    }
+
+    DeviceQuery& orderBy(QueryOrder value) {
+        order = value;
+        return *this;
+    }
+
+    DeviceQuery& limit(size_t count) {
+        limitValue = count;
+        return *this;
+    }
+
+    // Выбор источника: без индексов менеджера - всегда полный проход
+    Plan plan() const {
+        Plan best = { Source::SCAN, manager.devices.size(), false };
+        const auto* indexes = manager.indexes.get();
+        if (indexes) {
+            if (hasName) consider(best, Source::NAME, indexes->byName.count(nameValue));
+            if (hasManufacturer) consider(best, Source::MANUFACTURER, indexes->byManufacturer.count(manufacturerValue));
+            size_t type = static_cast<size_t>(typeValue);
+            if (hasType && type < PowerSummary::TYPE_COUNT) consider(best, Source::TYPE, indexes->byType[type].size());
+            if (room) consider(best, Source::ROOM, room->getDeviceCount());
+            if (hasPower) {
+                // Размер диапазона считается не дальше лучшей оценки
+                auto first = indexes->byPower.lower_bound(std::make_pair(lowPower, uint32_t(0)));
+                auto last = indexes->byPower.upper_bound(std::make_pair(highPower, uint32_t(0xFFFFFFFF)));
+                consider(best, Source::POWER, lowPower > highPower ? 0 : countUpTo(first, last, best.estimate));
+            }
+            // Без избирательного индекса полный проход заменяется обходом индекса
+            // в нужном порядке: сортировки нет, limit останавливает обход
+            if (best.source == Source::SCAN) {
+                if (order == QueryOrder::POWER_ASC || order == QueryOrder::POWER_DESC) best.source = Source::POWER_ORDER;
+                if (order == QueryOrder::NAME) best.source = Source::NAME_ORDER;
+            }
+        }
+        best.sorted = !ordered(best.source);
+        return best;
+    }
+
+    // Описание плана для вывода оператору
+    std::string explain() const {
+        Plan chosen = plan();
+        std::stringstream ss;
+        ss << sourceName(chosen.source) << " (кандидатов: " << chosen.estimate << ")";
+        if (chosen.sorted && order != QueryOrder::NONE) {
+            ss << ", сортировка найденного";
+        }
+        return ss.str();
+    }
+
+    // Передает найденные устройства в func (const std::shared_ptr<T>&); возвращает их число
+    template <typename Func>
+    size_t forEach(Func func) const {
+        // Пустой диапазон мощности: границы индекса перевернуты, обходить нечего
+        if (limitValue == 0 || lowPower > highPower) return 0;
+        Plan chosen = plan();
+        size_t emitted = 0;
+        if (!chosen.sorted) {
+            visitSource(chosen.source, [this, &func, &emitted](uint32_t slot, size_t position) {
+                if (!matches(slot, position)) return true;
+                func(manager.devices[position]);
+                return ++emitted < limitValue;
+                });
+            return emitted;
+        }
+
+        std::vector<size_t> found;
+        if (chosen.source == Source::SCAN) {
+            found = scanMatches();
+        }
+        else {
+            visitSource(chosen.source, [this, &found](uint32_t slot, size_t position) {
+                if (matches(slot, position)) found.push_back(position);
+                return true;
+                });
+        }
+        sortPositions(found);
+        for (size_t i = 0; i < found.size() && emitted < limitValue; ++i, ++emitted) {
+            func(manager.devices[found[i]]);
+        }
+        return emitted;
+    }
+
+    std::vector<std::shared_ptr<T>> toVector() const {
+        std::vector<std::shared_ptr<T>> result;
+        forEach([&result](const std::shared_ptr<T>& device) {
+            result.push_back(device);
+            });
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,497 @@
+﻿#include "DeviceStateTable.hpp"
+#include <bitset>
+#include <algorithm>
+#include <stdexcept>
+#include <iostream>
+#include <cmath>
+
+const uint32_t DeviceStateTable::NO_ROOM;
+const size_t DeviceStateTable::CHUNK_SIZE;
+
+namespace {
+
+size_t popcount(uint64_t word) {
+    return std::bitset<64>(word).count();
+}
+
+// Снимок слов битового набора для ядер
+void loadWords(const std::atomic<uint64_t>* words, size_t count, uint64_t* out) {
+    for (size_t w = 0; w < count; ++w) {
+        out[w] = words[w].load(std::memory_order_relaxed);
+    }
+}
+
+// Устройств в одном собранном блоке summarize(indices)
+const size_t GATHER_BLOCK = 256;
+
+int64_t toMilliwatts(double watts) {
+    return std::llround(watts * 1000.0);
+}
+
+void add(std::atomic<int64_t>& total, int64_t delta) {
+    if (delta != 0) {
+        total.fetch_add(delta, std::memory_order_relaxed);
+    }
+}
+
+} // namespace
+
+DeviceStateTable::Chunk::Chunk() {
+    for (size_t i = 0; i < CHUNK_SIZE; ++i) {
+        power[i] = 0.0;
+        room[i] = NO_ROOM;
+        position[i] = 0;
+        type[i] = 0;
+    }
+    for (size_t i = 0; i < CHUNK_SIZE / 64; ++i) {
+        on[i].store(0, std::memory_order_relaxed);
+        online[i].store(0, std::memory_order_relaxed);
+        attached[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+DeviceStateTable::Totals::Totals() : activePower(0), totalPower(0), count(0), activeCount(0) {}
+
+DeviceStateTable::DeviceStateTable() : used(0), live(0), observerCount(0) {
+    for (auto& entry : chunks) {
+        entry.store(nullptr, std::memory_order_relaxed);
+    }
+    for (auto& entry : roomChunks) {
+        entry.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+DeviceStateTable::~DeviceStateTable() {
+    for (auto& entry : chunks) {
+        delete entry.load(std::memory_order_relaxed);
+    }
+    for (auto& entry : roomChunks) {
+        delete entry.load(std::memory_order_relaxed);
+    }
+}
+
+DeviceStateTable& DeviceStateTable::instance() {
+    static DeviceStateTable table;
+    return table;
+}
+
+void DeviceStateTable::setBit(std::atomic<uint64_t>* words, size_t position, bool value) {
+    uint64_t mask = uint64_t(1) << (position % 64);
+    if (value) {
+        words[position / 64].fetch_or(mask, std::memory_order_relaxed);
+    }
+    else {
+        words[position / 64].fetch_and(~mask, std::memory_order_relaxed);
+    }
+}
+
+void DeviceStateTable::activate(uint32_t index, DeviceType type, double power) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t chunkIndex = index >> CHUNK_BITS;
+        if (chunkIndex >= MAX_CHUNKS) {
+            throw std::length_error("Превышено максимальное число устройств");
+        }
+        if (!chunks[chunkIndex].load(std::memory_order_relaxed)) {
+            chunks[chunkIndex].store(new Chunk(), std::memory_order_release);
+        }
+        if (index >= used.load(std::memory_order_relaxed)) {
+            used.store(index + 1, std::memory_order_release);
+        }
+    }
+
+    Chunk& block = chunk(index);
+    block.power[offset(index)] = power;
+    block.type[offset(index)] = static_cast<uint8_t>(type);
+    block.room[offset(index)] = NO_ROOM;
+    // Новое устройство выключено и в сети, как в конструкторе Device
+    setBit(block.online, offset(index), true);
+    live++;
+}
+
+DeviceStateTable::Totals* DeviceStateTable::roomTotals(uint32_t room) const {
+    if (room == NO_ROOM) return nullptr;
+    RoomChunk* block = roomChunks[room / ROOM_CHUNK_SIZE].load(std::memory_order_acquire);
+    return &block->totals[room % ROOM_CHUNK_SIZE];
+}
+
+DeviceStateTable::Totals* DeviceStateTable::totalsOfType(uint8_t type) const {
+    if (type >= PowerSummary::TYPE_COUNT) return nullptr;
+    return const_cast<Totals*>(&typeTotals[type]);
+}
+
+DeviceStateTable::SlotState DeviceStateTable::slotState(uint32_t index) const {
+    const Chunk& block = chunk(index);
+    size_t position = offset(index);
+    SlotState state = { block.room[position], block.type[position], { 0, 0, 0, 0 } };
+    if (state.room != NO_ROOM) {
+        int64_t power = toMilliwatts(block.power[position]);
+        int64_t on = (block.on[position / 64].load(std::memory_order_relaxed) >> (position % 64)) & 1;
+        state.contribution = { on ? power : 0, power, 1, on };
+    }
+    return state;
+}
+
+void DeviceStateTable::publish(const SlotState& before, const SlotState& after) {
+    const Contribution& was = before.contribution;
+    const Contribution& now = after.contribution;
+
+    auto apply = [](Totals* totals, const Contribution& removed, const Contribution& added) {
+        if (!totals) return;
+        add(totals->activePower, added.activePower - removed.activePower);
+        add(totals->totalPower, added.totalPower - removed.totalPower);
+        add(totals->count, added.count - removed.count);
+        add(totals->activeCount, added.activeCount - removed.activeCount);
+    };
+    const Contribution none = { 0, 0, 0, 0 };
+
+    apply(&home, was, now);
+
+    Totals* typeBefore = totalsOfType(before.type);
+    Totals* typeAfter = totalsOfType(after.type);
+    if (typeBefore == typeAfter) {
+        apply(typeAfter, was, now);
+    }
+    else {
+        apply(typeBefore, was, none);
+        apply(typeAfter, none, now);
+    }
+
+    Totals* roomBefore = roomTotals(before.room);
+    Totals* roomAfter = roomTotals(after.room);
+    if (roomBefore == roomAfter) {
+        apply(roomAfter, was, now);
+    }
+    else {
+        apply(roomBefore, was, none);
+        apply(roomAfter, none, now);
+    }
+}
+
+void DeviceStateTable::release(uint32_t index) {
+    // Освобожденный слот не влияет на агрегаты: флаги сброшены, мощность нулевая
+    SlotState before = slotState(index);
+    Chunk& block = chunk(index);
+    block.power[offset(index)] = 0.0;
+    block.room[offset(index)] = NO_ROOM;
+    setBit(block.on, offset(index), false);
+    setBit(block.online, offset(index), false);
+    setBit(block.attached, offset(index), false);
+    publish(before, slotState(index));
+    live--;
+}
+
+void DeviceStateTable::activateRoom(uint32_t room) {
+    // Суммы повторно занятого индекса нулевые: ~Room отсоединяет все устройства
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t chunkIndex = room / ROOM_CHUNK_SIZE;
+    if (chunkIndex >= MAX_ROOM_CHUNKS) {
+        throw std::length_error("Превышено максимальное число комнат");
+    }
+    if (!roomChunks[chunkIndex].load(std::memory_order_relaxed)) {
+        roomChunks[chunkIndex].store(new RoomChunk(), std::memory_order_release);
+    }
+}
+
+void DeviceStateTable::setOn(uint32_t index, bool value) {
+    SlotState before = slotState(index);
+    setBit(chunk(index).on, offset(index), value);
+    publish(before, slotState(index));
+}
+
+void DeviceStateTable::setOnline(uint32_t index, bool value) {
+    setBit(chunk(index).online, offset(index), value);
+}
+
+void DeviceStateTable::setPower(uint32_t index, double value) {
+    SlotState before = slotState(index);
+    double previous = chunk(index).power[offset(index)];
+    chunk(index).power[offset(index)] = value;
+    publish(before, slotState(index));
+
+    if (observerCount.load(std::memory_order_acquire) != 0 && previous != value) {
+        std::lock_guard<std::mutex> lock(observerMutex);
+        for (StateObserver* observer : observers) {
+            observer->powerChanged(index, previous, value);
+        }
+    }
+}
+
+void DeviceStateTable::setType(uint32_t index, DeviceType value) {
+    SlotState before = slotState(index);
+    chunk(index).type[offset(index)] = static_cast<uint8_t>(value);
+    publish(before, slotState(index));
+
+    DeviceType previous = static_cast<DeviceType>(before.type);
+    if (observerCount.load(std::memory_order_acquire) != 0 && previous != value) {
+        std::lock_guard<std::mutex> lock(observerMutex);
+        for (StateObserver* observer : observers) {
+            observer->typeChanged(index, previous, value);
+        }
+    }
+}
+
+void DeviceStateTable::addObserver(StateObserver* observer) {
+    std::lock_guard<std::mutex> lock(observerMutex);
+    observers.push_back(observer);
+    observerCount.store(observers.size(), std::memory_order_release);
+}
+
+void DeviceStateTable::removeObserver(StateObserver* observer) {
+    std::lock_guard<std::mutex> lock(observerMutex);
+    observers.erase(std::remove(observers.begin(), observers.end(), observer), observers.end());
+    observerCount.store(observers.size(), std::memory_order_release);
+}
+
+void DeviceStateTable::setRoom(uint32_t index, uint32_t room) {
+    SlotState before = slotState(index);
+    Chunk& block = chunk(index);
+    block.room[offset(index)] = room;
+    setBit(block.attached, offset(index), room != NO_ROOM);
+    publish(before, slotState(index));
+}
+
+void DeviceStateTable::setRoomPosition(uint32_t index, uint32_t position) {
+    chunk(index).position[offset(index)] = position;
+}
+
+size_t DeviceStateTable::countAttached() const {
+    size_t total = 0;
+    uint32_t end = used.load(std::memory_order_acquire);
+    for (uint32_t base = 0; base < end; base += CHUNK_SIZE) {
+        if (!hasChunk(base)) continue;
+        const Chunk& block = chunk(base);
+        size_t words = (std::min<size_t>(end - base, CHUNK_SIZE) + 63) / 64;
+        for (size_t w = 0; w < words; ++w) {
+            total += popcount(block.attached[w].load(std::memory_order_relaxed));
+        }
+    }
+    return total;
+}
+
+size_t DeviceStateTable::countOn() const {
+    size_t total = 0;
+    uint32_t end = used.load(std::memory_order_acquire);
+    for (uint32_t base = 0; base < end; base += CHUNK_SIZE) {
+        if (!hasChunk(base)) continue;
+        const Chunk& block = chunk(base);
+        size_t words = (std::min<size_t>(end - base, CHUNK_SIZE) + 63) / 64;
+        for (size_t w = 0; w < words; ++w) {
+            total += popcount(block.on[w].load(std::memory_order_relaxed) &
+                block.attached[w].load(std::memory_order_relaxed));
+        }
+    }
+    return total;
+}
+
+size_t DeviceStateTable::countOnline() const {
+    size_t total = 0;
+    uint32_t end = used.load(std::memory_order_acquire);
+    for (uint32_t base = 0; base < end; base += CHUNK_SIZE) {
+        if (!hasChunk(base)) continue;
+        const Chunk& block = chunk(base);
+        size_t words = (std::min<size_t>(end - base, CHUNK_SIZE) + 63) / 64;
+        for (size_t w = 0; w < words; ++w) {
+            total += popcount(block.online[w].load(std::memory_order_relaxed) &
+                block.attached[w].load(std::memory_order_relaxed));
+        }
+    }
+    return total;
+}
+
+double DeviceStateTable::activePower() const {
+    double total = 0.0;
+    uint64_t mask[CHUNK_SIZE / 64];
+    uint32_t end = used.load(std::memory_order_acquire);
+    for (uint32_t base = 0; base < end; base += CHUNK_SIZE) {
+        if (!hasChunk(base)) continue;
+        const Chunk& block = chunk(base);
+        size_t count = std::min<size_t>(end - base, CHUNK_SIZE);
+        for (size_t w = 0; w * 64 < count; ++w) {
+            mask[w] = block.on[w].load(std::memory_order_relaxed) &
+                block.attached[w].load(std::memory_order_relaxed);
+        }
+        total += AggregateKernels::maskedSum(block.power, mask, count);
+    }
+    return total;
+}
+
+double DeviceStateTable::totalPower() const {
+    double total = 0.0;
+    uint64_t mask[CHUNK_SIZE / 64];
+    uint32_t end = used.load(std::memory_order_acquire);
+    for (uint32_t base = 0; base < end; base += CHUNK_SIZE) {
+        if (!hasChunk(base)) continue;
+        const Chunk& block = chunk(base);
+        size_t count = std::min<size_t>(end - base, CHUNK_SIZE);
+        loadWords(block.attached, (count + 63) / 64, mask);
+        total += AggregateKernels::maskedSum(block.power, mask, count);
+    }
+    return total;
+}
+
+size_t DeviceStateTable::countInRoom(uint32_t room) const {
+    size_t total = 0;
+    uint32_t end = used.load(std::memory_order_acquire);
+    for (uint32_t base = 0; base < end; base += CHUNK_SIZE) {
+        if (!hasChunk(base)) continue;
+        const Chunk& block = chunk(base);
+        size_t count = std::min<size_t>(end - base, CHUNK_SIZE);
+        for (size_t i = 0; i < count; ++i) {
+            total += block.room[i] == room;
+        }
+    }
+    return total;
+}
+
+double DeviceStateTable::activePowerInRoom(uint32_t room) const {
+    double total = 0.0;
+    uint32_t end = used.load(std::memory_order_acquire);
+    for (uint32_t base = 0; base < end; base += CHUNK_SIZE) {
+        if (!hasChunk(base)) continue;
+        const Chunk& block = chunk(base);
+        size_t count = std::min<size_t>(end - base, CHUNK_SIZE);
+        for (size_t i = 0; i < count; ++i) {
+            if (block.room[i] == room && ((block.on[i / 64].load(std::memory_order_relaxed) >> (i % 64)) & 1)) {
+                total += block.power[i];
+            }
+        }
+    }
+    return total;
+}
+
+double DeviceStateTable::activePowerOf(const std::vector<uint32_t>& indices) const {
+    double total = 0.0;
+    for (uint32_t index : indices) {
+        if (isOn(index)) {
+            total += power(index);
+        }
+    }
+    return total;
+}
+
+PowerSummary DeviceStateTable::summarize() const {
+    PowerSummary result;
+    uint64_t attached[CHUNK_SIZE / 64], on[CHUNK_SIZE / 64], online[CHUNK_SIZE / 64];
+    uint32_t end = used.load(std::memory_order_acquire);
+    for (uint32_t base = 0; base < end; base += CHUNK_SIZE) {
+        if (!hasChunk(base)) continue;
+        const Chunk& block = chunk(base);
+        size_t count = std::min<size_t>(end - base, CHUNK_SIZE);
+        size_t words = (count + 63) / 64;
+        loadWords(block.attached, words, attached);
+        loadWords(block.on, words, on);
+        loadWords(block.online, words, online);
+
+        KernelBlock data = { block.power, block.type, attached, on, online, count };
+        PowerSummary part;
+        AggregateKernels::summarize(data, part);
+        result.merge(part, base);
+    }
+    return result;
+}
+
+PowerSummary DeviceStateTable::summarize(const std::vector<uint32_t>& indices) const {
+    PowerSummary result;
+    double power[GATHER_BLOCK];
+    uint8_t type[GATHER_BLOCK];
+    uint64_t included[GATHER_BLOCK / 64], on[GATHER_BLOCK / 64], online[GATHER_BLOCK / 64];
+    for (size_t base = 0; base < indices.size(); base += GATHER_BLOCK) {
+        size_t count = std::min(indices.size() - base, GATHER_BLOCK);
+        for (size_t w = 0; w < GATHER_BLOCK / 64; ++w) {
+            included[w] = on[w] = online[w] = 0;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t index = indices[base + i];
+            const Chunk& block = chunk(index);
+            size_t position = offset(index);
+            power[i] = block.power[position];
+            type[i] = block.type[position];
+            uint64_t shift = position % 64;
+            included[i / 64] |= uint64_t(1) << (i % 64);
+            on[i / 64] |= ((block.on[position / 64].load(std::memory_order_relaxed) >> shift) & 1) << (i % 64);
+            online[i / 64] |= ((block.online[position / 64].load(std::memory_order_relaxed) >> shift) & 1) << (i % 64);
+        }
+
+        KernelBlock data = { power, type, included, on, online, count };
+        PowerSummary part;
+        AggregateKernels::summarize(data, part);
+        result.merge(part, base);
+    }
+    return result;
+}
+
+void DeviceStateTable::collectActive(const std::vector<uint32_t>& indices, std::vector<size_t>& positions) const {
+    for (size_t i = 0; i < indices.size(); ++i) {
+        if (isOn(indices[i])) {
+            positions.push_back(i);
+        }
+    }
+}
+
+LoadTotals DeviceStateTable::toLoad(const Totals& totals) {
+    LoadTotals load;
+    load.activePower = totals.activePower.load(std::memory_order_relaxed) / 1000.0;
+    load.totalPower = totals.totalPower.load(std::memory_order_relaxed) / 1000.0;
+    load.count = static_cast<size_t>(totals.count.load(std::memory_order_relaxed));
+    load.activeCount = static_cast<size_t>(totals.activeCount.load(std::memory_order_relaxed));
+    return load;
+}
+
+LoadTotals DeviceStateTable::homeLoad() const {
+#ifdef _DEBUG
+    crossCheck(home, recompute(false, NO_ROOM, false, 0), "дом");
+#endif
+    return toLoad(home);
+}
+
+LoadTotals DeviceStateTable::roomLoad(uint32_t room) const {
+    const Totals* totals = roomTotals(room);
+    if (!totals) return LoadTotals{ 0.0, 0.0, 0, 0 };
+#ifdef _DEBUG
+    crossCheck(*totals, recompute(true, room, false, 0), "комната");
+#endif
+    return toLoad(*totals);
+}
+
+LoadTotals DeviceStateTable::typeLoad(DeviceType type) const {
+    const Totals* totals = totalsOfType(static_cast<uint8_t>(type));
+    if (!totals) return LoadTotals{ 0.0, 0.0, 0, 0 };
+#ifdef _DEBUG
+    crossCheck(*totals, recompute(false, NO_ROOM, true, static_cast<uint8_t>(type)), "тип устройств");
+#endif
+    return toLoad(*totals);
+}
+
+DeviceStateTable::Contribution DeviceStateTable::recompute(bool byRoom, uint32_t room, bool byType, uint8_t type) const {
+    Contribution total = { 0, 0, 0, 0 };
+    uint32_t end = used.load(std::memory_order_acquire);
+    for (uint32_t index = 0; index < end; ++index) {
+        if (!hasChunk(index)) {
+            index |= CHUNK_SIZE - 1;    // сразу к следующему блоку
+            continue;
+        }
+        SlotState state = slotState(index);
+        if (state.room == NO_ROOM) continue;
+        if (byRoom && state.room != room) continue;
+        if (byType && state.type != type) continue;
+        total.activePower += state.contribution.activePower;
+        total.totalPower += state.contribution.totalPower;
+        total.count += state.contribution.count;
+        total.activeCount += state.contribution.activeCount;
+    }
+    return total;
+}
+
+void DeviceStateTable::crossCheck(const Totals& totals, const Contribution& expected, const char* scope) {
+    if (totals.activePower.load() != expected.activePower || totals.totalPower.load() != expected.totalPower ||
+        totals.count.load() != expected.count || totals.activeCount.load() != expected.activeCount) {
+        std::cerr << "Ошибка: текущие суммы (" << scope << ") расходятся с пересчетом: "
+            << totals.activePower.load() / 1000.0 << " Вт вместо " << expected.activePower / 1000.0
+            << " Вт, включено " << totals.activeCount.load() << " вместо " << expected.activeCount << std::endl;
+    }
+}
+
+size_t DeviceStateTable::liveCount() const {
+    return live.load();
+}
@@ -0,0 +1,225 @@
+﻿#ifndef DEVICESTATETABLE_HPP
+#define DEVICESTATETABLE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include "deviceType.hpp"
+#include "AggregateKernels.hpp"
+
+// Текущая нагрузка набора устройств
+struct LoadTotals {
+    double activePower;     // Вт, включенные устройства
+    double totalPower;
+    size_t count;
+    size_t activeCount;
+};
+
+// Наблюдатель изменений мощности и типа устройств (вторичные индексы).
+// Вызывается в потоке, изменившем устройство, под блокировкой списка наблюдателей
+class StateObserver {
+public:
+    virtual ~StateObserver() {}
+    virtual void powerChanged(uint32_t index, double before, double after) = 0;
+    virtual void typeChanged(uint32_t index, DeviceType before, DeviceType after) = 0;
+};
+
+// Горячее состояние всех устройств в виде структуры массивов.
+//
+// Каждое устройство хранит здесь под индексом своего слота в Device::slots()
+// мощность, флаги вкл/онлайн (битовые наборы), тип, индекс комнаты и позицию в
+// списке устройств комнаты. Агрегаты по всему дому - линейный проход по массивам
+// без обращения к объектам Device.
+//
+// Слоты лежат блоками по CHUNK_SIZE, блоки не перемещаются: устройства создаются
+// в потоках загрузчика одновременно, поэтому создание блоков защищено мьютексом,
+// а биты флагов меняются атомарно (соседние устройства делят одно слово).
+//
+// Колонка комнаты отражает список устройств комнаты (Room::addDevice/removeDevice),
+// а не поле location: удаленное из дома устройство может еще жить в уведомлениях.
+//
+// Суммы и сводки считаются векторными ядрами AggregateKernels по массивам блока.
+//
+// Кроме того, сеттеры публикуют приращения в текущие суммы по дому, типам и
+// комнатам, поэтому homeLoad/roomLoad/typeLoad отвечают за O(1). Суммы ведутся в
+// целых милливаттах, чтобы приращения не накапливали ошибку округления. Одно
+// устройство не меняют из нескольких потоков одновременно (как и сам объект
+// Device), разные - можно: суммы атомарны. Колонки мощности и типа атомарными не
+// являются: чтение строки устройства одновременно с ее записью не синхронизировано,
+// поэтому из других потоков надежны только суммы и флаги
+class DeviceStateTable {
+public:
+    static const uint32_t NO_ROOM = 0xFFFFFFFF;
+    static const size_t CHUNK_BITS = 12;
+    static const size_t CHUNK_SIZE = size_t(1) << CHUNK_BITS;
+    static const size_t MAX_CHUNKS = 1024;
+
+private:
+    struct Chunk {
+        double power[CHUNK_SIZE];
+        uint32_t room[CHUNK_SIZE];
+        uint32_t position[CHUNK_SIZE];    // индекс в списке устройств комнаты
+        uint8_t type[CHUNK_SIZE];
+        std::atomic<uint64_t> on[CHUNK_SIZE / 64];
+        std::atomic<uint64_t> online[CHUNK_SIZE / 64];
+        std::atomic<uint64_t> attached[CHUNK_SIZE / 64];   // room != NO_ROOM
+
+        Chunk();
+    };
+
+    // Суммы в милливаттах
+    struct Totals {
+        std::atomic<int64_t> activePower;
+        std::atomic<int64_t> totalPower;
+        std::atomic<int64_t> count;
+        std::atomic<int64_t> activeCount;
+
+        Totals();
+    };
+
+    // Вклад одного устройства в суммы; нулевой, если устройство вне комнат
+    struct Contribution {
+        int64_t activePower;
+        int64_t totalPower;
+        int64_t count;
+        int64_t activeCount;
+    };
+
+    struct SlotState {
+        uint32_t room;
+        uint8_t type;
+        Contribution contribution;
+    };
+
+    static const size_t ROOM_CHUNK_SIZE = 256;
+    static const size_t MAX_ROOM_CHUNKS = 256;
+
+    struct RoomChunk {
+        Totals totals[ROOM_CHUNK_SIZE];
+    };
+
+    std::atomic<Chunk*> chunks[MAX_CHUNKS];
+    std::atomic<RoomChunk*> roomChunks[MAX_ROOM_CHUNKS];
+    Totals home;
+    Totals typeTotals[PowerSummary::TYPE_COUNT];
+    std::atomic<uint32_t> used;      // граница занятых слотов
+    std::atomic<size_t> live;
+    std::mutex mutex;
+
+    // Без наблюдателей сеттеры не берут блокировку
+    std::vector<StateObserver*> observers;
+    std::atomic<size_t> observerCount;
+    std::mutex observerMutex;
+
+    DeviceStateTable();
+    ~DeviceStateTable();
+
+    Chunk& chunk(uint32_t index) const {
+        return *chunks[index >> CHUNK_BITS].load(std::memory_order_acquire);
+    }
+
+    // used поднимается, как только создан блок старшего слота, а блок младшего
+    // слота в это время может еще создаваться в другом потоке загрузчика:
+    // проходы по таблице пропускают такие блоки
+    bool hasChunk(uint32_t index) const {
+        return chunks[index >> CHUNK_BITS].load(std::memory_order_acquire) != nullptr;
+    }
+
+    static size_t offset(uint32_t index) {
+        return index & (CHUNK_SIZE - 1);
+    }
+
+    static void setBit(std::atomic<uint64_t>* words, size_t position, bool value);
+
+    Totals* roomTotals(uint32_t room) const;
+    Totals* totalsOfType(uint8_t type) const;
+    SlotState slotState(uint32_t index) const;
+    // Переносит разницу состояний слота в суммы дома, типов и комнат
+    void publish(const SlotState& before, const SlotState& after);
+    static LoadTotals toLoad(const Totals& totals);
+
+    // Полный пересчет для проверки сумм в отладочной сборке
+    Contribution recompute(bool byRoom, uint32_t room, bool byType, uint8_t type) const;
+    static void crossCheck(const Totals& totals, const Contribution& expected, const char* scope);
+
+public:
+    DeviceStateTable(const DeviceStateTable&) = delete;
+    DeviceStateTable& operator=(const DeviceStateTable&) = delete;
+
+    static DeviceStateTable& instance();
+
+    // Занимает слот index (выданный Device::slots()) под новое устройство
+    void activate(uint32_t index, DeviceType type, double power);
+    void release(uint32_t index);
+
+    // Готовит суммы комнаты с индексом room (выданным Room::slots())
+    void activateRoom(uint32_t room);
+
+    void addObserver(StateObserver* observer);
+    void removeObserver(StateObserver* observer);
+
+    bool isOn(uint32_t index) const {
+        return (chunk(index).on[offset(index) / 64].load(std::memory_order_relaxed) >> (index % 64)) & 1;
+    }
+
+    bool isOnline(uint32_t index) const {
+        return (chunk(index).online[offset(index) / 64].load(std::memory_order_relaxed) >> (index % 64)) & 1;
+    }
+
+    double power(uint32_t index) const {
+        return chunk(index).power[offset(index)];
+    }
+
+    DeviceType type(uint32_t index) const {
+        return static_cast<DeviceType>(chunk(index).type[offset(index)]);
+    }
+
+    uint32_t room(uint32_t index) const {
+        return chunk(index).room[offset(index)];
+    }
+
+    uint32_t roomPosition(uint32_t index) const {
+        return chunk(index).position[offset(index)];
+    }
+
+    void setOn(uint32_t index, bool value);
+    void setOnline(uint32_t index, bool value);
+    void setPower(uint32_t index, double value);
+    void setType(uint32_t index, DeviceType value);
+    void setRoom(uint32_t index, uint32_t room);
+    void setRoomPosition(uint32_t index, uint32_t position);
+
+    // Агрегаты по устройствам, которые находятся в какой-либо комнате
+    size_t countAttached() const;
+    size_t countOn() const;
+    size_t countOnline() const;
+    double activePower() const;
+    double totalPower() const;
+
+    // Текущая нагрузка за O(1) по устройствам в комнатах
+    LoadTotals homeLoad() const;
+    LoadTotals roomLoad(uint32_t room) const;
+    LoadTotals typeLoad(DeviceType type) const;
+
+    // Агрегаты по одной комнате
+    size_t countInRoom(uint32_t room) const;
+    double activePowerInRoom(uint32_t room) const;
+
+    // Агрегат по произвольному набору слотов (например, DeviceManager)
+    double activePowerOf(const std::vector<uint32_t>& indices) const;
+
+    // Все агрегаты по устройствам в комнатах за один проход; индексы - слоты
+    PowerSummary summarize() const;
+    // То же по набору слотов: значения собираются в непрерывные блоки для ядер,
+    // индексы минимума и максимума - позиции в indices
+    PowerSummary summarize(const std::vector<uint32_t>& indices) const;
+    // Позиции включенных устройств в indices
+    void collectActive(const std::vector<uint32_t>& indices, std::vector<size_t>& positions) const;
+
+    // Всего занятых слотов, включая устройства вне комнат
+    size_t liveCount() const;
+};
+
+#endif
@@ -1,5 +1,6 @@
 #include "energyReport.hpp"
 #include "device.hpp"
+#include "FieldTokenizer.hpp"
 #include <iostream>
 #include <algorithm>
 #include <vector>
@@ -49,11 +50,11 @@ void EnergyReport::addDeviceConsumption(std::shared_ptr<Device> device, double c
 }
 
 void EnergyReport::displayReport() const {
-    std::cout << "\n===    " << reportId << " ===" << std::endl;
+    std::cout << "\n=== ОТЧЕТ ПО ЭНЕРГОПОТРЕБЛЕНИЮ " << reportId << " ===" << std::endl;
 
     char startBuffer[80], endBuffer[80];
 
-    //    Windows
+    // Безопасная версия для Windows
 #ifdef _WIN32
     struct tm startInfo, endInfo;
     localtime_s(&startInfo, &periodStart);
@@ -67,33 +68,33 @@ void EnergyReport::displayReport() const {
     std::strftime(endBuffer, sizeof(endBuffer), "%Y-%m-%d %H:%M:%S", endInfo);
 #endif
 
-    std::cout << ":  " << startBuffer << "  " << endBuffer << std::endl;
-    std::cout << " : " << std::fixed << std::setprecision(2)
-        << totalConsumption << " " << std::endl;
-    std::cout << " : " << peakLoad << " " << std::endl;
-    std::cout << "   : " << deviceConsumptions.size() << std::endl;
+    std::cout << "Период: с " << startBuffer << " по " << endBuffer << std::endl;
+    std::cout << "Общее потребление: " << std::fixed << std::setprecision(2)
+        << totalConsumption << " кВт·ч" << std::endl;
+    std::cout << "Пиковая нагрузка: " << peakLoad << " кВт" << std::endl;
+    std::cout << "Всего устройств в отчете: " << deviceConsumptions.size() << std::endl;
 
     auto topDevices = getTopConsumingDevices(3);
     if (!topDevices.empty()) {
-        std::cout << "\n-3  :" << std::endl;
+        std::cout << "\nТоп-3 потребителей энергии:" << std::endl;
         for (size_t i = 0; i < topDevices.size(); i++) {
             const auto& device = topDevices[i];
             double consumption = deviceConsumptions.at(device);
             std::cout << "  " << i + 1 << ". " << device->getName()
                 << " (" << device->getDeviceTypeString() << "): "
-                << consumption << " " << std::endl;
+                << consumption << " кВт·ч" << std::endl;
         }
     }
 
-    std::cout << "\n  :" << std::endl;
+    std::cout << "\nДетализация по устройствам:" << std::endl;
     int counter = 1;
     for (const auto& pair : deviceConsumptions) {
         std::cout << "  " << counter++ << ". " << pair.first->getName()
-            << ": " << pair.second << " " << std::endl;
+            << ": " << pair.second << " кВт·ч" << std::endl;
     }
 
     double averageLoad = deviceConsumptions.empty() ? 0.0 : totalConsumption / deviceConsumptions.size();
-    std::cout << "\n   : " << averageLoad << " " << std::endl;
+    std::cout << "\nСредняя нагрузка на устройство: " << averageLoad << " кВт·ч" << std::endl;
 
     std::cout << "======================================" << std::endl;
 }
@@ -127,35 +128,27 @@ std::string EnergyReport::serialize() const {
 }
 
 std::unique_ptr<EnergyReport> EnergyReport::deserialize(const std::string& data) {
-    try {
-        std::stringstream ss(data);
-        std::string id, startStr, endStr, totalStr, peakStr, countStr;
-
-        std::getline(ss, id, '|');
-        std::getline(ss, startStr, '|');
-        std::getline(ss, endStr, '|');
-        std::getline(ss, totalStr, '|');
-        std::getline(ss, peakStr, '|');
-        std::getline(ss, countStr, '|');
-
-        auto report = std::make_unique<EnergyReport>(
-            id,
-            std::stol(startStr),
-            std::stol(endStr)
-        );
+    FieldTokenizer fields(data);
+    int64_t start = 0, end = 0;
+    double total = 0.0, peak = 0.0;
+    int deviceCount = 0;
+    if (!fields.getInt64(1, start) || !fields.getInt64(2, end) || !fields.getDouble(3, total) ||
+        !fields.getDouble(4, peak) || !fields.getInt(5, deviceCount)) {
+        std::cerr << "Ошибка десериализации энергоотчета: " << fields.errorText() << std::endl;
+        return nullptr;
+    }
 
-        report->totalConsumption = std::stod(totalStr);
-        report->peakLoad = std::stod(peakStr);
+    auto report = std::make_unique<EnergyReport>(
+        fields.text(0),
+        static_cast<std::time_t>(start),
+        static_cast<std::time_t>(end)
+    );
 
-        int deviceCount = std::stoi(countStr);
+    report->totalConsumption = total;
+    report->peakLoad = peak;
 
-        // :     
-        //    
+    // Примечание: устройства должны быть добавлены позже
+    // после загрузки всех данных
 
-        return report;
-    }
-    catch (const std::exception& e) {
-        std::cerr << "  : " << e.what() << std::endl;
-        return nullptr;
-    }
+    return report;
 }
\ No newline at end of file
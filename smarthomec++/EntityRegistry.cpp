@@ -0,0 +1,169 @@
+﻿#include "EntityRegistry.hpp"
+#include "Room.hpp"
+#include "Device.hpp"
+#include "User.hpp"
+#include "AutomationScenario.hpp"
+#include <algorithm>
+#include <iterator>
+#include <iostream>
+
+void EntityRegistry::noteId(const std::string& id) {
+    size_t digits = id.find_last_not_of("0123456789") + 1;
+    // Номер длиннее 18 цифр не помещается в uint64_t - такие ID не учитываются
+    if (digits == id.size() || id.size() - digits > 18) return;
+    uint64_t number = std::stoull(id.substr(digits));
+    std::lock_guard<std::mutex> lock(idMutex);
+    uint64_t& last = lastIds[id.substr(0, digits)];
+    if (number > last) {
+        last = number;
+    }
+}
+
+std::string EntityRegistry::nextId(const std::string& prefix) {
+    std::lock_guard<std::mutex> lock(idMutex);
+    return prefix + std::to_string(++lastIds[prefix]);
+}
+
+void EntityRegistry::reserveId(const std::string& id) {
+    noteId(id);
+}
+
+bool EntityRegistry::addRoom(const std::shared_ptr<Room>& room) {
+    if (!rooms.emplace(room->getId(), room).second) {
+        std::cerr << "Ошибка: комната с ID " << room->getId() << " уже существует" << std::endl;
+        return false;
+    }
+    noteId(room->getId());
+    return true;
+}
+
+bool EntityRegistry::addDevice(const std::shared_ptr<Device>& device) {
+    if (!devices.insert(device->getId(), device)) {
+        std::cerr << "Ошибка: устройство с ID " << device->getId() << " уже существует" << std::endl;
+        return false;
+    }
+    noteId(device->getId());
+    std::lock_guard<std::mutex> lock(deviceTextMutex);
+    deviceNames.insert(device->getId(), device->getName());
+    deviceManufacturers.insert(device->getId(), device->getManufacturer());
+    return true;
+}
+
+bool EntityRegistry::addUser(const std::shared_ptr<User>& user) {
+    if (!users.emplace(user->getUserId(), user).second) {
+        std::cerr << "Ошибка: пользователь с ID " << user->getUserId() << " уже существует" << std::endl;
+        return false;
+    }
+    noteId(user->getUserId());
+    userNames.insert(user->getUserId(), user->getUsername());
+    userEmails.insert(user->getUserId(), user->getEmail());
+    return true;
+}
+
+bool EntityRegistry::addScenario(AutomationScenario* scenario) {
+    if (!scenarios.emplace(scenario->getScenarioId(), scenario).second) {
+        std::cerr << "Ошибка: сценарий с ID " << scenario->getScenarioId() << " уже существует" << std::endl;
+        return false;
+    }
+    noteId(scenario->getScenarioId());
+    return true;
+}
+
+void EntityRegistry::removeRoom(const std::string& id) {
+    rooms.erase(id);
+}
+
+void EntityRegistry::removeDevice(const std::string& id) {
+    devices.erase(id);
+    std::lock_guard<std::mutex> lock(deviceTextMutex);
+    deviceNames.erase(id);
+    deviceManufacturers.erase(id);
+}
+
+void EntityRegistry::removeUser(const std::string& id) {
+    users.erase(id);
+    userNames.erase(id);
+    userEmails.erase(id);
+}
+
+void EntityRegistry::removeScenario(const std::string& id) {
+    scenarios.erase(id);
+}
+
+std::shared_ptr<Room> EntityRegistry::findRoom(const std::string& id) const {
+    auto it = rooms.find(id);
+    return it != rooms.end() ? it->second : nullptr;
+}
+
+std::shared_ptr<Device> EntityRegistry::findDevice(const std::string& id) const {
+    return devices.find(id);
+}
+
+std::shared_ptr<User> EntityRegistry::findUser(const std::string& id) const {
+    auto it = users.find(id);
+    return it != users.end() ? it->second : nullptr;
+}
+
+AutomationScenario* EntityRegistry::findScenario(const std::string& id) const {
+    auto it = scenarios.find(id);
+    return it != scenarios.end() ? it->second : nullptr;
+}
+
+std::vector<std::string> EntityRegistry::merge(const std::vector<std::string>& first,
+    const std::vector<std::string>& second) {
+    std::vector<std::string> result;
+    result.reserve(first.size() + second.size());
+    std::set_union(first.begin(), first.end(), second.begin(), second.end(), std::back_inserter(result));
+    return result;
+}
+
+std::vector<std::shared_ptr<Device>> EntityRegistry::searchDevices(const std::string& text, TextMatch mode) const {
+    std::vector<std::string> ids;
+    {
+        std::lock_guard<std::mutex> lock(deviceTextMutex);
+        ids = merge(deviceNames.find(text, mode), deviceManufacturers.find(text, mode));
+    }
+    std::vector<std::shared_ptr<Device>> result;
+    result.reserve(ids.size());
+    for (const auto& id : ids) {
+        // Устройство могли удалить из другого потока после поиска
+        if (auto device = devices.find(id)) {
+            result.push_back(device);
+        }
+    }
+    return result;
+}
+
+std::vector<std::shared_ptr<User>> EntityRegistry::searchUsers(const std::string& text, TextMatch mode) const {
+    std::vector<std::shared_ptr<User>> result;
+    for (const auto& id : merge(userNames.find(text, mode), userEmails.find(text, mode))) {
+        result.push_back(findUser(id));
+    }
+    return result;
+}
+
+void EntityRegistry::reserveDevices(size_t count) {
+    devices.reserve(count);
+}
+
+size_t EntityRegistry::getDeviceCount() const {
+    return devices.size();
+}
+
+std::vector<std::shared_ptr<Device>> EntityRegistry::snapshotDevices() const {
+    return devices.values();
+}
+
+void EntityRegistry::clear() {
+    rooms.clear();
+    devices.clear();
+    users.clear();
+    scenarios.clear();
+    {
+        std::lock_guard<std::mutex> lock(deviceTextMutex);
+        deviceNames.clear();
+        deviceManufacturers.clear();
+    }
+    userNames.clear();
+    userEmails.clear();
+}
@@ -0,0 +1,101 @@
+﻿#ifndef ENTITYREGISTRY_HPP
+#define ENTITYREGISTRY_HPP
+
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include "ShardedMap.hpp"
+#include "TextIndex.hpp"
+
+class Room;
+class Device;
+class User;
+class AutomationScenario;
+
+// Центральный реестр сущностей: поиск комнат, устройств, пользователей
+// и сценариев по ID за O(1) через хеш-таблицы.
+// Реестр не владеет сценариями - ими владеет SmartHomeSystem (unique_ptr).
+//
+// Методы реестра для устройств (поиск, добавление, удаление, обход) можно вызывать
+// из любых потоков (телеметрия, сценарии, отчеты): таблица устройств разделена на
+// части со своими блокировками чтения/записи, а найденное устройство возвращается
+// закрепленным (shared_ptr). Сами объекты Device потокобезопасными не являются:
+// каждое устройство меняет один поток, остальные его только читают, и чтение
+// мощности или типа одновременно с их изменением не синхронизировано.
+// Комнаты, пользователи и сценарии меняются только в основном потоке.
+//
+// Названия и производители устройств, имена и email пользователей дополнительно
+// индексируются для поиска по началу и по подстроке (TextIndex); индексы
+// устройств защищены своим мьютексом.
+//
+// ID уникальны: повторное добавление ID отклоняется. Новые ID выдает nextId -
+// наибольший номер, когда-либо встреченный реестром для префикса, плюс один,
+// поэтому ID удаленной записи не достается новой (и запись журнала об удалении
+// не может при повторе затронуть чужой объект)
+class EntityRegistry {
+private:
+    std::unordered_map<std::string, std::shared_ptr<Room>> rooms;
+    ShardedMap<std::string, std::shared_ptr<Device>> devices;
+    std::unordered_map<std::string, std::shared_ptr<User>> users;
+    std::unordered_map<std::string, AutomationScenario*> scenarios;
+
+    TextIndex deviceNames;
+    TextIndex deviceManufacturers;
+    mutable std::mutex deviceTextMutex;
+    TextIndex userNames;
+    TextIndex userEmails;
+
+    // Наибольший номер по префиксу ID ("DEV" для "DEV12"); не сбрасывается в clear()
+    std::unordered_map<std::string, uint64_t> lastIds;
+    std::mutex idMutex;
+
+    void noteId(const std::string& id);
+
+    // Объединение результатов двух индексов (ключи по возрастанию, без повторов)
+    static std::vector<std::string> merge(const std::vector<std::string>& first,
+        const std::vector<std::string>& second);
+
+public:
+    // false - запись с таким ID уже есть (сообщение в std::cerr)
+    bool addRoom(const std::shared_ptr<Room>& room);
+    bool addDevice(const std::shared_ptr<Device>& device);
+    bool addUser(const std::shared_ptr<User>& user);
+    bool addScenario(AutomationScenario* scenario);
+
+    // Следующий свободный ID вида prefix + номер
+    std::string nextId(const std::string& prefix);
+    // Учитывает ID, встреченный вне add* (например, в записях журнала)
+    void reserveId(const std::string& id);
+
+    void removeRoom(const std::string& id);
+    void removeDevice(const std::string& id);
+    void removeUser(const std::string& id);
+    void removeScenario(const std::string& id);
+
+    std::shared_ptr<Room> findRoom(const std::string& id) const;
+    std::shared_ptr<Device> findDevice(const std::string& id) const;
+    std::shared_ptr<User> findUser(const std::string& id) const;
+    AutomationScenario* findScenario(const std::string& id) const;
+
+    // Устройства, у которых название или производитель подходит под text,
+    // и пользователи по имени или email; порядок - по ID
+    std::vector<std::shared_ptr<Device>> searchDevices(const std::string& text, TextMatch mode) const;
+    std::vector<std::shared_ptr<User>> searchUsers(const std::string& text, TextMatch mode) const;
+
+    void reserveDevices(size_t count);
+    size_t getDeviceCount() const;
+    // Копия списка устройств для обработки в другом потоке (порядок не определен)
+    std::vector<std::shared_ptr<Device>> snapshotDevices() const;
+
+    // Обход устройств без копирования; func не должна менять реестр
+    template <typename Func>
+    void forEachDevice(Func func) const {
+        devices.forEach(func);
+    }
+    void clear();
+};
+
+#endif
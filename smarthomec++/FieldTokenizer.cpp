@@ -0,0 +1,111 @@
+﻿#include "FieldTokenizer.hpp"
+#include <charconv>
+
+FieldTokenizer::FieldTokenizer(std::string_view record, char separator)
+    : count(0), failedField(NO_FIELD), failure(nullptr) {
+    // Файлы, сохраненные в Windows и читаемые в двоичном режиме, оставляют '\r' в конце строки
+    if (!record.empty() && record.back() == '\r') {
+        record.remove_suffix(1);
+    }
+
+    size_t start = 0;
+    while (true) {
+        size_t end = record.find(separator, start);
+        if (end == std::string_view::npos) {
+            push(record.substr(start));
+            break;
+        }
+        push(record.substr(start, end - start));
+        start = end + 1;
+    }
+}
+
+void FieldTokenizer::push(std::string_view field) {
+    if (count < INLINE_FIELDS) {
+        inlineFields[count] = field;
+    }
+    else {
+        extraFields.push_back(field);
+    }
+    count++;
+}
+
+void FieldTokenizer::fail(size_t index, const char* reason) {
+    // Сохраняется только первая ошибка - она обычно и есть причина
+    if (failedField == NO_FIELD) {
+        failedField = index;
+        failure = reason;
+    }
+}
+
+size_t FieldTokenizer::size() const {
+    return count;
+}
+
+std::string_view FieldTokenizer::view(size_t index) const {
+    if (index >= count) return std::string_view();
+    return index < INLINE_FIELDS ? inlineFields[index] : extraFields[index - INLINE_FIELDS];
+}
+
+std::string FieldTokenizer::text(size_t index) const {
+    std::string_view field = view(index);
+    return std::string(field.data(), field.size());
+}
+
+bool FieldTokenizer::flag(size_t index) const {
+    return view(index) == "1";
+}
+
+template <typename T>
+bool FieldTokenizer::parseNumber(size_t index, T& out, const char* reason) {
+    if (index >= count) {
+        fail(index, "поле отсутствует");
+        return false;
+    }
+    std::string_view field = view(index);
+    const char* end = field.data() + field.size();
+    auto result = std::from_chars(field.data(), end, out);
+    if (result.ec == std::errc::result_out_of_range) {
+        fail(index, "число вне диапазона");
+        return false;
+    }
+    // Поле должно быть числом целиком: "25abc" - ошибка, а не 25
+    if (result.ec != std::errc() || result.ptr != end) {
+        fail(index, reason);
+        return false;
+    }
+    return true;
+}
+
+bool FieldTokenizer::getInt(size_t index, int& out) {
+    return parseNumber(index, out, "не целое число");
+}
+
+bool FieldTokenizer::getInt64(size_t index, int64_t& out) {
+    return parseNumber(index, out, "не целое число");
+}
+
+bool FieldTokenizer::getDouble(size_t index, double& out) {
+    return parseNumber(index, out, "не число");
+}
+
+bool FieldTokenizer::require(size_t expected) {
+    if (count < expected) {
+        fail(count, "недостаточно полей");
+        return false;
+    }
+    return true;
+}
+
+bool FieldTokenizer::ok() const {
+    return failedField == NO_FIELD;
+}
+
+size_t FieldTokenizer::errorField() const {
+    return failedField;
+}
+
+std::string FieldTokenizer::errorText() const {
+    if (ok()) return std::string();
+    return "поле " + std::to_string(failedField + 1) + ": " + failure;
+}
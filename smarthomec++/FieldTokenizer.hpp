@@ -0,0 +1,63 @@
+﻿#ifndef FIELDTOKENIZER_HPP
+#define FIELDTOKENIZER_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <cstdint>
+
+// Разбор строки текстового формата ("поле|поле|...") без копирования полей.
+//
+// Поля хранятся как string_view на исходную строку, поэтому строка должна
+// жить дольше токенизатора. Числа разбираются через std::from_chars без
+// выделения памяти. Вместо исключений запоминается первое поле с ошибкой:
+// после разбора достаточно проверить ok() и вывести errorText()
+class FieldTokenizer {
+public:
+    static const size_t NO_FIELD = static_cast<size_t>(-1);
+
+    explicit FieldTokenizer(std::string_view record, char separator = '|');
+
+    FieldTokenizer(const FieldTokenizer&) = delete;
+    FieldTokenizer& operator=(const FieldTokenizer&) = delete;
+
+    size_t size() const;
+
+    // Отсутствующее текстовое поле считается пустым (как у std::getline)
+    std::string_view view(size_t index) const;
+    std::string text(size_t index) const;
+    bool flag(size_t index) const;
+
+    bool getInt(size_t index, int& out);
+    bool getInt64(size_t index, int64_t& out);
+    bool getDouble(size_t index, double& out);
+
+    // Отмечает ошибку, если полей меньше count
+    bool require(size_t count);
+
+    bool ok() const;
+    size_t errorField() const;
+    // Например: "поле 8: не число"; номер поля считается с 1
+    std::string errorText() const;
+
+private:
+    static const size_t INLINE_FIELDS = 16;
+
+    // Первые поля хранятся во встроенном массиве; вектор нужен только
+    // для длинных записей (например, коды доступа SecurityDevice)
+    std::array<std::string_view, INLINE_FIELDS> inlineFields;
+    std::vector<std::string_view> extraFields;
+    size_t count;
+
+    size_t failedField;
+    const char* failure;
+
+    void push(std::string_view field);
+    void fail(size_t index, const char* reason);
+
+    template <typename T>
+    bool parseNumber(size_t index, T& out, const char* reason);
+};
+
+#endif
@@ -0,0 +1,162 @@
+﻿#include "Journal.hpp"
+#include <iostream>
+#include <fstream>
+
+namespace {
+
+// FNV-1a: простая контрольная сумма для обнаружения недописанных записей
+uint32_t checksum(const char* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void writeString(BinaryWriter& out, const std::string& value) {
+    out.write(static_cast<uint32_t>(value.size()));
+    out.writeBytes(value.data(), value.size());
+}
+
+bool readString(BinaryReader& in, std::string& value) {
+    uint32_t length = 0;
+    return in.read(length) && in.readString(value, length);
+}
+
+} // namespace
+
+Journal::Journal(const std::string& filePath)
+    : path(filePath), pendingCount(0), committedCount(0) {}
+
+void Journal::append(const JournalRecord& record) {
+    BinaryWriter body;
+    body.write(static_cast<uint8_t>(record.type));
+    writeString(body, record.entityId);
+    writeString(body, record.payload);
+    body.write(record.value);
+
+    pending.write(static_cast<uint32_t>(body.size()));
+    pending.writeBytes(body.data().data(), body.size());
+    pending.write(checksum(body.data().data(), body.size()));
+    pendingCount++;
+}
+
+bool Journal::commit() {
+    if (pendingCount == 0) return true;
+
+    if (!appendFile(path, pending.data().data(), pending.size())) {
+        return false;
+    }
+
+    committedCount += pendingCount;
+    pendingCount = 0;
+    pending.clear();
+    return true;
+}
+
+bool Journal::reset() {
+    if (!truncateFile(path)) {
+        return false;
+    }
+    committedCount = 0;
+    pendingCount = 0;
+    pending.clear();
+    return true;
+}
+
+std::vector<char> Journal::takePending() {
+    std::vector<char> records = pending.data();
+    committedCount += pendingCount;
+    pendingCount = 0;
+    pending.clear();
+    return records;
+}
+
+void Journal::markCheckpoint() {
+    committedCount = 0;
+}
+
+bool Journal::appendFile(const std::string& filePath, const char* data, size_t size) {
+    std::ofstream file(filePath, std::ios::binary | std::ios::app);
+    if (!file.is_open()) {
+        std::cerr << "Ошибка записи журнала: не удалось открыть " << filePath << std::endl;
+        return false;
+    }
+    file.write(data, static_cast<std::streamsize>(size));
+    file.flush();
+    if (!file.good()) {
+        std::cerr << "Ошибка записи журнала: " << filePath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Journal::truncateFile(const std::string& filePath) {
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Ошибка очистки журнала: не удалось открыть " << filePath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Journal::readAll(std::vector<JournalRecord>& records) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return true;  // журнала еще нет - нечего применять
+    }
+
+    std::streamsize fileSize = file.tellg();
+    std::vector<char> buffer(fileSize > 0 ? static_cast<size_t>(fileSize) : 0);
+    file.seekg(0);
+    if (!buffer.empty() && !file.read(buffer.data(), fileSize)) {
+        std::cerr << "Ошибка чтения журнала: " << path << std::endl;
+        return false;
+    }
+    file.close();
+
+    BinaryReader in(buffer.data(), buffer.size());
+    size_t validBytes = 0;
+    while (in.remaining() > 0) {
+        uint32_t bodySize = 0;
+        if (!in.read(bodySize) || in.remaining() < static_cast<size_t>(bodySize) + sizeof(uint32_t)) break;
+
+        const char* body = in.current();
+        in.skip(bodySize);
+        uint32_t storedChecksum = 0;
+        in.read(storedChecksum);
+        if (storedChecksum != checksum(body, bodySize)) break;
+
+        BinaryReader bodyReader(body, bodySize);
+        uint8_t type = 0;
+        std::string entityId, payload;
+        int32_t value = 0;
+        if (!bodyReader.read(type) || !readString(bodyReader, entityId) ||
+            !readString(bodyReader, payload) || !bodyReader.read(value)) {
+            break;
+        }
+
+        records.emplace_back(static_cast<JournalRecordType>(type), entityId, payload, value);
+        validBytes = in.offset();
+    }
+
+    // Отбрасываем недописанный хвост, чтобы новые записи не оказались после мусора
+    if (validBytes < buffer.size()) {
+        std::cerr << "Журнал повреждён после записи " << records.size()
+            << ", хвост отброшен" << std::endl;
+        std::ofstream repaired(path, std::ios::binary | std::ios::trunc);
+        repaired.write(buffer.data(), static_cast<std::streamsize>(validBytes));
+    }
+
+    committedCount = records.size();
+    return true;
+}
+
+size_t Journal::size() const {
+    return committedCount + pendingCount;
+}
+
+bool Journal::hasPending() const {
+    return pendingCount > 0;
+}
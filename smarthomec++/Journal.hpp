@@ -0,0 +1,74 @@
+﻿#ifndef JOURNAL_HPP
+#define JOURNAL_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "BinaryIO.hpp"
+
+// Типы записей журнала изменений
+enum class JournalRecordType : uint8_t {
+    DEVICE_STATE = 1,       // entityId, value = 1 (вкл) / 0 (выкл)
+    DEVICE_ADD = 2,         // payload = Device::serialize()
+    DEVICE_REMOVE = 3,      // entityId
+    ROOM_ADD = 4,           // payload = Room::serialize()
+    ROOM_REMOVE = 5,        // entityId
+    USER_ADD = 6,           // payload = User::serialize()
+    USER_REMOVE = 7,        // entityId
+    USER_ACCESS = 8,        // entityId, value = AccessLevel
+    NOTIFICATION_READ = 9,  // entityId
+    SCENARIO_ADD = 10,      // payload = AutomationScenario::serialize()
+    SCENARIO_STATE = 11     // entityId, value = 1 (активен) / 0
+};
+
+struct JournalRecord {
+    JournalRecordType type;
+    std::string entityId;
+    std::string payload;
+    int32_t value;
+
+    JournalRecord(JournalRecordType recordType, const std::string& id,
+        const std::string& data = "", int32_t recordValue = 0)
+        : type(recordType), entityId(id), payload(data), value(recordValue) {}
+};
+
+// Журнал упреждающей записи (write-ahead log).
+//
+// Изменения добавляются в буфер через append() и записываются в конец файла
+// одной операцией в commit() (групповая фиксация). После сохранения полного
+// снимка (контрольной точки) журнал очищается через reset().
+//
+// Формат записи: uint32 длина тела, тело (uint8 тип, строка id, строка payload,
+// int32 value; строки - uint32 длина + байты), uint32 контрольная сумма тела.
+// Недописанный или повреждённый хвост файла при чтении отбрасывается
+class Journal {
+private:
+    std::string path;
+    BinaryWriter pending;
+    size_t pendingCount;
+    size_t committedCount;
+
+public:
+    explicit Journal(const std::string& filePath);
+
+    void append(const JournalRecord& record);
+    bool commit();
+    bool reset();
+
+    // Для записи в фоновом потоке (см. PersistenceWorker): накопленные записи
+    // забираются в закодированном виде и считаются зафиксированными
+    std::vector<char> takePending();
+    // Сброс счетчика после передачи снимка на запись; файл очищает фоновый поток
+    void markCheckpoint();
+
+    static bool appendFile(const std::string& filePath, const char* data, size_t size);
+    static bool truncateFile(const std::string& filePath);
+
+    // Чтение всех целых записей для повторного применения при запуске
+    bool readAll(std::vector<JournalRecord>& records);
+
+    size_t size() const;
+    bool hasPending() const;
+};
+
+#endif
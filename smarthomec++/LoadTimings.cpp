@@ -0,0 +1,28 @@
+﻿#include "LoadTimings.hpp"
+#include <sstream>
+#include <iomanip>
+
+LoadTimings::LoadTimings() : started(std::chrono::steady_clock::now()) {}
+
+void LoadTimings::record(const std::string& name, double milliseconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    stages.push_back({ name, milliseconds });
+}
+
+double LoadTimings::totalMilliseconds() const {
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - started;
+    return elapsed.count();
+}
+
+std::string LoadTimings::summary() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    for (size_t i = 0; i < stages.size(); ++i) {
+        if (i > 0) ss << ", ";
+        ss << stages[i].name << " " << stages[i].milliseconds << " мс";
+    }
+    if (!stages.empty()) ss << "; ";
+    ss << "всего " << totalMilliseconds() << " мс";
+    return ss.str();
+}
@@ -0,0 +1,49 @@
+﻿#ifndef LOADTIMINGS_HPP
+#define LOADTIMINGS_HPP
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+
+// Время этапов загрузки данных.
+// Этапы выполняются в разных потоках, поэтому запись защищена мьютексом
+class LoadTimings {
+private:
+    struct Stage {
+        std::string name;
+        double milliseconds;
+    };
+
+    std::vector<Stage> stages;
+    mutable std::mutex mutex;
+    std::chrono::steady_clock::time_point started;
+
+public:
+    LoadTimings();
+
+    void record(const std::string& name, double milliseconds);
+
+    // Выполняет f() и записывает время под именем name
+    template <typename F>
+    auto measure(const std::string& name, F&& f) -> decltype(f()) {
+        struct Guard {
+            LoadTimings& timings;
+            const std::string& name;
+            std::chrono::steady_clock::time_point start;
+            ~Guard() {
+                std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+                timings.record(name, elapsed.count());
+            }
+        } guard{ *this, name, std::chrono::steady_clock::now() };
+        return f();
+    }
+
+    // Время с момента создания объекта
+    double totalMilliseconds() const;
+
+    // "комнаты 0.4 мс, устройства 2.1 мс, ...; всего 3.0 мс"
+    std::string summary() const;
+};
+
+#endif
@@ -11,6 +11,8 @@
 #include <algorithm>
 #include <stdexcept>
 #include <functional>
+#include <future>
+#include <thread>
 #include "room.hpp"
 #include "device.hpp"
 #include "climateDevice.hpp"
@@ -24,6 +26,22 @@
 #include "notificationType.hpp"
 #include "energyReport.hpp"
 #include "activity.hpp"
+#include "Snapshot.hpp"
+#include "Journal.hpp"
+#include "EntityRegistry.hpp"
+#include "DeviceFactory.hpp"
+#include "TextLoader.hpp"
+#include "LoadTimings.hpp"
+#include "PersistenceWorker.hpp"
+#include "NotificationArchive.hpp"
+#include "DeviceStateTable.hpp"
+#include "ObjectPool.hpp"
+#include "TelemetryPipeline.hpp"
+#include "DeviceGroups.hpp"
+#include "DeviceManager.hpp"
+#include "DeviceQuery.hpp"
+#include "Cursor.hpp"
+#include "ParallelBenchmark.hpp"
 using namespace std;
 
 void setRussianLocale() {
@@ -32,19 +50,6 @@ void setRussianLocale() {
     setlocale(LC_ALL, "Russian");
 }
 
-// Функции для сортировки
-bool compareByPowerAsc(const shared_ptr<Device>& a, const shared_ptr<Device>& b) {
-    return a->getPowerConsumption() < b->getPowerConsumption();
-}
-
-bool compareByPowerDesc(const shared_ptr<Device>& a, const shared_ptr<Device>& b) {
-    return a->getPowerConsumption() > b->getPowerConsumption();
-}
-
-bool compareByNameAsc(const shared_ptr<Device>& a, const shared_ptr<Device>& b) {
-    return a->getName() < b->getName();
-}
-
 // Функция-предикат для поиска устройств в комнате
 bool deviceInRoom(const shared_ptr<Device>& device, const string& roomName) {
     auto location = device->getLocation();
@@ -56,6 +61,20 @@ bool deviceByManufacturer(const shared_ptr<Device>& device, const string& manufa
     return device->getManufacturer() == manufacturer;
 }
 
+// Дата и время для вывода в меню
+string formatTimestamp(time_t timestamp) {
+    char buffer[80];
+#ifdef _WIN32
+    struct tm info;
+    localtime_s(&info, &timestamp);
+    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M", &info);
+#else
+    struct tm* info = localtime(&timestamp);
+    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M", info);
+#endif
+    return buffer;
+}
+
 class DataManager {
 private:
     static const string ROOMS_FILE;
@@ -63,8 +82,149 @@ private:
     static const string USERS_FILE;
     static const string SCENARIOS_FILE;
     static const string NOTIFICATIONS_FILE;
+    static const string SNAPSHOT_FILE;
+    static const string JOURNAL_FILE;
+    static const string ARCHIVE_FILE;
 
 public:
+    static string journalPath() {
+        return JOURNAL_FILE;
+    }
+
+    static string snapshotPath() {
+        return SNAPSHOT_FILE;
+    }
+
+    static string archivePath() {
+        return ARCHIVE_FILE;
+    }
+
+    // Бинарный снимок - основной формат хранения
+    static bool hasSnapshot() {
+        return Snapshot::exists(SNAPSHOT_FILE);
+    }
+
+    static bool saveSnapshot(const vector<shared_ptr<Room>>& rooms,
+        const vector<shared_ptr<Device>>& devices,
+        const vector<shared_ptr<User>>& users,
+        const vector<unique_ptr<AutomationScenario>>& scenarios,
+        const vector<unique_ptr<Notification>>& notifications,
+        SnapshotCache* cache = nullptr) {
+        return Snapshot::save(SNAPSHOT_FILE, rooms, devices, users, scenarios, notifications, cache);
+    }
+
+    // Образ снимка для записи в фоновом потоке; false - ничего не изменилось
+    static bool encodeSnapshot(const vector<shared_ptr<Room>>& rooms,
+        const vector<shared_ptr<Device>>& devices,
+        const vector<shared_ptr<User>>& users,
+        const vector<unique_ptr<AutomationScenario>>& scenarios,
+        const vector<unique_ptr<Notification>>& notifications,
+        SnapshotCache& cache, vector<char>& image) {
+        return Snapshot::encode(rooms, devices, users, scenarios, notifications, cache, image);
+    }
+
+    static bool loadSnapshot(SnapshotData& data, EntityRegistry& registry, LoadTimings* timings = nullptr) {
+        return Snapshot::load(SNAPSHOT_FILE, data, registry, timings);
+    }
+
+    // Загрузка текстовых .dat файлов с учетом зависимостей.
+    //
+    // Комнаты, устройства, пользователи и сценарии читаются одновременно:
+    // устройства разбираются без комнат (DeviceFactory::parse) и привязываются,
+    // как только готовы комнаты. Уведомления ссылаются на устройства и сценарии,
+    // поэтому читаются последними. Реестр заполняется только в этом потоке
+    static void loadText(SnapshotData& data, EntityRegistry& registry, LoadTimings& timings) {
+        auto rooms = async(launch::async, [&timings]() {
+            return timings.measure("комнаты", []() { return readLines<shared_ptr<Room>>(ROOMS_FILE, Room::deserialize); });
+        });
+        auto devices = async(launch::async, [&timings]() {
+            return timings.measure("устройства", []() {
+                return readLines<DeviceFactory::PendingDevice>(DEVICES_FILE, DeviceFactory::parse);
+            });
+        });
+        auto users = async(launch::async, [&timings]() {
+            return timings.measure("пользователи", []() { return readLines<shared_ptr<User>>(USERS_FILE, User::deserialize); });
+        });
+        auto scenarios = async(launch::async, [&timings]() {
+            return timings.measure("сценарии", []() {
+                return readLines<unique_ptr<AutomationScenario>>(SCENARIOS_FILE, AutomationScenario::deserialize);
+            });
+        });
+
+        // Записи с повторяющимся ID отбрасываются (реестр сообщает о них сам)
+        for (auto& room : rooms.get()) {
+            if (registry.addRoom(room)) {
+                data.rooms.push_back(move(room));
+            }
+        }
+
+        auto pending = devices.get();
+        timings.measure("привязка устройств", [&]() {
+            linkDevices(pending, data.devices, registry);
+        });
+
+        for (auto& user : users.get()) {
+            if (registry.addUser(user)) {
+                data.users.push_back(move(user));
+            }
+        }
+
+        for (auto& scenario : scenarios.get()) {
+            if (registry.addScenario(scenario.get())) {
+                data.scenarios.push_back(move(scenario));
+            }
+        }
+
+        data.notifications = timings.measure("уведомления", [&registry]() {
+            return loadNotifications(registry);
+        });
+    }
+
+    // Текстовые .dat файлы остаются форматом импорта/экспорта
+    static void exportToText(const vector<shared_ptr<Room>>& rooms,
+        const vector<shared_ptr<Device>>& devices,
+        const vector<shared_ptr<User>>& users,
+        const vector<unique_ptr<AutomationScenario>>& scenarios,
+        const vector<unique_ptr<Notification>>& notifications) {
+        saveRooms(rooms);
+        saveDevices(devices);
+        saveUsers(users);
+        saveScenarios(scenarios);
+        saveNotifications(notifications);
+    }
+
+    // Конвертер: текстовые .dat файлы -> бинарный снимок
+    static bool convertTextToSnapshot() {
+        SnapshotData data;
+        EntityRegistry registry;
+        LoadTimings timings;
+        loadText(data, registry, timings);
+        return saveSnapshot(data.rooms, data.devices, data.users, data.scenarios, data.notifications);
+    }
+
+    // Конвертер: бинарный снимок -> текстовые .dat файлы.
+    // В notifications.dat попадает вся история, включая архив
+    static bool convertSnapshotToText() {
+        SnapshotData data;
+        EntityRegistry registry;
+        if (!hasSnapshot() || !loadSnapshot(data, registry)) {
+            return false;
+        }
+
+        NotificationArchive archive(ARCHIVE_FILE);
+        vector<unique_ptr<Notification>> history;
+        if (!archive.open() || !archive.loadAll(registry, history)) {
+            return false;
+        }
+        archive.dropArchived(data.notifications);
+        for (auto& notification : data.notifications) {
+            history.push_back(move(notification));
+        }
+
+        exportToText(data.rooms, data.devices, data.users, data.scenarios, history);
+        return true;
+    }
+
     static void saveRooms(const vector<shared_ptr<Room>>& rooms) {
         ofstream file(ROOMS_FILE);
         if (file.is_open()) {
@@ -75,22 +235,12 @@ public:
         }
     }
 
-    static vector<shared_ptr<Room>> loadRooms() {
-        vector<shared_ptr<Room>> rooms;
-        ifstream file(ROOMS_FILE);
-        if (file.is_open()) {
-            string line;
-            while (getline(file, line)) {
-                if (!line.empty()) {
-                    auto room = Room::deserialize(line);
-                    if (room) {
-                        rooms.push_back(room);
-                    }
-                }
-            }
-            file.close();
-        }
-        return rooms;
+    // Все строки файла, разобранные parse (параллельно, см. TextLoader)
+    template <typename T, typename Parse>
+    static vector<T> readLines(const string& path, Parse parse) {
+        vector<T> items;
+        TextLoader::load(path, items, parse);
+        return items;
     }
 
     static void saveDevices(const vector<shared_ptr<Device>>& devices) {
@@ -103,41 +253,29 @@ public:
         }
     }
 
-    static vector<shared_ptr<Device>> loadDevices(const vector<shared_ptr<Room>>& rooms) {
-        vector<shared_ptr<Device>> devices;
-        ifstream file(DEVICES_FILE);
-        if (file.is_open()) {
-            string line;
-            while (getline(file, line)) {
-                if (!line.empty()) {
-                    stringstream ss(line);
-                    string temp, locationId;
-                    getline(ss, temp, '|');
-                    getline(ss, temp, '|');
-                    getline(ss, temp, '|');
-                    getline(ss, temp, '|');
-                    getline(ss, locationId, '|');
-
-                    shared_ptr<Room> location = nullptr;
-                    for (auto& room : rooms) {
-                        if (room->getId() == locationId) {
-                            location = room;
-                            break;
-                        }
-                    }
+    // Разбор строки устройства с привязкой к комнате (используется при загрузке и в журнале)
+    static shared_ptr<Device> parseDevice(const string& line, const EntityRegistry& registry) {
+        auto device = DeviceFactory::create(line, registry);
+        if (device) {
+            device->getLocation()->addDevice(device);
+        }
+        return device;
+    }
 
-                    if (location) {
-                        auto device = Device::deserialize(line, location);
-                        if (device) {
-                            devices.push_back(device);
-                            location->addDevice(device);
-                        }
-                    }
-                }
-            }
-            file.close();
+    // Привязка разобранных устройств к комнатам в порядке файла.
+    // Устройства без существующей комнаты, как и раньше, не загружаются
+    static void linkDevices(vector<DeviceFactory::PendingDevice>& pending,
+        vector<shared_ptr<Device>>& devices, EntityRegistry& registry) {
+        devices.reserve(pending.size());
+        registry.reserveDevices(pending.size());
+        for (auto& item : pending) {
+            auto location = registry.findRoom(item.roomId);
+            if (!location || !registry.addDevice(item.device)) continue;
+
+            item.device->setLocation(location);
+            location->addDevice(item.device);
+            devices.push_back(move(item.device));
         }
-        return devices;
     }
 
     static void saveUsers(const vector<shared_ptr<User>>& users) {
@@ -150,24 +288,6 @@ public:
         }
     }
 
-    static vector<shared_ptr<User>> loadUsers() {
-        vector<shared_ptr<User>> users;
-        ifstream file(USERS_FILE);
-        if (file.is_open()) {
-            string line;
-            while (getline(file, line)) {
-                if (!line.empty()) {
-                    auto user = User::deserialize(line);
-                    if (user) {
-                        users.push_back(user);
-                    }
-                }
-            }
-            file.close();
-        }
-        return users;
-    }
-
     static void saveScenarios(const vector<unique_ptr<AutomationScenario>>& scenarios) {
         ofstream file(SCENARIOS_FILE);
         if (file.is_open()) {
@@ -178,21 +298,6 @@ public:
         }
     }
 
-    static vector<unique_ptr<AutomationScenario>> loadScenarios() {
-        vector<unique_ptr<AutomationScenario>> scenarios;
-        ifstream file(SCENARIOS_FILE);
-        if (file.is_open()) {
-            string line;
-            while (getline(file, line)) {
-                if (!line.empty()) {
-                    scenarios.push_back(AutomationScenario::deserialize(line));
-                }
-            }
-            file.close();
-        }
-        return scenarios;
-    }
-
     static void saveNotifications(const vector<unique_ptr<Notification>>& notifications) {
         ofstream file(NOTIFICATIONS_FILE);
         if (file.is_open()) {
@@ -203,18 +308,14 @@ public:
         }
     }
 
-    static vector<unique_ptr<Notification>> loadNotifications() {
+    // Связи уведомлений с устройствами и сценариями восстанавливаются через реестр,
+    // поэтому уведомления загружаются последними
+    static vector<unique_ptr<Notification>> loadNotifications(const EntityRegistry& registry) {
         vector<unique_ptr<Notification>> notifications;
-        ifstream file(NOTIFICATIONS_FILE);
-        if (file.is_open()) {
-            string line;
-            while (getline(file, line)) {
-                if (!line.empty()) {
-                    notifications.push_back(Notification::deserialize(line));
-                }
-            }
-            file.close();
-        }
+        // Реестр здесь только читается, поэтому доступен из всех потоков разбора
+        TextLoader::load(NOTIFICATIONS_FILE, notifications, [&registry](const string& line) {
+            return Notification::deserialize(line, &registry);
+        });
         return notifications;
     }
 
@@ -242,16 +343,59 @@ const string DataManager::DEVICES_FILE = "devices.dat";
 const string DataManager::USERS_FILE = "users.dat";
 const string DataManager::SCENARIOS_FILE = "scenarios.dat";
 const string DataManager::NOTIFICATIONS_FILE = "notifications.dat";
+const string DataManager::SNAPSHOT_FILE = "smarthome.snap";
+const string DataManager::JOURNAL_FILE = "smarthome.journal";
+const string DataManager::ARCHIVE_FILE = "smarthome.archive";
 
 class SmartHomeSystem {
 private:
     vector<shared_ptr<Room>> rooms;
-    vector<shared_ptr<Device>> devices;
     vector<shared_ptr<User>> users;
     vector<unique_ptr<AutomationScenario>> scenarios;
     vector<unique_ptr<Notification>> notifications;
     vector<unique_ptr<EnergyReport>> reports;
     shared_ptr<User> currentUser;
+    EntityRegistry registry;
+    Journal journal;
+    // Закодированные сегменты прошлого сохранения: неизмененные не кодируются заново
+    SnapshotCache snapshotCache;
+    // Запись на диск выполняется в фоне, обработчики меню ее не ждут
+    PersistenceWorker persistence;
+    // Старые уведомления: в памяти только индекс, сегменты читаются по требованию
+    NotificationArchive archive;
+    // Показания датчиков из других потоков; применяются в основном цикле
+    TelemetryPipeline telemetry;
+    // Единственный список устройств системы (комнаты ими не владеют, а только
+    // ссылаются на слоты) с индексами по названию, производителю и мощности
+    DeviceManager<Device> deviceManager;
+    // Устройства по классам для сводки эффективности; повторяет deviceManager
+    DeviceGroups deviceGroups;
+
+    // Сколько записей журнала допускается до полного сохранения снимка
+    static const size_t CHECKPOINT_INTERVAL = 256;
+    // Сколько строк выводят списки за один раз
+    static const size_t LIST_PAGE_SIZE = 20;
+
+    // Выводит список страницами через Cursor: номера строк сквозные, поэтому по ним
+    // можно выбирать запись после вывода. Следующая страница - по запросу
+    template <typename Container, typename KeyOf, typename Row>
+    void printPaged(const Container& items, KeyOf keyOf, Row row) {
+        auto cursor = makeCursor(items, keyOf, LIST_PAGE_SIZE);
+        size_t shown = 0;
+        auto counted = [&shown, &row](size_t number, const typename Container::value_type& item) {
+            row(number, *item);
+            shown = number;
+        };
+        string token = cursor.page("", counted);
+        while (!token.empty()) {
+            cout << "Показано " << shown << " из " << items.size()
+                << ". Следующая страница? (1 - да, 0 - нет): ";
+            int more;
+            cin >> more;
+            if (more != 1) break;
+            token = cursor.page(token, counted);
+        }
+    }
 
     void displayScenariosMenu() {
         cout << "\n=== СЦЕНАРИИ АВТОМАТИЗАЦИИ ===" << endl;
@@ -270,7 +414,8 @@ private:
         cout << "2. Добавить пользователя" << endl;
         cout << "3. Удалить пользователя" << endl;
         cout << "4. Изменить права доступа" << endl;
-        cout << "5. Назад в главное меню" << endl;
+        cout << "5. Поиск пользователей" << endl;
+        cout << "6. Назад в главное меню" << endl;
         cout << "Выберите опцию: ";
     }
 
@@ -314,7 +459,10 @@ private:
         cout << "5. Поиск устройств по производителю" << endl;
         cout << "6. Поиск устройства по названию" << endl;
         cout << "7. Поиск устройств с потреблением выше порога" << endl;
-        cout << "8. Назад в главное меню" << endl;
+        cout << "8. Поиск по нескольким условиям" << endl;
+        cout << "9. Поиск по началу или части названия/производителя" << endl;
+        cout << "10. Замер порога параллельной обработки" << endl;
+        cout << "11. Назад в главное меню" << endl;
         cout << "Выберите опцию: ";
     }
 
@@ -323,12 +471,16 @@ private:
         cout << "1. Показать все уведомления" << endl;
         cout << "2. Показать непрочитанные" << endl;
         cout << "3. Отметить как прочитанное" << endl;
-        cout << "4. Назад в главное меню" << endl;
+        cout << "4. Архив уведомлений" << endl;
+        cout << "5. Назад в главное меню" << endl;
         cout << "Выберите опцию: ";
     }
 
 public:
-    SmartHomeSystem() : currentUser(nullptr) {
+    SmartHomeSystem() : currentUser(nullptr), journal(DataManager::journalPath()),
+        persistence(DataManager::snapshotPath(), DataManager::journalPath()),
+        archive(DataManager::archivePath()), deviceManager("Поиск") {
+        deviceManager.enableIndexes();
         loadData();
     }
 
@@ -341,30 +493,38 @@ public:
         cout << "Загрузка данных..." << endl;
 
         try {
-            auto loadedRooms = DataManager::loadRooms();
-            for (auto& room : loadedRooms) {
-                rooms.push_back(move(room));
-            }
-
-            devices = DataManager::loadDevices(rooms);
-
-            auto loadedUsers = DataManager::loadUsers();
-            for (auto& user : loadedUsers) {
-                users.push_back(move(user));
-            }
-
-            auto loadedScenarios = DataManager::loadScenarios();
-            for (auto& scenario : loadedScenarios) {
-                scenarios.push_back(move(scenario));
+            LoadTimings timings;
+            PoolStats poolBefore = ObjectPool::stats();
+            SnapshotData snapshot;
+            if (!DataManager::hasSnapshot() || !DataManager::loadSnapshot(snapshot, registry, &timings)) {
+                // Снимка еще нет (или он поврежден) - импортируем данные из текстовых файлов
+                snapshot = SnapshotData();
+                registry.clear();
+                DataManager::loadText(snapshot, registry, timings);
             }
+            rooms = move(snapshot.rooms);
+            users = move(snapshot.users);
+            stable_sort(users.begin(), users.end(), usernameLess);
+            scenarios = move(snapshot.scenarios);
+            notifications = move(snapshot.notifications);
+
+            deviceManager.assignDevices(snapshot.devices);
+            deviceGroups.assign(snapshot.devices);
+            timings.measure("журнал", [this]() { replayJournal(); });
+            timings.measure("архив уведомлений", [this]() {
+                archive.open();
+                archive.dropArchived(notifications);
+            });
+            cout << "Время загрузки: " << timings.summary() << endl;
 
-            auto loadedNotifications = DataManager::loadNotifications();
-            for (auto& notification : loadedNotifications) {
-                notifications.push_back(move(notification));
+            PoolStats pool = ObjectPool::stats() - poolBefore;
+            if (pool.allocations > 0) {
+                cout << "Размещено из пула: " << pool.allocations << " объектов, блоков из кучи: "
+                    << pool.blocks << " (без обращения к куче: " << pool.avoided() << ")" << endl;
             }
 
             // Если все файлы пустые, это первый запуск
-            if (users.empty() && rooms.empty() && devices.empty()) {
+            if (users.empty() && rooms.empty() && deviceManager.isEmpty()) {
                 // Первый запуск - ничего не делаем, не создаем файлы
                 // Не вызываем initializeDefaultData вообще
             }
@@ -378,19 +538,202 @@ public:
         }
     }
 
+    // Сохранение с ожиданием записи на диск (пункт меню и выход из программы)
     void saveData() {
         cout << "Сохранение данных..." << endl;
-        DataManager::saveRooms(rooms);
-        DataManager::saveDevices(devices);
-        DataManager::saveUsers(users);
-        DataManager::saveScenarios(scenarios);
-        DataManager::saveNotifications(notifications);
-        cout << "Данные сохранены!" << endl;
+        telemetry.drain();
+        persistence.submitJournal(journal.takePending());
+        if (!persistence.flush()) {
+            // Прошлая фоновая запись не удалась - кодируем снимок заново целиком
+            snapshotCache.clear();
+        }
+        requestCheckpoint();
+        if (persistence.flush()) {
+            cout << "Данные сохранены!" << endl;
+        }
+        else {
+            cout << "Не удалось сохранить данные!" << endl;
+        }
+    }
+
+    // Передача снимка фоновому потоку; журнал он очистит после записи снимка.
+    // Кодируются только измененные сегменты, поэтому вызов дешевле самой записи
+    void requestCheckpoint() {
+        archiveNotifications();
+        vector<char> image;
+        if (DataManager::encodeSnapshot(rooms, deviceManager.getAllDevices(), users, scenarios, notifications, snapshotCache, image)) {
+            persistence.submitSnapshot(move(image));
+        }
+        journal.markCheckpoint();
+    }
+
+    // Старые уведомления переносятся в архив до кодирования снимка. Сегменты пишет
+    // фоновый поток, и всегда раньше снимка, который их уже не содержит
+    void archiveNotifications() {
+        size_t count = NotificationArchive::archivableCount(notifications.size());
+        if (count > 0) {
+            ArchiveBatch batch;
+            archive.prepareAppend(notifications, count, batch);
+            persistence.submitArchive(move(batch));
+            notifications.erase(notifications.begin(), notifications.begin() + count);
+        }
+    }
+
+    // Фиксация накопленных изменений дозаписью в журнал в фоновом потоке.
+    // Полный снимок пишется только когда журнал становится слишком длинным
+    void commitChanges() {
+        persistence.submitJournal(journal.takePending());
+        if (journal.size() >= CHECKPOINT_INTERVAL) {
+            requestCheckpoint();
+        }
+    }
+
+    // Повторное применение изменений, записанных после последнего снимка.
+    // Записи идемпотентны: состояние задается значением, а не переключением, добавление
+    // существующего ID пропускается, а ID не выдаются повторно (EntityRegistry::nextId).
+    // Поэтому сбой между записью снимка и очисткой журнала безопасен
+    void replayJournal() {
+        vector<JournalRecord> records;
+        if (!journal.readAll(records) || records.empty()) {
+            return;
+        }
+
+        for (const auto& record : records) {
+            applyJournalRecord(record);
+        }
+        cout << "Применено изменений из журнала: " << records.size() << endl;
+    }
+
+    void applyJournalRecord(const JournalRecord& record) {
+        // ID из журнала не выдаются повторно, даже если запись уже удалена
+        registry.reserveId(record.entityId);
+        switch (record.type) {
+        case JournalRecordType::DEVICE_STATE: {
+            // Только флаг: turnOn() климатического устройства еще и меняет температуру
+            auto device = findDeviceById(record.entityId);
+            if (device) {
+                device->restoreState(record.value != 0, device->getIsOnline());
+            }
+            break;
+        }
+        case JournalRecordType::DEVICE_ADD:
+            if (!findDeviceById(record.entityId)) {
+                auto device = DataManager::parseDevice(record.payload, registry);
+                if (device && registry.addDevice(device)) {
+                    deviceManager.addDevice(device);
+                    deviceGroups.add(device.get());
+                }
+            }
+            break;
+        case JournalRecordType::DEVICE_REMOVE: {
+            auto device = findDeviceById(record.entityId);
+            if (device) {
+                if (device->getLocation()) {
+                    device->getLocation()->removeDevice(device);
+                }
+                registry.removeDevice(record.entityId);
+                deviceManager.detachDevice(*device);
+                deviceGroups.remove(device.get());
+            }
+            break;
+        }
+        case JournalRecordType::ROOM_ADD:
+            if (!findRoomById(record.entityId)) {
+                auto room = Room::deserialize(record.payload);
+                if (room && registry.addRoom(room)) {
+                    rooms.push_back(room);
+                }
+            }
+            break;
+        case JournalRecordType::ROOM_REMOVE: {
+            auto room = findRoomById(record.entityId);
+            if (room) {
+                rooms.erase(find(rooms.begin(), rooms.end(), room));
+                registry.removeRoom(record.entityId);
+            }
+            break;
+        }
+        case JournalRecordType::USER_ADD:
+            if (!findUserById(record.entityId)) {
+                auto user = User::deserialize(record.payload);
+                if (user && registry.addUser(user)) {
+                    insertUser(user);
+                }
+            }
+            break;
+        case JournalRecordType::USER_REMOVE: {
+            auto user = findUserById(record.entityId);
+            if (user) {
+                users.erase(find(users.begin(), users.end(), user));
+                registry.removeUser(record.entityId);
+            }
+            break;
+        }
+        case JournalRecordType::USER_ACCESS: {
+            auto user = findUserById(record.entityId);
+            if (user) {
+                user->setAccessLevel(static_cast<AccessLevel>(record.value));
+            }
+            break;
+        }
+        case JournalRecordType::NOTIFICATION_READ:
+            for (auto& notification : notifications) {
+                if (notification->getNotificationId() == record.entityId && !notification->getIsRead()) {
+                    notification->markAsRead();
+                }
+            }
+            break;
+        case JournalRecordType::SCENARIO_ADD:
+            if (!findScenarioById(record.entityId)) {
+                auto scenario = AutomationScenario::deserialize(record.payload);
+                if (scenario && registry.addScenario(scenario.get())) {
+                    scenarios.push_back(move(scenario));
+                }
+            }
+            break;
+        case JournalRecordType::SCENARIO_STATE: {
+            auto scenario = findScenarioById(record.entityId);
+            bool active = record.value != 0;
+            if (scenario && scenario->getIsActive() != active) {
+                if (active) scenario->activate();
+                else scenario->deactivate();
+            }
+            break;
+        }
+        }
+    }
+
+    shared_ptr<Device> findDeviceById(const string& id) const {
+        return registry.findDevice(id);
+    }
+
+    shared_ptr<Room> findRoomById(const string& id) const {
+        return registry.findRoom(id);
+    }
+
+    shared_ptr<User> findUserById(const string& id) const {
+        return registry.findUser(id);
+    }
+
+    // users хранится по алфавиту логинов (ключ сортировки), поэтому список
+    // пользователей и номера для выбора идут в этом порядке
+    static bool usernameLess(const shared_ptr<User>& a, const shared_ptr<User>& b) {
+        return a->getUsernameKey() < b->getUsernameKey();
+    }
+
+    void insertUser(const shared_ptr<User>& user) {
+        users.insert(upper_bound(users.begin(), users.end(), user, usernameLess), user);
+    }
+
+    AutomationScenario* findScenarioById(const string& id) const {
+        return registry.findScenario(id);
     }
 
     void cleanup() {
+        registry.clear();
         rooms.clear();
-        devices.clear();
+        deviceManager.assignDevices({});
+        deviceGroups.clear();
         users.clear();
         scenarios.clear();
         notifications.clear();
@@ -439,43 +782,37 @@ public:
 
     // НОВЫЙ РАЗДЕЛ: ФУНКЦИИ СОРТИРОВКИ И ПОИСКА
 
-    void sortDevicesByPowerAsc() {
-        vector<shared_ptr<Device>> sortedDevices = devices;
-        sort(sortedDevices.begin(), sortedDevices.end(), compareByPowerAsc);
+    // Строка списка; порядок задают сортированные представления deviceManager,
+    // сам список устройств не копируется и не переупорядочивается
+    static void printSortedDevice(size_t number, const Device& device) {
+        Room* location = device.getLocation();
+        cout << number << ". " << device.getName()
+            << " - " << device.getPowerConsumption() << " Вт"
+            << " - Комната: " << (location ? location->getName() : "Нет") << endl;
+    }
 
+    void sortDevicesByPowerAsc() {
         cout << "\n=== УСТРОЙСТВА ОТСОРТИРОВАНЫ ПО ПОТРЕБЛЕНИЮ (ВОЗРАСТАНИЕ) ===" << endl;
-        for (size_t i = 0; i < sortedDevices.size(); i++) {
-            cout << i + 1 << ". " << sortedDevices[i]->getName()
-                << " - " << sortedDevices[i]->getPowerConsumption() << " Вт"
-                << " - Комната: " << (sortedDevices[i]->getLocation() ?
-                    sortedDevices[i]->getLocation()->getName() : "Нет") << endl;
-        }
+        size_t number = 0;
+        deviceManager.forEachByPower(true, [&number](const shared_ptr<Device>& device) {
+            printSortedDevice(++number, *device);
+            });
     }
 
     void sortDevicesByPowerDesc() {
-        vector<shared_ptr<Device>> sortedDevices = devices;
-        sort(sortedDevices.begin(), sortedDevices.end(), compareByPowerDesc);
-
         cout << "\n=== УСТРОЙСТВА ОТСОРТИРОВАНЫ ПО ПОТРЕБЛЕНИЮ (УБЫВАНИЕ) ===" << endl;
-        for (size_t i = 0; i < sortedDevices.size(); i++) {
-            cout << i + 1 << ". " << sortedDevices[i]->getName()
-                << " - " << sortedDevices[i]->getPowerConsumption() << " Вт"
-                << " - Комната: " << (sortedDevices[i]->getLocation() ?
-                    sortedDevices[i]->getLocation()->getName() : "Нет") << endl;
-        }
+        size_t number = 0;
+        deviceManager.forEachByPower(false, [&number](const shared_ptr<Device>& device) {
+            printSortedDevice(++number, *device);
+            });
     }
 
     void sortDevicesByName() {
-        vector<shared_ptr<Device>> sortedDevices = devices;
-        sort(sortedDevices.begin(), sortedDevices.end(), compareByNameAsc);
-
         cout << "\n=== УСТРОЙСТВА ОТСОРТИРОВАНЫ ПО НАЗВАНИЮ ===" << endl;
-        for (size_t i = 0; i < sortedDevices.size(); i++) {
-            cout << i + 1 << ". " << sortedDevices[i]->getName()
-                << " - " << sortedDevices[i]->getPowerConsumption() << " Вт"
-                << " - Комната: " << (sortedDevices[i]->getLocation() ?
-                    sortedDevices[i]->getLocation()->getName() : "Нет") << endl;
-        }
+        size_t number = 0;
+        deviceManager.forEachByName([&number](const shared_ptr<Device>& device) {
+            printSortedDevice(++number, *device);
+            });
     }
 
 
@@ -487,26 +824,16 @@ public:
 
         cout << "\n=== УСТРОЙСТВА ПРОИЗВОДИТЕЛЯ: " << manufacturer << " ===" << endl;
 
-        // Использование std::find_if 
-        vector<shared_ptr<Device>> foundDevices;
-        for (const auto& device : devices) {
-            if (device->getManufacturer() == manufacturer) {
-                foundDevices.push_back(device);
-            }
-        }
+        DeviceQuery<Device> query(deviceManager);
+        query.fromManufacturer(manufacturer).orderBy(QueryOrder::NAME);
+        size_t number = 0;
+        query.forEach([&number](const shared_ptr<Device>& device) {
+            printSortedDevice(++number, *device);
+            });
 
-        if (foundDevices.empty()) {
+        if (number == 0) {
             cout << "Устройства не найдены для производителя: " << manufacturer << endl;
         }
-        else {
-            sort(foundDevices.begin(), foundDevices.end(), compareByNameAsc);
-            for (size_t i = 0; i < foundDevices.size(); i++) {
-                cout << i + 1 << ". " << foundDevices[i]->getName()
-                    << " - " << foundDevices[i]->getPowerConsumption() << " Вт"
-                    << " - Комната: " << (foundDevices[i]->getLocation() ?
-                        foundDevices[i]->getLocation()->getName() : "Нет") << endl;
-            }
-        }
     }
 
     void findDeviceByName() {
@@ -515,18 +842,15 @@ public:
         cin.ignore();
         getline(cin, deviceName);
 
-        // Использование std::find_if с пользовательским предикатором
-        auto it = find_if(devices.begin(), devices.end(),
-            [&deviceName](const shared_ptr<Device>& device) {
-                return device->getName() == deviceName;
-            });
+        // Первое по порядку устройство с таким названием (хеш-индекс)
+        auto found = deviceManager.findDeviceByName(deviceName);
 
-        if (it != devices.end()) {
+        if (found) {
             cout << "\n=== УСТРОЙСТВО НАЙДЕНО ===" << endl;
-            (*it)->displayInfo();
-            cout << "Комната: " << ((*it)->getLocation() ? (*it)->getLocation()->getName() : "Нет") << endl;
-            cout << "Производитель: " << (*it)->getManufacturer() << endl;
-            cout << "Потребление: " << (*it)->getPowerConsumption() << " Вт" << endl;
+            found->displayInfo();
+            cout << "Комната: " << (found->getLocation() ? found->getLocation()->getName() : "Нет") << endl;
+            cout << "Производитель: " << found->getManufacturer() << endl;
+            cout << "Потребление: " << found->getPowerConsumption() << " Вт" << endl;
         }
         else {
             cout << "Устройство с названием '" << deviceName << "' не найдено." << endl;
@@ -540,38 +864,164 @@ public:
 
         cout << "\n=== УСТРОЙСТВА С ПОТРЕБЛЕНИЕМ > " << threshold << " Вт ===" << endl;
 
-        // Использование std::find_if 
-        vector<shared_ptr<Device>> highPowerDevices;
-        copy_if(devices.begin(), devices.end(), back_inserter(highPowerDevices),
-            [threshold](const shared_ptr<Device>& device) {
-                return device->getPowerConsumption() > threshold;
+        // Диапазон упорядоченного индекса мощности обходится с конца, без сортировки
+        DeviceQuery<Device> query(deviceManager);
+        query.powerAbove(threshold).orderBy(QueryOrder::POWER_DESC);
+        size_t number = 0;
+        query.forEach([&number](const shared_ptr<Device>& device) {
+            printSortedDevice(++number, *device);
             });
 
-        if (highPowerDevices.empty()) {
+        if (number == 0) {
             cout << "Устройства с потреблением выше " << threshold << " Вт не найдены." << endl;
         }
-        else {
-            // Сортировка по потреблению
-            sort(highPowerDevices.begin(), highPowerDevices.end(), compareByPowerDesc);
-
-            for (size_t i = 0; i < highPowerDevices.size(); i++) {
-                cout << i + 1 << ". " << highPowerDevices[i]->getName()
-                    << " - " << highPowerDevices[i]->getPowerConsumption() << " Вт"
-                    << " - Комната: " << (highPowerDevices[i]->getLocation() ?
-                        highPowerDevices[i]->getLocation()->getName() : "Нет") << endl;
+    }
+
+    // Режим текстового поиска; текст - до конца строки, без учета регистра
+    static TextMatch readTextQuery(string& text) {
+        cout << "Режим (1 - начало, 2 - часть текста): ";
+        int mode;
+        cin >> mode;
+        cout << "Текст для поиска: ";
+        cin.ignore();
+        getline(cin, text);
+        return mode == 1 ? TextMatch::PREFIX : TextMatch::SUBSTRING;
+    }
+
+    void findDevicesByText() {
+        string text;
+        TextMatch mode = readTextQuery(text);
+        vector<shared_ptr<Device>> found = registry.searchDevices(text, mode);
+
+        cout << "\n=== НАЙДЕНО УСТРОЙСТВ: " << found.size() << " ===" << endl;
+        for (size_t i = 0; i < found.size(); i++) {
+            printSortedDevice(i + 1, *found[i]);
+        }
+    }
+
+    // Сравнение последовательного и параллельного прохода и сортировки на временных
+    // устройствах; найденный порог можно установить для Execution::AUTO
+    void benchmarkParallel() {
+        unsigned cores = thread::hardware_concurrency();
+        cout << "\n=== ЗАМЕР ПАРАЛЛЕЛЬНОЙ ОБРАБОТКИ (ядер: " << (cores ? cores : 1) << ") ===" << endl;
+        if (cores <= 1) {
+            cout << "Одно ядро: параллельный вариант совпадает с последовательным, замер не нужен." << endl;
+            return;
+        }
+        cout << "Устройств | Поиск: посл. / парал., мс | Сортировка: посл. / парал., мс" << endl;
+        vector<BenchmarkRow> rows = ParallelBenchmark::run(ParallelBenchmark::defaultSizes());
+        for (const auto& row : rows) {
+            cout << row.items << " | " << row.scanSequential << " / " << row.scanParallel
+                << " | " << row.sortSequential << " / " << row.sortParallel << endl;
+        }
+
+        size_t scanFrom = ParallelBenchmark::scanCrossover(rows);
+        size_t sortFrom = ParallelBenchmark::sortCrossover(rows);
+        cout << "Параллельный поиск быстрее с: " << (scanFrom ? to_string(scanFrom) : string("не достигнуто")) << endl;
+        cout << "Параллельная сортировка быстрее с: " << (sortFrom ? to_string(sortFrom) : string("не достигнуто")) << endl;
+        cout << "Текущий порог: " << Parallel::getCutoff() << " устройств" << endl;
+        if (scanFrom == 0 || sortFrom == 0) {
+            cout << "Порог не изменен." << endl;
+            return;
+        }
+
+        // Один порог на оба алгоритма: берется больший
+        size_t cutoff = scanFrom > sortFrom ? scanFrom : sortFrom;
+        cout << "Установить порог " << cutoff << "? (1 - да): ";
+        int answer;
+        cin >> answer;
+        if (answer == 1) {
+            Parallel::setCutoff(cutoff);
+            cout << "Порог установлен." << endl;
+        }
+    }
+
+    // Поиск по нескольким условиям сразу; пропущенные условия не ограничивают выборку
+    void findDevicesByQuery() {
+        DeviceQuery<Device> query(deviceManager);
+
+        if (!rooms.empty()) {
+            listAllRooms();
+            cout << "Номер комнаты (0 - любая): ";
+            size_t roomChoice;
+            cin >> roomChoice;
+            if (roomChoice > 0 && roomChoice <= rooms.size()) {
+                query.inRoom(*rooms[roomChoice - 1]);
             }
         }
+
+        cout << "Тип (0 - любой, 1-Датчик, 2-Исполнительное, 3-Климат, 4-Безопасность, 5-Мультимедиа): ";
+        int typeChoice;
+        cin >> typeChoice;
+        if (typeChoice >= 1 && typeChoice <= 5) {
+            query.ofType(static_cast<DeviceType>(typeChoice - 1));
+        }
+
+        cout << "Производитель (пусто - любой): ";
+        string manufacturer;
+        cin.ignore();
+        getline(cin, manufacturer);
+        if (!manufacturer.empty()) {
+            query.fromManufacturer(manufacturer);
+        }
+
+        cout << "Питание (0 - любое, 1 - включено, 2 - выключено): ";
+        int onChoice;
+        cin >> onChoice;
+        if (onChoice == 1 || onChoice == 2) {
+            query.whereOn(onChoice == 1);
+        }
+
+        cout << "Связь (0 - любая, 1 - онлайн, 2 - офлайн): ";
+        int onlineChoice;
+        cin >> onlineChoice;
+        if (onlineChoice == 1 || onlineChoice == 2) {
+            query.whereOnline(onlineChoice == 1);
+        }
+
+        cout << "Потребление от и до, Вт (отрицательное - без ограничения): ";
+        double low, high;
+        cin >> low >> high;
+        if (low >= 0 || high >= 0) {
+            query.powerBetween(low >= 0 ? low : 0.0, high >= 0 ? high : numeric_limits<double>::infinity());
+        }
+
+        cout << "Порядок (0 - как в списке, 1 - мощность по возрастанию, 2 - по убыванию, 3 - название): ";
+        int orderChoice;
+        cin >> orderChoice;
+        if (orderChoice >= 1 && orderChoice <= 3) {
+            query.orderBy(static_cast<QueryOrder>(orderChoice));
+        }
+
+        cout << "Не больше (0 - все): ";
+        size_t limit;
+        cin >> limit;
+        if (limit > 0) {
+            query.limit(limit);
+        }
+
+        cout << "\n=== РЕЗУЛЬТАТЫ ПОИСКА ===" << endl;
+        cout << "План: " << query.explain() << endl;
+        size_t number = 0;
+        query.forEach([&number](const shared_ptr<Device>& device) {
+            printSortedDevice(++number, *device);
+            });
+        if (number == 0) {
+            cout << "Устройства не найдены." << endl;
+        }
     }
 
     void listAllDevices() {
         cout << "\n=== ВСЕ УСТРОЙСТВА ===" << endl;
-        for (size_t i = 0; i < devices.size(); i++) {
-            cout << i + 1 << ". " << devices[i]->getName()
-                << " (" << devices[i]->getDeviceTypeString() << ")"
-                << " - " << devices[i]->getStatus()
-                << " - " << devices[i]->getPowerConsumption() << " Вт"
-                << " - Комната: " << (devices[i]->getLocation() ? devices[i]->getLocation()->getName() : "Нет") << endl;
-        }
+        printPaged(deviceManager.getAllDevices(), [](const shared_ptr<Device>& device) { return device->getId(); },
+            [](size_t number, const Device& device) {
+                Room* location = device.getLocation();
+                cout << number << ". " << device.getName()
+                    << " (" << device.getDeviceTypeString() << ")"
+                    << " - " << device.getStatus()
+                    << " - " << device.getPowerConsumption() << " Вт"
+                    << " - Комната: " << (location ? location->getName() : "Нет") << endl;
+            });
     }
 
     void toggleDevice() {
@@ -580,8 +1030,8 @@ public:
         int choice;
         cin >> choice;
 
-        if (choice > 0 && choice <= devices.size()) {
-            auto& device = devices[choice - 1];
+        if (choice > 0 && choice <= deviceManager.getDeviceCount()) {
+            auto device = deviceManager.getDeviceByIndex(choice - 1);
             if (device->getIsOn()) {
                 device->turnOff();
                 cout << device->getName() << " выключен" << endl;
@@ -590,7 +1040,9 @@ public:
                 device->turnOn();
                 cout << device->getName() << " включен" << endl;
             }
-            saveData();
+            journal.append(JournalRecord(JournalRecordType::DEVICE_STATE, device->getId(), "",
+                device->getIsOn() ? 1 : 0));
+            commitChanges();
         }
         else {
             cout << "Неверный номер устройства!" << endl;
@@ -643,8 +1095,8 @@ public:
                 cin >> deviceTypeChoice;
                 DeviceType type = static_cast<DeviceType>(deviceTypeChoice - 1);
 
-                newDevice = make_shared<Device>(
-                    "DEV" + to_string(devices.size() + 1),
+                newDevice = makePooled<Device>(
+                    registry.nextId("DEV"),
                     name,
                     manufacturer,
                     type,
@@ -658,8 +1110,8 @@ public:
                 double targetTemp;
                 cin >> targetTemp;
 
-                newDevice = make_shared<ClimateDevice>(
-                    "CLIM" + to_string(devices.size() + 1),
+                newDevice = makePooled<ClimateDevice>(
+                    registry.nextId("CLIM"),
                     name,
                     manufacturer,
                     room,
@@ -669,8 +1121,8 @@ public:
                 break;
             }
             case 3: {
-                newDevice = make_shared<SecurityDevice>(
-                    "SEC" + to_string(devices.size() + 1),
+                newDevice = makePooled<SecurityDevice>(
+                    registry.nextId("SEC"),
                     name,
                     manufacturer,
                     room,
@@ -683,10 +1135,13 @@ public:
                 return;
             }
 
-            devices.push_back(newDevice);
+            deviceManager.addDevice(newDevice);
+            deviceGroups.add(newDevice.get());
             room->addDevice(newDevice);
+            registry.addDevice(newDevice);
             cout << "Устройство добавлено в комнату '" << room->getName() << "'!" << endl;
-            saveData();
+            journal.append(JournalRecord(JournalRecordType::DEVICE_ADD, newDevice->getId(), newDevice->serialize()));
+            commitChanges();
         }
         else {
             cout << "Неверный номер комнаты!" << endl;
@@ -701,14 +1156,17 @@ public:
         int choice;
         cin >> choice;
 
-        if (choice > 0 && choice <= devices.size()) {
-            auto device = devices[choice - 1];
+        if (choice > 0 && choice <= deviceManager.getDeviceCount()) {
+            auto device = deviceManager.getDeviceByIndex(choice - 1);
             if (device->getLocation()) {
                 device->getLocation()->removeDevice(device);
             }
-            devices.erase(devices.begin() + choice - 1);
+            registry.removeDevice(device->getId());
+            deviceManager.detachDevice(*device);
+            deviceGroups.remove(device.get());
             cout << "Устройство удалено!" << endl;
-            saveData();
+            journal.append(JournalRecord(JournalRecordType::DEVICE_REMOVE, device->getId()));
+            commitChanges();
         }
         else {
             cout << "Неверный номер устройства!" << endl;
@@ -717,11 +1175,13 @@ public:
 
     void listAllRooms() {
         cout << "\n=== ВСЕ КОМНАТЫ ===" << endl;
-        for (size_t i = 0; i < rooms.size(); i++) {
-            cout << i + 1 << ". " << rooms[i]->getName()
-                << " (" << rooms[i]->getArea() << " м^2)"
-                << " - Устройств: " << rooms[i]->getDevices().size() << endl;
-        }
+        printPaged(rooms, [](const shared_ptr<Room>& room) { return room->getId(); },
+            [](size_t number, const Room& room) {
+                cout << number << ". " << room.getName()
+                    << " (" << room.getArea() << " м^2)"
+                    << " - Устройств: " << room.getDeviceCount()
+                    << " (включено: " << room.getActiveDeviceCount() << ")" << endl;
+            });
     }
 
     void showRoomDevices() {
@@ -750,23 +1210,6 @@ public:
         }
 
         cout << "\n=== ПОИСК УСТРОЙСТВ В КОМНАТЕ ===" << endl;
-
-        // Показать список комнат с номерами
-        cout << "Доступные комнаты:" << endl;
-        for (size_t i = 0; i < rooms.size(); i++) {
-            auto roomDevices = rooms[i]->getDevices();
-            int activeDevices = 0;
-            for (const auto& device : roomDevices) {
-                if (device->getIsOn()) {
-                    activeDevices++;
-                }
-            }
-
-            cout << i + 1 << ". " << rooms[i]->getName()
-                << " (" << rooms[i]->getArea() << " м^2)"
-                << " - Устройств: " << roomDevices.size()
-                << " (включено: " << activeDevices << ")" << endl;
-        }
         listAllRooms();
         cout << "Выберите номер комнаты: ";
         int choice;
@@ -790,15 +1233,16 @@ public:
             double power = rooms[choice - 1]->calculateRoomPowerConsumption();
             cout << "Текущее потребление энергии: " << power << " Вт" << endl;
 
-            auto roomDevices = rooms[choice - 1]->getDevices();
             int activeDevices = 0;
-            for (auto& device : roomDevices) {
-                if (device->getIsOn()) {
+            size_t deviceCount = 0;
+            rooms[choice - 1]->forEachDevice([&activeDevices, &deviceCount](const Device& device) {
+                deviceCount++;
+                if (device.getIsOn()) {
                     activeDevices++;
-                    cout << "  - " << device->getName() << ": " << device->getPowerConsumption() << " Вт" << endl;
+                    cout << "  - " << device.getName() << ": " << device.getPowerConsumption() << " Вт" << endl;
                 }
-            }
-            cout << "Включено устройств: " << activeDevices << " из " << roomDevices.size() << endl;
+            });
+            cout << "Включено устройств: " << activeDevices << " из " << deviceCount << endl;
         }
         else {
             cout << "Неверный номер комнаты!" << endl;
@@ -819,13 +1263,15 @@ public:
         cin >> area;
 
         auto newRoom = make_shared<Room>(
-            "ROOM" + to_string(rooms.size() + 1),
+            registry.nextId("ROOM"),
             name,
             area
         );
         rooms.push_back(newRoom);
+        registry.addRoom(newRoom);
         cout << "Комната добавлена!" << endl;
-        saveData();
+        journal.append(JournalRecord(JournalRecordType::ROOM_ADD, newRoom->getId(), newRoom->serialize()));
+        commitChanges();
     }
 
     void deleteRoom() {
@@ -837,14 +1283,17 @@ public:
         cin >> choice;
 
         if (choice > 0 && choice <= rooms.size()) {
-            if (!rooms[choice - 1]->getDevices().empty()) {
+            if (rooms[choice - 1]->getDeviceCount() != 0) {
                 cout << "Ошибка: В комнате есть устройства! Сначала удалите или переместите их." << endl;
                 return;
             }
 
+            string roomId = rooms[choice - 1]->getId();
             rooms.erase(rooms.begin() + choice - 1);
+            registry.removeRoom(roomId);
             cout << "Комната удалена!" << endl;
-            saveData();
+            journal.append(JournalRecord(JournalRecordType::ROOM_REMOVE, roomId));
+            commitChanges();
         }
         else {
             cout << "Неверный номер комнаты!" << endl;
@@ -853,10 +1302,23 @@ public:
 
     void listUsers() {
         cout << "\n=== ВСЕ ПОЛЬЗОВАТЕЛИ ===" << endl;
-        for (size_t i = 0; i < users.size(); i++) {
-            cout << i + 1 << ". ";
-            users[i]->displayInfo();
-            cout << "---" << endl;
+        printPaged(users, [](const shared_ptr<User>& user) { return user->getUserId(); },
+            [](size_t number, const User& user) {
+                cout << number << ". ";
+                user.displayInfo();
+                cout << "---" << endl;
+            });
+    }
+
+    void findUsersByText() {
+        string text;
+        TextMatch mode = readTextQuery(text);
+        vector<shared_ptr<User>> found = registry.searchUsers(text, mode);
+
+        cout << "\n=== НАЙДЕНО ПОЛЬЗОВАТЕЛЕЙ: " << found.size() << " ===" << endl;
+        for (size_t i = 0; i < found.size(); i++) {
+            cout << i + 1 << ". " << found[i]->getUsername() << " (" << found[i]->getUserId() << ")"
+                << " - " << found[i]->getFormattedContactInfo() << endl;
         }
     }
 
@@ -873,16 +1335,18 @@ public:
         cin >> level;
 
         auto newUser = make_shared<User>(
-            "USR" + to_string(users.size() + 1),
+            registry.nextId("USR"),
             username,
             password,
             (level == 2 ? AccessLevel::ADMIN : AccessLevel::USER),
             "",
             ""
         );
-        users.push_back(newUser);
+        insertUser(newUser);
+        registry.addUser(newUser);
         cout << "Пользователь добавлен!" << endl;
-        saveData();
+        journal.append(JournalRecord(JournalRecordType::USER_ADD, newUser->getUserId(), newUser->serialize()));
+        commitChanges();
     }
 
     void deleteUser() {
@@ -897,9 +1361,12 @@ public:
                 return;
             }
 
+            string userId = users[choice - 1]->getUserId();
             users.erase(users.begin() + choice - 1);
+            registry.removeUser(userId);
             cout << "Пользователь удален!" << endl;
-            saveData();
+            journal.append(JournalRecord(JournalRecordType::USER_REMOVE, userId));
+            commitChanges();
         }
         else {
             cout << "Неверный номер пользователя!" << endl;
@@ -919,7 +1386,9 @@ public:
 
             users[choice - 1]->setAccessLevel(level == 2 ? AccessLevel::ADMIN : AccessLevel::USER);
             cout << "Права доступа изменены!" << endl;
-            saveData();
+            journal.append(JournalRecord(JournalRecordType::USER_ACCESS, users[choice - 1]->getUserId(), "",
+                static_cast<int32_t>(users[choice - 1]->getAccessLevel())));
+            commitChanges();
         }
         else {
             cout << "Неверный номер пользователя!" << endl;
@@ -928,10 +1397,12 @@ public:
 
     void showAllNotifications() {
         cout << "\n=== ВСЕ УВЕДОМЛЕНИЯ ===" << endl;
-        for (size_t i = 0; i < notifications.size(); i++) {
-            cout << i + 1 << ". ";
-            notifications[i]->displayInfo();
-        }
+        printPaged(notifications,
+            [](const unique_ptr<Notification>& notification) { return notification->getNotificationId(); },
+            [](size_t number, const Notification& notification) {
+                cout << number << ". ";
+                notification.displayInfo();
+            });
     }
 
     void showUnreadNotifications() {
@@ -947,6 +1418,44 @@ public:
         if (!hasUnread) {
             cout << "Нет непрочитанных уведомлений." << endl;
         }
+        if (archive.unreadCount() > 0) {
+            cout << "В архиве непрочитанных: " << archive.unreadCount() << endl;
+        }
+    }
+
+    // Сегмент архива распаковывается только при просмотре
+    void showArchivedNotifications() {
+        cout << "\n=== АРХИВ УВЕДОМЛЕНИЙ ===" << endl;
+        if (archive.segmentCount() == 0) {
+            cout << "Архив пуст." << endl;
+            return;
+        }
+        for (size_t i = 0; i < archive.segmentCount(); i++) {
+            const ArchiveSegmentInfo& info = archive.segment(i);
+            cout << i + 1 << ". " << formatTimestamp(static_cast<time_t>(info.firstTimestamp)) << " - "
+                << formatTimestamp(static_cast<time_t>(info.lastTimestamp)) << ": " << info.count
+                << " уведомлений, непрочитанных: " << info.unreadCount << endl;
+        }
+        cout << "Выберите сегмент: ";
+        int choice;
+        cin >> choice;
+
+        if (choice > 0 && static_cast<size_t>(choice) <= archive.segmentCount()) {
+            // Последние сегменты могут еще ждать записи в фоновом потоке
+            if (!persistence.flush()) {
+                snapshotCache.clear();
+            }
+            vector<unique_ptr<Notification>> segment;
+            if (archive.loadSegment(choice - 1, registry, segment)) {
+                for (size_t i = 0; i < segment.size(); i++) {
+                    cout << i + 1 << ". ";
+                    segment[i]->displayInfo();
+                }
+            }
+        }
+        else {
+            cout << "Неверный номер сегмента!" << endl;
+        }
     }
 
     void markNotificationAsRead() {
@@ -957,7 +1466,9 @@ public:
 
         if (choice > 0 && choice <= notifications.size()) {
             notifications[choice - 1]->markAsRead();
-            saveData();
+            journal.append(JournalRecord(JournalRecordType::NOTIFICATION_READ,
+                notifications[choice - 1]->getNotificationId()));
+            commitChanges();
         }
         else {
             cout << "Неверный номер уведомления!" << endl;
@@ -968,7 +1479,7 @@ public:
         auto report = make_unique<EnergyReport>("ОТЧЕТ" + to_string(reports.size() + 1),
             time(nullptr) - 86400, time(nullptr));
 
-        for (auto& device : devices) {
+        for (const auto& device : deviceManager.getAllDevices()) {
             if (device->getIsOn()) {
                 report->addDeviceConsumption(device, device->getPowerConsumption() * 24);
             }
@@ -1026,11 +1537,13 @@ public:
                 "",
                 ""
             );
-            users.push_back(firstUser);
+            insertUser(firstUser);
+            registry.addUser(firstUser);
             currentUser = firstUser;
 
             cout << "Пользователь создан! Добро пожаловать, " << username << "!" << endl;
-            saveData();
+            journal.append(JournalRecord(JournalRecordType::USER_ADD, firstUser->getUserId(), firstUser->serialize()));
+            commitChanges();
         }
         else {
             // Обычный вход
@@ -1046,6 +1559,7 @@ public:
         do {
             displayMainMenu();
             cin >> choice;
+            telemetry.drain();
 
             switch (choice) {
             case 1:
@@ -1100,7 +1614,7 @@ public:
                 listAllDevices();
                 break;
             case 2:
-                if (devices.empty()) {
+                if (deviceManager.isEmpty()) {
                     cout << "В системе нет устройств для управления." << endl;
                 }
                 else {
@@ -1117,7 +1631,7 @@ public:
                 break;
             case 4:
                 if (currentUser && currentUser->getAccessLevel() == AccessLevel::ADMIN) {
-                    if (devices.empty()) {
+                    if (deviceManager.isEmpty()) {
                         cout << "В системе нет устройств для удаления." << endl;
                     }
                     else {
@@ -1140,26 +1654,27 @@ public:
     void systemStatus() {
         cout << "\n=== СТАТУС СИСТЕМЫ ===" << endl;
         cout << "Комнат: " << rooms.size() << endl;
-        cout << "Устройств: " << devices.size() << endl;
+        cout << "Устройств: " << deviceManager.getDeviceCount() << endl;
         cout << "Пользователей: " << users.size() << endl;
         cout << "Сценариев: " << scenarios.size() << endl;
-        cout << "Уведомлений: " << notifications.size() << endl;
+        cout << "Уведомлений: " << notifications.size() << " (в архиве: " << archive.totalCount() << ")" << endl;
 
-        if (devices.empty()) {
+        if (deviceManager.isEmpty()) {
             cout << "\nСистема пуста. Добавьте устройства для мониторинга потребления." << endl;
         }
         else {
-            int activeDevices = 0;
-            double totalPower = 0.0;
-            for (auto& device : devices) {
-                if (device->getIsOn()) {
-                    activeDevices++;
-                    totalPower += device->getPowerConsumption();
-                }
-            }
+            // Суммы ведутся приращениями в DeviceStateTable, чтение за O(1)
+            LoadTotals load = DeviceStateTable::instance().homeLoad();
+            cout << "\nАктивных устройств: " << load.activeCount << "/" << deviceManager.getDeviceCount() << endl;
+            cout << "Текущее потребление: " << load.activePower << " Вт" << endl;
+            cout << "С учетом эффективности: " << deviceGroups.totalEfficiency() << " Вт" << endl;
+        }
 
-            cout << "\nАктивных устройств: " << activeDevices << "/" << devices.size() << endl;
-            cout << "Текущее потребление: " << totalPower << " Вт" << endl;
+        TelemetryStats stats = telemetry.stats();
+        if (stats.accepted + stats.rejected > 0) {
+            cout << "Телеметрия: принято " << stats.accepted << ", отклонено (очередь заполнена) " << stats.rejected
+                << ", применено " << stats.applied << " (приведено к диапазону " << stats.clamped
+                << "), некорректных " << stats.invalid << ", устаревших " << stats.stale << endl;
         }
     }
 
@@ -1192,11 +1707,20 @@ public:
                 findDevicesByPowerThreshold();
                 break;
             case 8:
+                findDevicesByQuery();
+                break;
+            case 9:
+                findDevicesByText();
+                break;
+            case 10:
+                benchmarkParallel();
+                break;
+            case 11:
                 return;
             default:
                 cout << "Неверная опция!" << endl;
             }
-        } while (choice != 8);
+        } while (choice != 11);
     }
 
     void roomManagement() {
@@ -1259,11 +1783,14 @@ public:
                 changeUserAccess();
                 break;
             case 5:
+                findUsersByText();
+                break;
+            case 6:
                 return;
             default:
                 cout << "Неверная опция!" << endl;
             }
-        } while (choice != 5);
+        } while (choice != 6);
     }
 
     void scenarioManagement() {
@@ -1320,11 +1847,14 @@ public:
                 markNotificationAsRead();
                 break;
             case 4:
+                showArchivedNotifications();
+                break;
+            case 5:
                 return;
             default:
                 cout << "Неверная опция!" << endl;
             }
-        } while (choice != 4);
+        } while (choice != 5);
     }
 
     void createScenario() {
@@ -1339,12 +1869,15 @@ public:
         getline(cin, time);
 
         auto scenario = make_unique<AutomationScenario>(
-            "SCN" + to_string(scenarios.size() + 1), name, time
+            registry.nextId("SCN"), name, time
         );
         scenarios.push_back(move(scenario));
+        registry.addScenario(scenarios.back().get());
+        journal.append(JournalRecord(JournalRecordType::SCENARIO_ADD, scenarios.back()->getScenarioId(),
+            scenarios.back()->serialize()));
         cout << "Сценарий создан! Теперь добавьте действия." << endl;
         addActionToScenario(scenarios.back().get());
-        saveData();
+        commitChanges();
     }
 
     void executeScenario() {
@@ -1364,9 +1897,24 @@ public:
         cin >> choice;
 
         if (choice > 0 && choice <= scenarios.size()) {
+            // Запоминаем состояние устройств, чтобы записать в журнал только изменившиеся
+            const vector<shared_ptr<Device>>& devices = deviceManager.getAllDevices();
+            vector<bool> wasOn;
+            for (const auto& device : devices) {
+                wasOn.push_back(device->getIsOn());
+            }
+
             scenarios[choice - 1]->activate();
             scenarios[choice - 1]->execute();
-            saveData();
+
+            journal.append(JournalRecord(JournalRecordType::SCENARIO_STATE, scenarios[choice - 1]->getScenarioId(), "", 1));
+            for (size_t i = 0; i < devices.size(); i++) {
+                if (devices[i]->getIsOn() != wasOn[i]) {
+                    journal.append(JournalRecord(JournalRecordType::DEVICE_STATE, devices[i]->getId(), "",
+                        devices[i]->getIsOn() ? 1 : 0));
+                }
+            }
+            commitChanges();
         }
         else {
             cout << "Неверный номер сценария!" << endl;
@@ -1430,7 +1978,7 @@ public:
         int deviceChoice;
         cin >> deviceChoice;
 
-        if (deviceChoice > 0 && deviceChoice <= devices.size()) {
+        if (deviceChoice > 0 && deviceChoice <= deviceManager.getDeviceCount()) {
             cout << "Действие (1 - Включить, 2 - Выключить): ";
             int actionChoice;
             cin >> actionChoice;
@@ -1438,12 +1986,12 @@ public:
             string command = (actionChoice == 1) ? "turnOn" : "turnOff";
             auto action = make_unique<ScenarioAction>(
                 "ACT" + to_string(scenario->getActionCount() + 1),
-                devices[deviceChoice - 1],
+                deviceManager.getDeviceByIndex(deviceChoice - 1),
                 command
             );
             scenario->addAction(move(action));
             cout << "Действие добавлено в сценарий!" << endl;
-            saveData();
+            // Действия сценариев не входят в сохраняемые данные, поэтому в журнал ничего не пишется
         }
         else {
             cout << "Неверный номер устройства!" << endl;
@@ -1451,9 +1999,28 @@ public:
     }
 };
 
-int main() {
+int main(int argc, char* argv[]) {
     try {
         setRussianLocale();
+
+        // Конвертация между текстовым форматом и бинарным снимком без запуска меню
+        if (argc > 1) {
+            string command = argv[1];
+            if (command == "--export-text") {
+                bool ok = DataManager::convertSnapshotToText();
+                cout << (ok ? "Снимок экспортирован в .dat файлы." : "Не удалось экспортировать снимок.") << endl;
+                return ok ? 0 : 1;
+            }
+            if (command == "--import-text") {
+                bool ok = DataManager::convertTextToSnapshot();
+                cout << (ok ? "Данные из .dat файлов импортированы в снимок." : "Не удалось импортировать данные.") << endl;
+                return ok ? 0 : 1;
+            }
+            cout << "Неизвестная команда: " << command << endl;
+            cout << "Доступные команды: --export-text, --import-text" << endl;
+            return 1;
+        }
+
         cout << "Запуск системы Умный Дом..." << endl;
         SmartHomeSystem system;
         system.run();
@@ -0,0 +1,43 @@
+﻿#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <string>
+#include <cstddef>
+
+// Файл, отображенный в память только для чтения.
+// В Windows - CreateFileMapping/MapViewOfFile, в остальных системах - mmap.
+// Пустой файл открывается успешно, но data() для него равен nullptr
+class MappedFile {
+private:
+    const char* view;
+    size_t length;
+    bool opened;
+
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int descriptor;
+#endif
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    const char* data() const;
+    size_t size() const;
+    bool isOpen() const;
+};
+
+// Заменяет target файлом source одной операцией: в любой момент на месте target
+// лежит либо прежний файл, либо новый. В Windows - MoveFileEx с
+// MOVEFILE_REPLACE_EXISTING, в остальных системах - rename
+bool replaceFile(const std::string& source, const std::string& target);
+
+#endif
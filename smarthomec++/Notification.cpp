@@ -1,6 +1,8 @@
 ﻿#include "notification.hpp"
 #include "device.hpp"
 #include "automationScenario.hpp"
+#include "EntityRegistry.hpp"
+#include "FieldTokenizer.hpp"
 #include <iostream>
 #include <sstream>
 #include <iomanip>
@@ -12,7 +14,6 @@ Notification::Notification(const std::string& id, NotificationType notificationT
     type(notificationType),
     message(msg),
     relatedDevice(nullptr),
-    relatedScenario(nullptr),
     timestamp(std::time(nullptr)),
     isRead(false) {
 }
@@ -21,11 +22,13 @@ Notification::~Notification() {
 }
 
 void Notification::send() {
+    touch();
     std::cout << "Отправка уведомления [" << notificationId << "]: " << message << std::endl;
     isRead = false;
 }
 
 void Notification::markAsRead() {
+    touch();
     isRead = true;
     std::cout << "Уведомление [" << notificationId << "] отмечено как прочитанное" << std::endl;
 }
@@ -64,8 +67,8 @@ void Notification::displayInfo() const {
         std::cout << "  Связанное устройство: " << relatedDevice->getName() << std::endl;
     }
 
-    if (relatedScenario) {
-        std::cout << "  Связанный сценарий: " << relatedScenario->getName() << std::endl;
+    if (!relatedScenarioId.empty()) {
+        std::cout << "  Связанный сценарий: " << relatedScenarioName << std::endl;
     }
 
     char buffer[80];
@@ -100,12 +103,27 @@ bool Notification::getIsRead() const {
     return isRead;
 }
 
+std::time_t Notification::getTimestamp() const {
+    return timestamp;
+}
+
+std::shared_ptr<Device> Notification::getRelatedDevice() const {
+    return relatedDevice;
+}
+
+std::string Notification::getRelatedScenarioId() const {
+    return relatedScenarioId;
+}
+
 void Notification::setRelatedDevice(std::shared_ptr<Device> device) {
+    touch();
     relatedDevice = device;
 }
 
-void Notification::setRelatedScenario(std::shared_ptr<AutomationScenario> scenario) {
-    relatedScenario = scenario;
+void Notification::setRelatedScenario(const AutomationScenario* scenario) {
+    touch();
+    relatedScenarioId = scenario ? scenario->getScenarioId() : "";
+    relatedScenarioName = scenario ? scenario->getName() : "";
 }
 
 std::string Notification::serialize() const {
@@ -114,38 +132,45 @@ std::string Notification::serialize() const {
         << static_cast<int>(type) << "|"
         << message << "|"
         << (relatedDevice ? relatedDevice->getId() : "NULL") << "|"
-        << (relatedScenario ? relatedScenario->getScenarioId() : "NULL") << "|"
+        << (relatedScenarioId.empty() ? "NULL" : relatedScenarioId) << "|"
         << timestamp << "|"
         << isRead;
     return ss.str();
 }
 
-std::unique_ptr<Notification> Notification::deserialize(const std::string& data) {
-    try {
-        std::stringstream ss(data);
-        std::string id, typeStr, message, deviceId, scenarioId, timestampStr, isReadStr;
-
-        std::getline(ss, id, '|');
-        std::getline(ss, typeStr, '|');
-        std::getline(ss, message, '|');
-        std::getline(ss, deviceId, '|');
-        std::getline(ss, scenarioId, '|');
-        std::getline(ss, timestampStr, '|');
-        std::getline(ss, isReadStr, '|');
-
-        NotificationType type = static_cast<NotificationType>(std::stoi(typeStr));
-        auto notification = std::make_unique<Notification>(id, type, message);
+std::unique_ptr<Notification> Notification::deserialize(const std::string& data,
+    const EntityRegistry* registry) {
+    FieldTokenizer fields(data);
+    int type = 0;
+    int64_t timestamp = 0;
+    if (!fields.getInt(1, type) || !fields.getInt64(5, timestamp)) {
+        std::cerr << "Ошибка десериализации уведомления: " << fields.errorText() << std::endl;
+        return nullptr;
+    }
 
-        notification->timestamp = std::stol(timestampStr);
-        notification->isRead = (isReadStr == "1");
+    auto notification = std::make_unique<Notification>(fields.text(0),
+        static_cast<NotificationType>(type), fields.text(2));
+    notification->timestamp = static_cast<std::time_t>(timestamp);
+    notification->isRead = fields.flag(6);
+
+    // Связи восстанавливаются через реестр, если устройства и сценарии уже загружены
+    if (registry) {
+        if (fields.view(3) != "NULL") {
+            notification->relatedDevice = registry->findDevice(fields.text(3));
+        }
+        if (fields.view(4) != "NULL") {
+            notification->setRelatedScenario(registry->findScenario(fields.text(4)));
+        }
+    }
 
-        // Примечание: связи с устройствами и сценариями должны быть установлены позже
-        // после загрузки всех данных
+    return notification;
+}
 
-        return notification;
-    }
-    catch (const std::exception& e) {
-        std::cerr << "Ошибка десериализации уведомления: " << e.what() << std::endl;
-        return nullptr;
-    }
+// Восстановление уведомления из уже разобранных полей (используется бинарным снимком)
+std::unique_ptr<Notification> Notification::restore(const std::string& id, NotificationType notificationType,
+    const std::string& msg, std::time_t time, bool read) {
+    auto notification = std::make_unique<Notification>(id, notificationType, msg);
+    notification->timestamp = time;
+    notification->isRead = read;
+    return notification;
 }
\ No newline at end of file
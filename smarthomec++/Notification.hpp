@@ -1,21 +1,26 @@
-#ifndef NOTIFICATION_HPP
+﻿#ifndef NOTIFICATION_HPP
 #define NOTIFICATION_HPP
 
 #include <string>
 #include <ctime>
 #include <memory>
 #include "notificationType.hpp"
+#include "Versioned.hpp"
 
 class Device;
 class AutomationScenario;
+class EntityRegistry;
 
-class Notification {
+class Notification : public Versioned<Notification> {
 private:
     std::string notificationId;
     NotificationType type;
     std::string message;
     std::shared_ptr<Device> relatedDevice;
-    std::shared_ptr<AutomationScenario> relatedScenario;
+    // Сценарием владеет SmartHomeSystem, поэтому связь хранится как ID (объект -
+    // через EntityRegistry::findScenario) и название для вывода; сценарии не переименовываются
+    std::string relatedScenarioId;
+    std::string relatedScenarioName;
     std::time_t timestamp;
     bool isRead;
 
@@ -33,11 +38,19 @@ public:
     NotificationType getType() const;
     std::string getMessage() const;
     bool getIsRead() const;
+    std::time_t getTimestamp() const;
+    std::shared_ptr<Device> getRelatedDevice() const;
+    // Пустая строка - связи нет
+    std::string getRelatedScenarioId() const;
     void setRelatedDevice(std::shared_ptr<Device> device);
-    void setRelatedScenario(std::shared_ptr<AutomationScenario> scenario);
+    // nullptr снимает связь
+    void setRelatedScenario(const AutomationScenario* scenario);
 
     std::string serialize() const;
-    static std::unique_ptr<Notification> deserialize(const std::string& data);
+    static std::unique_ptr<Notification> deserialize(const std::string& data,
+        const EntityRegistry* registry = nullptr);
+    static std::unique_ptr<Notification> restore(const std::string& id, NotificationType notificationType,
+        const std::string& msg, std::time_t time, bool read);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,309 @@
+﻿#include "NotificationArchive.hpp"
+#include "Notification.hpp"
+#include "Snapshot.hpp"
+#include "BinaryIO.hpp"
+#include "BlockCompressor.hpp"
+#include "MappedFile.hpp"
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+const uint32_t NotificationArchive::FORMAT_VERSION = 2;
+const size_t NotificationArchive::SEGMENT_RECORDS;
+const size_t NotificationArchive::HOT_RECORDS;
+
+namespace {
+
+const char ARCHIVE_MAGIC[4] = { 'S', 'H', 'N', 'A' };
+const char INDEX_MAGIC[4] = { 'S', 'H', 'N', 'I' };
+const size_t DATA_HEADER_SIZE = 12;
+const size_t INDEX_ENTRY_SIZE = 44;
+
+void writeSegmentInfo(BinaryWriter& out, const ArchiveSegmentInfo& info) {
+    out.write(info.offset);
+    out.write(info.storedSize);
+    out.write(info.rawSize);
+    out.write(info.count);
+    out.write(info.unreadCount);
+    out.write(info.firstTimestamp);
+    out.write(info.lastTimestamp);
+    out.write(static_cast<uint32_t>(info.lastId.size()));
+    out.writeBytes(info.lastId.data(), info.lastId.size());
+}
+
+bool readSegmentInfo(std::ifstream& file, ArchiveSegmentInfo& info) {
+    char entry[INDEX_ENTRY_SIZE];
+    uint32_t idLength = 0;
+    if (!file.read(entry, sizeof(entry))) {
+        return false;
+    }
+    BinaryReader in(entry, sizeof(entry));
+    in.read(info.offset);
+    in.read(info.storedSize);
+    in.read(info.rawSize);
+    in.read(info.count);
+    in.read(info.unreadCount);
+    in.read(info.firstTimestamp);
+    in.read(info.lastTimestamp);
+    in.read(idLength);
+    info.lastId.resize(idLength);
+    return idLength == 0 || file.read(&info.lastId[0], idLength);
+}
+
+} // namespace
+
+bool ArchiveBatch::write() const {
+    // Файл данных не пересоздается: прежние сегменты остаются на месте
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    if (!file.is_open()) {
+        file.clear();
+        file.open(path, std::ios::binary | std::ios::out | std::ios::trunc);
+        BinaryWriter header;
+        header.writeBytes(ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+        header.write(static_cast<uint16_t>(NotificationArchive::FORMAT_VERSION));
+        header.write(static_cast<uint16_t>(0));
+        header.write(static_cast<uint32_t>(0));
+        file.write(header.data().data(), static_cast<std::streamsize>(header.size()));
+    }
+    file.seekp(static_cast<std::streamoff>(dataOffset + writeOffset));
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    file.flush();
+    if (!file.good()) {
+        std::cerr << "Ошибка записи архива уведомлений: " << path << std::endl;
+        return false;
+    }
+    file.close();
+
+    BinaryWriter out;
+    out.writeBytes(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    out.write(static_cast<uint16_t>(NotificationArchive::FORMAT_VERSION));
+    out.write(static_cast<uint16_t>(0));
+    out.write(dataOffset);
+    out.write(static_cast<uint32_t>(index.size()));
+    for (const auto& info : index) {
+        writeSegmentInfo(out, info);
+    }
+
+    // Индекс, как и снимок, заменяется одной операцией
+    std::string target = NotificationArchive::indexPath(path);
+    std::string tempPath = target + ".tmp";
+    {
+        std::ofstream indexFile(tempPath, std::ios::binary | std::ios::trunc);
+        indexFile.write(out.data().data(), static_cast<std::streamsize>(out.size()));
+        if (!indexFile.good()) {
+            std::cerr << "Ошибка записи архива уведомлений: " << tempPath << std::endl;
+            return false;
+        }
+    }
+    if (!replaceFile(tempPath, target)) {
+        std::cerr << "Ошибка записи архива уведомлений: не удалось заменить " << target << std::endl;
+        return false;
+    }
+    return true;
+}
+
+NotificationArchive::NotificationArchive(const std::string& filePath)
+    : path(filePath), dataOffset(DATA_HEADER_SIZE) {}
+
+std::string NotificationArchive::indexPath(const std::string& filePath) {
+    return filePath + ".idx";
+}
+
+bool NotificationArchive::open() {
+    segments.clear();
+    dataOffset = DATA_HEADER_SIZE;
+
+    std::ifstream index(indexPath(path), std::ios::binary);
+    if (index.is_open()) {
+        return openIndex(index);
+    }
+    std::ifstream file(path, std::ios::binary);
+    if (file.is_open()) {
+        return openLegacy(file);
+    }
+    return true;  // архива еще нет
+}
+
+bool NotificationArchive::openIndex(std::ifstream& file) {
+    char fixed[20];
+    if (!file.read(fixed, sizeof(fixed))) {
+        std::cerr << "Ошибка чтения архива уведомлений: повреждён индекс" << std::endl;
+        return false;
+    }
+    BinaryReader header(fixed, sizeof(fixed));
+    char magic[4];
+    uint16_t version = 0, flags = 0;
+    uint64_t offset = 0;
+    uint32_t count = 0;
+    header.readBytes(magic, sizeof(magic));
+    header.read(version);
+    header.read(flags);
+    header.read(offset);
+    header.read(count);
+    if (std::memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0 || version < 2 || version > FORMAT_VERSION) {
+        std::cerr << "Ошибка чтения архива уведомлений: неизвестный формат индекса" << std::endl;
+        return false;
+    }
+
+    std::vector<ArchiveSegmentInfo> index(count);
+    for (auto& info : index) {
+        if (!readSegmentInfo(file, info)) {
+            std::cerr << "Ошибка чтения архива уведомлений: повреждён индекс" << std::endl;
+            return false;
+        }
+    }
+
+    segments = std::move(index);
+    dataOffset = offset;
+    return true;
+}
+
+bool NotificationArchive::openLegacy(std::ifstream& file) {
+    char fixed[DATA_HEADER_SIZE];
+    if (!file.read(fixed, sizeof(fixed))) {
+        std::cerr << "Ошибка чтения архива уведомлений: повреждён заголовок" << std::endl;
+        return false;
+    }
+    BinaryReader header(fixed, sizeof(fixed));
+    char magic[4];
+    uint16_t version = 0, flags = 0;
+    uint32_t count = 0;
+    header.readBytes(magic, sizeof(magic));
+    header.read(version);
+    header.read(flags);
+    header.read(count);
+    if (std::memcmp(magic, ARCHIVE_MAGIC, sizeof(magic)) != 0 || version == 0 || version > FORMAT_VERSION) {
+        std::cerr << "Ошибка чтения архива уведомлений: неизвестный формат файла" << std::endl;
+        return false;
+    }
+    // Файл данных версии 2 без индекса: сбой до первой записи индекса, сегментов нет
+    if (version >= 2) {
+        return true;
+    }
+
+    std::vector<ArchiveSegmentInfo> index(count);
+    for (auto& info : index) {
+        if (!readSegmentInfo(file, info)) {
+            std::cerr << "Ошибка чтения архива уведомлений: повреждён индекс" << std::endl;
+            return false;
+        }
+    }
+
+    segments = std::move(index);
+    dataOffset = static_cast<uint64_t>(file.tellg());
+    return true;
+}
+
+size_t NotificationArchive::segmentCount() const {
+    return segments.size();
+}
+
+const ArchiveSegmentInfo& NotificationArchive::segment(size_t index) const {
+    return segments[index];
+}
+
+size_t NotificationArchive::totalCount() const {
+    size_t total = 0;
+    for (const auto& info : segments) {
+        total += info.count;
+    }
+    return total;
+}
+
+size_t NotificationArchive::unreadCount() const {
+    size_t total = 0;
+    for (const auto& info : segments) {
+        total += info.unreadCount;
+    }
+    return total;
+}
+
+bool NotificationArchive::loadSegment(size_t index, EntityRegistry& registry,
+    std::vector<std::unique_ptr<Notification>>& out) const {
+    if (index >= segments.size()) {
+        return false;
+    }
+    const ArchiveSegmentInfo& info = segments[index];
+
+    std::ifstream file(path, std::ios::binary);
+    std::vector<char> stored(info.storedSize);
+    if (!file.is_open() || !file.seekg(static_cast<std::streamoff>(dataOffset + info.offset)) ||
+        (!stored.empty() && !file.read(stored.data(), static_cast<std::streamsize>(stored.size())))) {
+        std::cerr << "Ошибка чтения архива уведомлений: сегмент " << index + 1 << " недоступен" << std::endl;
+        return false;
+    }
+
+    std::vector<char> raw;
+    if (!BlockCompressor::decompress(stored.data(), stored.size(), info.rawSize, raw) ||
+        !Snapshot::decodeNotificationSegment(raw.data(), raw.size(), info.count, registry, out)) {
+        std::cerr << "Ошибка чтения архива уведомлений: повреждён сегмент " << index + 1 << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool NotificationArchive::loadAll(EntityRegistry& registry, std::vector<std::unique_ptr<Notification>>& out) const {
+    for (size_t i = 0; i < segments.size(); ++i) {
+        if (!loadSegment(i, registry, out)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t NotificationArchive::archivableCount(size_t total) {
+    if (total < HOT_RECORDS + SEGMENT_RECORDS) {
+        return 0;
+    }
+    return (total - HOT_RECORDS) / SEGMENT_RECORDS * SEGMENT_RECORDS;
+}
+
+void NotificationArchive::prepareAppend(const std::vector<std::unique_ptr<Notification>>& notifications,
+    size_t count, ArchiveBatch& batch) {
+    batch.path = path;
+    batch.dataOffset = dataOffset;
+    batch.writeOffset = segments.empty() ? 0 : segments.back().offset + segments.back().storedSize;
+    batch.data.clear();
+
+    std::vector<char> raw, stored;
+    for (size_t first = 0; first < count; first += SEGMENT_RECORDS) {
+        size_t segmentSize = std::min(SEGMENT_RECORDS, count - first);
+        Snapshot::encodeNotificationSegment(notifications, first, segmentSize, raw);
+        BlockCompressor::compress(raw.data(), raw.size(), stored);
+
+        ArchiveSegmentInfo info;
+        info.offset = batch.writeOffset + batch.data.size();
+        info.storedSize = static_cast<uint32_t>(stored.size());
+        info.rawSize = static_cast<uint32_t>(raw.size());
+        info.count = static_cast<uint32_t>(segmentSize);
+        info.unreadCount = 0;
+        info.firstTimestamp = static_cast<int64_t>(notifications[first]->getTimestamp());
+        info.lastTimestamp = info.firstTimestamp;
+        for (size_t i = first; i < first + segmentSize; ++i) {
+            if (!notifications[i]->getIsRead()) info.unreadCount++;
+            info.firstTimestamp = std::min(info.firstTimestamp, static_cast<int64_t>(notifications[i]->getTimestamp()));
+            info.lastTimestamp = std::max(info.lastTimestamp, static_cast<int64_t>(notifications[i]->getTimestamp()));
+        }
+        info.lastId = notifications[first + segmentSize - 1]->getNotificationId();
+
+        batch.data.insert(batch.data.end(), stored.begin(), stored.end());
+        segments.push_back(info);
+    }
+    batch.index = segments;
+}
+
+size_t NotificationArchive::dropArchived(std::vector<std::unique_ptr<Notification>>& notifications) const {
+    if (segments.empty()) {
+        return 0;
+    }
+    const std::string& lastId = segments.back().lastId;
+    size_t limit = std::min(notifications.size(), totalCount());
+    for (size_t i = 0; i < limit; ++i) {
+        if (notifications[i]->getNotificationId() == lastId) {
+            notifications.erase(notifications.begin(), notifications.begin() + i + 1);
+            return i + 1;
+        }
+    }
+    return 0;
+}
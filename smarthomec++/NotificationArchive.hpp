@@ -0,0 +1,103 @@
+﻿#ifndef NOTIFICATIONARCHIVE_HPP
+#define NOTIFICATIONARCHIVE_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <fstream>
+
+class Notification;
+class EntityRegistry;
+
+// Запись индекса архива о сегменте
+struct ArchiveSegmentInfo {
+    uint64_t offset;            // от начала области данных
+    uint32_t storedSize;        // размер сжатых данных
+    uint32_t rawSize;
+    uint32_t count;
+    uint32_t unreadCount;
+    int64_t firstTimestamp;
+    int64_t lastTimestamp;
+    std::string lastId;         // id последнего уведомления сегмента
+};
+
+// Новые сегменты архива, подготовленные в основном потоке для записи в фоне
+// (см. PersistenceWorker). Хранит все, что нужно для записи, без ссылок на архив
+struct ArchiveBatch {
+    std::string path;
+    uint64_t dataOffset;                        // начало области данных в файле
+    uint64_t writeOffset;                       // куда писать data, от начала области данных
+    std::vector<char> data;                     // сжатые сегменты подряд
+    std::vector<ArchiveSegmentInfo> index;      // полный индекс после записи
+
+    // Дописывает сегменты в файл данных и заменяет файл индекса
+    bool write() const;
+};
+
+// Архив старых уведомлений.
+//
+// Файл данных (path):
+//   заголовок: "SHNA", uint16 версия, uint16 флаги, uint32 0
+//   данные:    сегменты, сжатые BlockCompressor; внутри - сегмент уведомлений снимка
+// Файл индекса (path + ".idx"):
+//   заголовок: "SHNI", uint16 версия, uint16 флаги, uint64 начало данных, uint32 число сегментов
+//   индекс:    на каждый сегмент uint64 смещение, uint32 размер сжатых данных,
+//              uint32 исходный размер, uint32 число записей, uint32 непрочитанных,
+//              int64 время первого и последнего уведомления, uint32 длина + id последнего
+//
+// Сегменты идут по времени и после записи не меняются: новые дописываются в конец
+// файла данных, затем индекс заменяется целиком (он мал - одна запись на сегмент).
+// Сбой между этими шагами оставляет в конце данных хвост без индекса, который
+// перезапишет следующее добавление. При запуске читается только индекс, сегменты
+// распаковываются по требованию.
+//
+// В версии 1 индекс лежал в заголовке файла данных; такой файл читается как есть,
+// а при первом добавлении рядом появляется файл индекса
+class NotificationArchive {
+private:
+    std::string path;
+    std::vector<ArchiveSegmentInfo> segments;
+    uint64_t dataOffset;
+
+    bool openIndex(std::ifstream& file);
+    bool openLegacy(std::ifstream& file);
+
+public:
+    static const uint32_t FORMAT_VERSION;
+    // Уведомлений в одном сегменте
+    static const size_t SEGMENT_RECORDS = 1024;
+    // Сколько последних уведомлений всегда остается в снимке
+    static const size_t HOT_RECORDS = 256;
+
+    explicit NotificationArchive(const std::string& filePath);
+
+    static std::string indexPath(const std::string& filePath);
+
+    // Чтение индекса; если архива нет, он пуст
+    bool open();
+
+    size_t segmentCount() const;
+    const ArchiveSegmentInfo& segment(size_t index) const;
+    size_t totalCount() const;
+    size_t unreadCount() const;
+
+    // Сегменты, переданные в ArchiveBatch, доступны после его записи
+    bool loadSegment(size_t index, EntityRegistry& registry,
+        std::vector<std::unique_ptr<Notification>>& out) const;
+    bool loadAll(EntityRegistry& registry, std::vector<std::unique_ptr<Notification>>& out) const;
+
+    // Сколько первых уведомлений пора перенести в архив (целое число сегментов)
+    static size_t archivableCount(size_t total);
+
+    // Сжимает первые count уведомлений в новые сегменты и сразу учитывает их в индексе.
+    // На диск batch пишет ArchiveBatch::write - до снимка, который их уже не содержит
+    void prepareAppend(const std::vector<std::unique_ptr<Notification>>& notifications, size_t count,
+        ArchiveBatch& batch);
+
+    // Удаляет из начала списка уведомления, которые уже есть в архиве.
+    // Они остаются в снимке, если программа завершилась между записью архива и снимка
+    size_t dropArchived(std::vector<std::unique_ptr<Notification>>& notifications) const;
+};
+
+#endif
@@ -0,0 +1,152 @@
+﻿#include "ObjectPool.hpp"
+#include <mutex>
+#include <vector>
+#include <new>
+
+namespace {
+
+struct FreeNode {
+    FreeNode* next;
+};
+
+struct SizeClass {
+    std::mutex mutex;
+    size_t objectSize;
+    FreeNode* freeList;
+    char* cursor;               // следующее еще не выданное место текущего блока
+    char* end;
+    std::vector<char*> blocks;
+    size_t allocations;
+    size_t reused;
+    size_t live;
+
+    explicit SizeClass(size_t size)
+        : objectSize(size), freeList(nullptr), cursor(nullptr), end(nullptr),
+        allocations(0), reused(0), live(0) {}
+
+    ~SizeClass() {
+        // Оставшиеся объекты (если есть) продолжают ссылаться на блоки
+        if (live != 0) return;
+        for (char* block : blocks) {
+            ::operator delete(block);
+        }
+    }
+};
+
+const size_t CLASS_COUNT = ObjectPool::MAX_OBJECT_SIZE / ObjectPool::GRANULARITY;
+
+struct Pools {
+    SizeClass* classes[CLASS_COUNT];
+    std::mutex oversizedMutex;
+    size_t oversized;
+
+    Pools() : oversized(0) {
+        for (size_t i = 0; i < CLASS_COUNT; i++) {
+            classes[i] = new SizeClass((i + 1) * ObjectPool::GRANULARITY);
+        }
+    }
+
+    ~Pools() {
+        for (SizeClass* sizeClass : classes) {
+            delete sizeClass;
+        }
+    }
+};
+
+Pools& pools() {
+    static Pools instance;
+    return instance;
+}
+
+size_t classIndex(size_t size) {
+    return size == 0 ? 0 : (size - 1) / ObjectPool::GRANULARITY;
+}
+
+} // namespace
+
+PoolStats::PoolStats()
+    : allocations(0), reused(0), blocks(0), live(0), bytesReserved(0), oversized(0) {}
+
+size_t PoolStats::avoided() const {
+    return allocations - blocks;
+}
+
+PoolStats PoolStats::operator-(const PoolStats& before) const {
+    PoolStats result;
+    result.allocations = allocations - before.allocations;
+    result.reused = reused - before.reused;
+    result.blocks = blocks - before.blocks;
+    result.live = live - before.live;
+    result.bytesReserved = bytesReserved - before.bytesReserved;
+    result.oversized = oversized - before.oversized;
+    return result;
+}
+
+const size_t ObjectPool::GRANULARITY;
+const size_t ObjectPool::MAX_OBJECT_SIZE;
+const size_t ObjectPool::OBJECTS_PER_BLOCK;
+
+void* ObjectPool::allocate(size_t size) {
+    Pools& all = pools();
+    if (size > MAX_OBJECT_SIZE) {
+        {
+            std::lock_guard<std::mutex> lock(all.oversizedMutex);
+            all.oversized++;
+        }
+        return ::operator new(size);
+    }
+
+    SizeClass& sizeClass = *all.classes[classIndex(size)];
+    std::lock_guard<std::mutex> lock(sizeClass.mutex);
+    void* result;
+    if (sizeClass.freeList) {
+        result = sizeClass.freeList;
+        sizeClass.freeList = sizeClass.freeList->next;
+        sizeClass.reused++;
+    }
+    else {
+        if (sizeClass.cursor == sizeClass.end) {
+            size_t bytes = sizeClass.objectSize * OBJECTS_PER_BLOCK;
+            char* block = static_cast<char*>(::operator new(bytes));
+            sizeClass.blocks.push_back(block);
+            sizeClass.cursor = block;
+            sizeClass.end = block + bytes;
+        }
+        result = sizeClass.cursor;
+        sizeClass.cursor += sizeClass.objectSize;
+    }
+    sizeClass.allocations++;
+    sizeClass.live++;
+    return result;
+}
+
+void ObjectPool::deallocate(void* pointer, size_t size) noexcept {
+    if (!pointer) return;
+    if (size > MAX_OBJECT_SIZE) {
+        ::operator delete(pointer);
+        return;
+    }
+
+    SizeClass& sizeClass = *pools().classes[classIndex(size)];
+    std::lock_guard<std::mutex> lock(sizeClass.mutex);
+    FreeNode* node = static_cast<FreeNode*>(pointer);
+    node->next = sizeClass.freeList;
+    sizeClass.freeList = node;
+    sizeClass.live--;
+}
+
+PoolStats ObjectPool::stats() {
+    Pools& all = pools();
+    PoolStats result;
+    for (SizeClass* sizeClass : all.classes) {
+        std::lock_guard<std::mutex> lock(sizeClass->mutex);
+        result.allocations += sizeClass->allocations;
+        result.reused += sizeClass->reused;
+        result.blocks += sizeClass->blocks.size();
+        result.live += sizeClass->live;
+        result.bytesReserved += sizeClass->blocks.size() * sizeClass->objectSize * OBJECTS_PER_BLOCK;
+    }
+    std::lock_guard<std::mutex> lock(all.oversizedMutex);
+    result.oversized = all.oversized;
+    return result;
+}
@@ -0,0 +1,79 @@
+﻿#ifndef OBJECTPOOL_HPP
+#define OBJECTPOOL_HPP
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+// Счетчики пула по всем классам размеров
+struct PoolStats {
+    size_t allocations;     // объектов выдано из пула
+    size_t reused;          // из них со списка свободных
+    size_t blocks;          // блоков, запрошенных у кучи
+    size_t live;            // объектов сейчас
+    size_t bytesReserved;   // размер всех блоков
+    size_t oversized;       // крупные объекты, размещенные мимо пула
+
+    PoolStats();
+
+    // Обращений к куче, которых удалось избежать
+    size_t avoided() const;
+    PoolStats operator-(const PoolStats& before) const;
+};
+
+// Пул небольших объектов с классами размеров кратными GRANULARITY.
+//
+// Объекты одного класса размещаются подряд в блоках по OBJECTS_PER_BLOCK штук,
+// освобожденные места идут в список свободных и выдаются повторно. Блоки не
+// возвращаются куче, пока жив хотя бы один объект. Каждый класс защищен своим
+// мьютексом: устройства создаются и в потоках загрузчика
+class ObjectPool {
+public:
+    static const size_t GRANULARITY = 16;
+    static const size_t MAX_OBJECT_SIZE = 1024;
+    static const size_t OBJECTS_PER_BLOCK = 256;
+
+    static void* allocate(size_t size);
+    // size должен совпадать с переданным в allocate
+    static void deallocate(void* pointer, size_t size) noexcept;
+
+    static PoolStats stats();
+};
+
+// Аллокатор STL поверх ObjectPool (например, для allocate_shared)
+template <typename T>
+class PoolAllocator {
+public:
+    typedef T value_type;
+
+    PoolAllocator() noexcept {}
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(ObjectPool::allocate(count * sizeof(T)));
+    }
+
+    void deallocate(T* pointer, size_t count) noexcept {
+        ObjectPool::deallocate(pointer, count * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>&) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>&) const noexcept {
+        return false;
+    }
+};
+
+// Аналог std::make_shared: объект и счетчик ссылок размещаются одним куском из пула
+template <typename T, typename... Args>
+std::shared_ptr<T> makePooled(Args&&... args) {
+    return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+}
+
+#endif
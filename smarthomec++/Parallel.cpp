@@ -0,0 +1,25 @@
+﻿#include "Parallel.hpp"
+
+std::atomic<size_t> Parallel::cutoff(Parallel::DEFAULT_CUTOFF);
+
+size_t Parallel::getCutoff() {
+    return cutoff.load(std::memory_order_relaxed);
+}
+
+void Parallel::setCutoff(size_t items) {
+    cutoff.store(items, std::memory_order_relaxed);
+}
+
+size_t Parallel::workerCount(size_t items, Execution policy) {
+    if (policy == Execution::SEQUENTIAL || items < 2) {
+        return 1;
+    }
+    if (policy == Execution::AUTO && items < getCutoff()) {
+        return 1;
+    }
+    size_t cores = std::max<size_t>(1, std::thread::hardware_concurrency());
+    if (policy == Execution::PARALLEL) {
+        return std::min(cores, items);
+    }
+    return std::min(cores, std::max<size_t>(1, items / MIN_ITEMS_PER_WORKER));
+}
@@ -0,0 +1,222 @@
+﻿#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <cstddef>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+// Способ выполнения алгоритма над коллекцией
+enum class Execution {
+    SEQUENTIAL,     // в текущем потоке
+    PARALLEL,       // на всех ядрах при любом размере (для замеров)
+    AUTO            // параллельно начиная с Parallel::getCutoff() элементов
+};
+
+// Параллельные версии алгоритмов STL для коллекций устройств.
+//
+// Как и TextLoader: диапазон делится на непрерывные части по числу ядер, первая
+// часть обрабатывается в текущем потоке, остальные - в своих потоках; результаты
+// частей объединяются в их порядке, поэтому порядок вывода совпадает с
+// последовательной версией. Функции и предикаты вызываются одновременно из
+// нескольких потоков и не должны менять общие данные.
+//
+// Порог для AUTO можно подобрать замером (ParallelBenchmark) и установить setCutoff
+class Parallel {
+public:
+    static const size_t DEFAULT_CUTOFF = 32768;
+    // Меньшие части не выделяются в отдельный поток
+    static const size_t MIN_ITEMS_PER_WORKER = 2048;
+
+private:
+    static std::atomic<size_t> cutoff;
+
+    template <typename Iterator>
+    static Iterator advanced(Iterator first, size_t count) {
+        std::advance(first, count);
+        return first;
+    }
+
+public:
+    static size_t getCutoff();
+    static void setCutoff(size_t items);
+
+    // Число частей для items элементов при данном способе выполнения
+    static size_t workerCount(size_t items, Execution policy);
+
+    // body(part, begin, end) для частей [0, count); часть 0 - в текущем потоке
+    template <typename Body>
+    static void forRanges(size_t count, size_t parts, Body body) {
+        if (parts <= 1) {
+            body(size_t(0), size_t(0), count);
+            return;
+        }
+        std::vector<std::thread> workers;
+        workers.reserve(parts - 1);
+        for (size_t part = 1; part < parts; ++part) {
+            workers.emplace_back([&body, count, parts, part]() {
+                body(part, count * part / parts, count * (part + 1) / parts);
+                });
+        }
+        body(size_t(0), size_t(0), count / parts);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    template <typename Iterator, typename Func>
+    static void forEach(Execution policy, Iterator first, Iterator last, Func func) {
+        size_t count = static_cast<size_t>(std::distance(first, last));
+        forRanges(count, workerCount(count, policy), [first, &func](size_t, size_t begin, size_t end) {
+            std::for_each(advanced(first, begin), advanced(first, end), func);
+            });
+    }
+
+    template <typename Iterator, typename Predicate>
+    static size_t countIf(Execution policy, Iterator first, Iterator last, Predicate predicate) {
+        size_t count = static_cast<size_t>(std::distance(first, last));
+        size_t parts = workerCount(count, policy);
+        std::vector<size_t> counts(parts);
+        forRanges(count, parts, [first, &predicate, &counts](size_t part, size_t begin, size_t end) {
+            counts[part] = static_cast<size_t>(std::count_if(advanced(first, begin), advanced(first, end), predicate));
+            });
+        size_t total = 0;
+        for (size_t value : counts) {
+            total += value;
+        }
+        return total;
+    }
+
+    // Части прекращают проверку, как только где-то найдено совпадение
+    template <typename Iterator, typename Predicate>
+    static bool anyOf(Execution policy, Iterator first, Iterator last, Predicate predicate) {
+        size_t count = static_cast<size_t>(std::distance(first, last));
+        std::atomic<bool> found(false);
+        forRanges(count, workerCount(count, policy), [first, &predicate, &found](size_t, size_t begin, size_t end) {
+            Iterator it = advanced(first, begin);
+            for (size_t i = begin; i < end; ++i, ++it) {
+                if ((i & 1023) == 0 && found.load(std::memory_order_relaxed)) return;
+                if (predicate(*it)) {
+                    found.store(true, std::memory_order_relaxed);
+                    return;
+                }
+            }
+            });
+        return found.load();
+    }
+
+    // Отобранные элементы в исходном порядке
+    template <typename Iterator, typename Predicate>
+    static std::vector<typename std::iterator_traits<Iterator>::value_type> copyIf(Execution policy,
+        Iterator first, Iterator last, Predicate predicate) {
+        using Value = typename std::iterator_traits<Iterator>::value_type;
+        size_t count = static_cast<size_t>(std::distance(first, last));
+        size_t parts = workerCount(count, policy);
+        std::vector<std::vector<Value>> found(parts);
+        forRanges(count, parts, [first, &predicate, &found](size_t part, size_t begin, size_t end) {
+            std::copy_if(advanced(first, begin), advanced(first, end), std::back_inserter(found[part]), predicate);
+            });
+        if (parts == 1) {
+            return std::move(found[0]);
+        }
+        size_t total = 0;
+        for (const auto& part : found) {
+            total += part.size();
+        }
+        std::vector<Value> result;
+        result.reserve(total);
+        for (auto& part : found) {
+            std::move(part.begin(), part.end(), std::back_inserter(result));
+        }
+        return result;
+    }
+
+    // Первый из наибольших, как std::max_element
+    template <typename Iterator, typename Compare>
+    static Iterator maxElement(Execution policy, Iterator first, Iterator last, Compare less) {
+        size_t count = static_cast<size_t>(std::distance(first, last));
+        size_t parts = workerCount(count, policy);
+        std::vector<Iterator> best(parts, last);
+        forRanges(count, parts, [first, &less, &best](size_t part, size_t begin, size_t end) {
+            if (begin < end) {
+                best[part] = std::max_element(advanced(first, begin), advanced(first, end), less);
+            }
+            });
+        Iterator result = last;
+        for (Iterator candidate : best) {
+            if (candidate != last && (result == last || less(*result, *candidate))) {
+                result = candidate;
+            }
+        }
+        return result;
+    }
+
+    // Части сортируются параллельно, затем сливаются попарно (слияния одного
+    // уровня тоже параллельны). Как и std::sort, порядок равных не гарантируется
+    template <typename RandomIterator, typename Compare>
+    static void sort(Execution policy, RandomIterator first, RandomIterator last, Compare less) {
+        size_t count = static_cast<size_t>(last - first);
+        size_t parts = workerCount(count, policy);
+        if (parts <= 1) {
+            std::sort(first, last, less);
+            return;
+        }
+        forRanges(count, parts, [first, &less](size_t, size_t begin, size_t end) {
+            std::sort(first + begin, first + end, less);
+            });
+
+        std::vector<size_t> bounds(parts + 1);
+        for (size_t part = 0; part <= parts; ++part) {
+            bounds[part] = count * part / parts;
+        }
+        while (bounds.size() > 2) {
+            size_t merges = (bounds.size() - 1) / 2;
+            forRanges(merges, merges, [first, &less, &bounds](size_t, size_t begin, size_t end) {
+                for (size_t merge = begin; merge < end; ++merge) {
+                    std::inplace_merge(first + bounds[2 * merge], first + bounds[2 * merge + 1],
+                        first + bounds[2 * merge + 2], less);
+                }
+                });
+            std::vector<size_t> next;
+            for (size_t i = 0; i < bounds.size(); i += 2) {
+                next.push_back(bounds[i]);
+            }
+            if (next.back() != bounds.back()) {
+                next.push_back(bounds.back());
+            }
+            bounds.swap(next);
+        }
+    }
+
+    // Удаляет элементы, для которых predicate истинен, сохраняя порядок остальных;
+    // проверка параллельна, сдвиг - в текущем потоке. Возвращает новый конец
+    template <typename RandomIterator, typename Predicate>
+    static RandomIterator removeIf(Execution policy, RandomIterator first, RandomIterator last, Predicate predicate) {
+        size_t count = static_cast<size_t>(last - first);
+        size_t parts = workerCount(count, policy);
+        if (parts <= 1) {
+            return std::remove_if(first, last, predicate);
+        }
+        std::vector<char> removed(count);
+        forRanges(count, parts, [first, &predicate, &removed](size_t, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                removed[i] = predicate(first[i]) ? 1 : 0;
+            }
+            });
+        RandomIterator out = first;
+        for (size_t i = 0; i < count; ++i) {
+            if (!removed[i]) {
+                if (out != first + i) {
+                    *out = std::move(first[i]);
+                }
+                ++out;
+            }
+        }
+        return out;
+    }
+};
+
+#endif
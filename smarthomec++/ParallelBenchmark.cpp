@@ -0,0 +1,92 @@
+﻿#include "ParallelBenchmark.hpp"
+#include "DeviceManager.hpp"
+#include <memory>
+#include <chrono>
+#include <random>
+#include <string>
+#include <algorithm>
+
+namespace {
+    // prepare() перед каждым повтором в замер не входит
+    template <typename Prepare, typename F>
+    double bestOf(int repeats, Prepare&& prepare, F&& f) {
+        double best = 0.0;
+        for (int i = 0; i < repeats; i++) {
+            prepare();
+            auto start = std::chrono::steady_clock::now();
+            f();
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            if (i == 0 || elapsed.count() < best) {
+                best = elapsed.count();
+            }
+        }
+        return best;
+    }
+
+    void shufflePower(DeviceManager<Device>& manager, std::mt19937& random) {
+        std::uniform_real_distribution<double> power(0.0, 2000.0);
+        for (const auto& device : manager.getAllDevices()) {
+            device->setPowerConsumption(power(random));
+        }
+    }
+
+    // Последовательная и параллельная сортировка получают одинаковые мощности на входе
+    double timeSort(DeviceManager<Device>& manager, Execution policy, int repeats) {
+        std::mt19937 random(7);
+        return bestOf(repeats, [&manager, &random]() { shufflePower(manager, random); },
+            [&manager, policy]() { manager.sortByPowerConsumption(policy); });
+    }
+
+    size_t crossover(const std::vector<BenchmarkRow>& rows, double BenchmarkRow::* sequential,
+        double BenchmarkRow::* parallel) {
+        size_t result = 0;
+        for (auto it = rows.rbegin(); it != rows.rend(); ++it) {
+            if ((*it).*parallel > (*it).*sequential * ParallelBenchmark::REQUIRED_GAIN) break;
+            result = it->items;
+        }
+        return result;
+    }
+}
+
+std::vector<size_t> ParallelBenchmark::defaultSizes() {
+    return { 1000, 4000, 16000, 64000, 256000 };
+}
+
+std::vector<BenchmarkRow> ParallelBenchmark::run(const std::vector<size_t>& sizes, int repeats) {
+    static const char* MANUFACTURERS[] = { "Яндекс", "Xiaomi", "Philips", "Samsung" };
+    std::vector<BenchmarkRow> rows;
+    std::mt19937 random(42);
+
+    for (size_t items : sizes) {
+        DeviceManager<Device> manager("Замер");
+        for (size_t i = 0; i < items; i++) {
+            manager.addDevice(std::make_shared<Device>("BENCH" + std::to_string(i), "Устройство " + std::to_string(i),
+                MANUFACTURERS[i % 4], static_cast<DeviceType>(i % 5), std::shared_ptr<Room>(), 0.0));
+        }
+        shufflePower(manager, random);
+
+        auto scan = [&manager](Execution policy) {
+            return manager.countDevicesIf(policy, [](const std::shared_ptr<Device>& device) {
+                return device->getPowerConsumption() > 1000.0 && device->getManufacturer() == "Philips";
+                });
+        };
+
+        BenchmarkRow row;
+        row.items = items;
+        auto nothing = []() {};
+        row.scanSequential = bestOf(repeats, nothing, [&scan]() { scan(Execution::SEQUENTIAL); });
+        row.scanParallel = bestOf(repeats, nothing, [&scan]() { scan(Execution::PARALLEL); });
+        row.sortSequential = timeSort(manager, Execution::SEQUENTIAL, repeats);
+        row.sortParallel = timeSort(manager, Execution::PARALLEL, repeats);
+        rows.push_back(row);
+    }
+    return rows;
+}
+
+size_t ParallelBenchmark::scanCrossover(const std::vector<BenchmarkRow>& rows) {
+    return crossover(rows, &BenchmarkRow::scanSequential, &BenchmarkRow::scanParallel);
+}
+
+size_t ParallelBenchmark::sortCrossover(const std::vector<BenchmarkRow>& rows) {
+    return crossover(rows, &BenchmarkRow::sortSequential, &BenchmarkRow::sortParallel);
+}
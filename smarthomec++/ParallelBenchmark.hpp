@@ -0,0 +1,37 @@
+﻿#ifndef PARALLELBENCHMARK_HPP
+#define PARALLELBENCHMARK_HPP
+
+#include <cstddef>
+#include <vector>
+
+// Замер одного размера: лучшее из нескольких повторов, мс
+struct BenchmarkRow {
+    size_t items;
+    double scanSequential;
+    double scanParallel;
+    double sortSequential;
+    double sortParallel;
+};
+
+// Сравнение последовательных и параллельных алгоритмов DeviceManager на
+// временных устройствах вне комнат (проход с фильтром и сортировка по мощности).
+// Устройства замера размещаются make_shared мимо ObjectPool: пул не возвращает
+// блоки куче, и сотни тысяч временных устройств остались бы в нем до выхода
+// Нужен для выбора порога Parallel::setCutoff на конкретной машине
+class ParallelBenchmark {
+public:
+    // Параллельный вариант считается быстрее, только если время не больше этой
+    // доли последовательного: мелкие колебания замера не сдвигают порог
+    static constexpr double REQUIRED_GAIN = 0.9;
+
+    static std::vector<size_t> defaultSizes();
+
+    static std::vector<BenchmarkRow> run(const std::vector<size_t>& sizes, int repeats = 3);
+
+    // Наименьший размер, начиная с которого параллельный вариант быстрее на всех
+    // бо́льших замерах; 0, если такого нет
+    static size_t scanCrossover(const std::vector<BenchmarkRow>& rows);
+    static size_t sortCrossover(const std::vector<BenchmarkRow>& rows);
+};
+
+#endif
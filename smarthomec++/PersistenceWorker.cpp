@@ -0,0 +1,154 @@
+﻿#include "PersistenceWorker.hpp"
+#include "Snapshot.hpp"
+#include "Journal.hpp"
+#include <chrono>
+#include <iterator>
+
+const int PersistenceWorker::COALESCE_MILLISECONDS;
+
+PersistenceWorker::PersistenceWorker(const std::string& snapshotFile, const std::string& journalFile)
+    : snapshotPath(snapshotFile), journalPath(journalFile), hasSnapshot(false),
+    busy(false), urgent(false), stopping(false), failed(false),
+    snapshotWrites(0), journalWrites(0) {
+    thread = std::thread(&PersistenceWorker::run, this);
+}
+
+PersistenceWorker::~PersistenceWorker() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+void PersistenceWorker::submitArchive(ArchiveBatch batch) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        archiveBatches.push_back(std::move(batch));
+    }
+    wake.notify_one();
+}
+
+void PersistenceWorker::submitJournal(const std::vector<char>& records) {
+    if (records.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        journalAfterSnapshot.insert(journalAfterSnapshot.end(), records.begin(), records.end());
+    }
+    wake.notify_one();
+}
+
+void PersistenceWorker::submitSnapshot(std::vector<char> image) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // Предыдущий ожидающий снимок устарел; все записи журнала до этого момента входят в новый
+        snapshotImage = std::move(image);
+        hasSnapshot = true;
+        journalBeforeSnapshot.insert(journalBeforeSnapshot.end(),
+            journalAfterSnapshot.begin(), journalAfterSnapshot.end());
+        journalAfterSnapshot.clear();
+    }
+    wake.notify_one();
+}
+
+bool PersistenceWorker::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    urgent = true;
+    wake.notify_one();
+    idle.wait(lock, [this]() { return !hasWork() && !busy; });
+    urgent = false;
+
+    bool ok = !failed;
+    failed = false;
+    return ok;
+}
+
+size_t PersistenceWorker::getSnapshotWrites() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return snapshotWrites;
+}
+
+size_t PersistenceWorker::getJournalWrites() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return journalWrites;
+}
+
+bool PersistenceWorker::hasWork() const {
+    return !archiveBatches.empty() || hasSnapshot || !journalBeforeSnapshot.empty() ||
+        !journalAfterSnapshot.empty();
+}
+
+void PersistenceWorker::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this]() { return stopping || hasWork(); });
+        if (!hasWork()) {
+            break;  // остановка без заданий
+        }
+
+        // Окно объединения: пачка изменений подряд превращается в одну запись
+        wake.wait_for(lock, std::chrono::milliseconds(COALESCE_MILLISECONDS),
+            [this]() { return stopping || urgent; });
+
+        std::vector<ArchiveBatch> batches;
+        batches.swap(failedArchive);
+        batches.insert(batches.end(), std::make_move_iterator(archiveBatches.begin()),
+            std::make_move_iterator(archiveBatches.end()));
+        archiveBatches.clear();
+        bool writeSnapshot = hasSnapshot;
+        std::vector<char> image;
+        std::vector<char> before;
+        std::vector<char> after;
+        image.swap(snapshotImage);
+        before.swap(journalBeforeSnapshot);
+        after.swap(journalAfterSnapshot);
+        hasSnapshot = false;
+        busy = true;
+        lock.unlock();
+
+        bool ok = true;
+        size_t snapshots = 0, appends = 0;
+        size_t archived = 0;
+        while (archived < batches.size() && batches[archived].write()) {
+            archived++;
+        }
+        batches.erase(batches.begin(), batches.begin() + archived);
+        if (writeSnapshot) {
+            if (batches.empty() && Snapshot::writeImage(snapshotPath, image)) {
+                snapshots++;
+                // Записи до снимка уже в нем; сбой очистки не страшен - повтор идемпотентен
+                Journal::truncateFile(journalPath);
+            }
+            else {
+                // Снимок не записан (или не записан архив, без которого он неполон) -
+                // сохраняем записи журнала, чтобы изменения не пропали
+                ok = false;
+                after.insert(after.begin(), before.begin(), before.end());
+            }
+        }
+        if (!after.empty()) {
+            if (Journal::appendFile(journalPath, after.data(), after.size())) {
+                appends++;
+            }
+            else {
+                ok = false;
+            }
+        }
+
+        if (!batches.empty()) {
+            ok = false;
+        }
+
+        lock.lock();
+        failedArchive.swap(batches);
+        busy = false;
+        snapshotWrites += snapshots;
+        journalWrites += appends;
+        if (!ok) failed = true;
+        if (!hasWork()) {
+            idle.notify_all();
+        }
+    }
+    idle.notify_all();
+}
@@ -0,0 +1,75 @@
+﻿#ifndef PERSISTENCEWORKER_HPP
+#define PERSISTENCEWORKER_HPP
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "NotificationArchive.hpp"
+
+// Фоновый поток записи снимка и журнала.
+//
+// Основной поток кодирует данные (Journal::takePending, Snapshot::encode) и передает
+// готовые байты; запись на диск выполняется здесь. Задания, пришедшие пока поток
+// пишет или ждет окна объединения, сливаются: записи журнала дописываются одной
+// операцией, из нескольких снимков пишется только последний.
+//
+// Порядок на диске сохраняется: сегменты архива уведомлений пишутся раньше снимка,
+// который их уже не содержит; снимок переименовывается раньше, чем очищается
+// журнал, а записи, переданные после снимка, дописываются уже после очистки.
+// Пока какой-либо сегмент архива не записан, снимки не пишутся: незаписанные
+// сегменты повторяются в следующем цикле записи
+class PersistenceWorker {
+private:
+    std::string snapshotPath;
+    std::string journalPath;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::thread thread;
+
+    std::vector<ArchiveBatch> archiveBatches;
+    // Не записанные из-за ошибки; повторяются, когда появится новое задание
+    std::vector<ArchiveBatch> failedArchive;
+    bool hasSnapshot;
+    std::vector<char> snapshotImage;
+    // Записи журнала до и после ожидающего снимка: первые нужны, только если снимок не запишется
+    std::vector<char> journalBeforeSnapshot;
+    std::vector<char> journalAfterSnapshot;
+
+    bool busy;
+    bool urgent;
+    bool stopping;
+    bool failed;
+
+    size_t snapshotWrites;
+    size_t journalWrites;
+
+    bool hasWork() const;
+    void run();
+
+public:
+    // Сколько ждать новых заданий перед записью
+    static const int COALESCE_MILLISECONDS = 50;
+
+    PersistenceWorker(const std::string& snapshotFile, const std::string& journalFile);
+    ~PersistenceWorker();
+
+    PersistenceWorker(const PersistenceWorker&) = delete;
+    PersistenceWorker& operator=(const PersistenceWorker&) = delete;
+
+    void submitArchive(ArchiveBatch batch);
+    void submitJournal(const std::vector<char>& records);
+    void submitSnapshot(std::vector<char> image);
+
+    // Ждет записи всех переданных заданий без окна объединения.
+    // false, если с прошлого flush() какая-либо запись не удалась
+    bool flush();
+
+    size_t getSnapshotWrites();
+    size_t getJournalWrites();
+};
+
+#endif
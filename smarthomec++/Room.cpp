@@ -1,87 +1,183 @@
 ﻿#include "room.hpp"
 #include "device.hpp"
+#include "FieldTokenizer.hpp"
+#include "DeviceStateTable.hpp"
 #include <iostream>
 #include <sstream>
 #include <memory>
 #include <stdexcept>
 #include <algorithm>
+#include <functional>
+
+namespace {
+    SlotMap<Room>& slots() {
+        static SlotMap<Room> map;
+        return map;
+    }
+
+    // Закрепляет устройство слота; nullptr, если его удаление уже началось.
+    // Вызывается под membersMutex: до выхода из комнаты объект Device не освобожден
+    std::shared_ptr<Device> pin(uint32_t slot) {
+        return Device::atSlot(slot)->weak_from_this().lock();
+    }
+}
 
 Room::Room(const std::string& id, const std::string& roomName, double roomArea)
-    : BaseEntity(id, roomName), area(roomArea) {}
+    : BaseEntity(id, roomName), area(roomArea), handle(slots().insert(this)) {
+    DeviceStateTable::instance().activateRoom(handle.index);
+}
 
 Room::Room(const Room& other)
-    : BaseEntity(other.id + "_copy", other.name + " (Copy)"),
-    area(other.area) {
-    for (const auto& device : other.devices) {
-        devices.push_back(std::shared_ptr<Device>(device->clone()));
+    : BaseEntity(other.id + "_copy", other.name + " (Copy)"), Versioned<Room>(other),
+    area(other.area), handle(slots().insert(this)) {
+    DeviceStateTable::instance().activateRoom(handle.index);
+    for (const std::shared_ptr<Device>& device : other.getDevices()) {
+        ownedClones.push_back(std::shared_ptr<Device>(device->clone()));
+        std::unique_lock<std::shared_mutex> lock(membersMutex);
+        attach(*ownedClones.back());
     }
 }
 
 Room::~Room() {
-    devices.clear();
+    DeviceStateTable& table = DeviceStateTable::instance();
+    {
+        std::unique_lock<std::shared_mutex> lock(membersMutex);
+        for (uint32_t slot : members) {
+            table.setRoom(slot, DeviceStateTable::NO_ROOM);
+        }
+        members.clear();
+    }
+    slots().erase(handle);
+}
+
+void Room::attach(Device& device) {
+    DeviceStateTable& table = DeviceStateTable::instance();
+    uint32_t slot = device.getStateIndex();
+    if (table.room(slot) == handle.index) return;
+    table.setRoomPosition(slot, static_cast<uint32_t>(members.size()));
+    members.push_back(slot);
+    table.setRoom(slot, handle.index);
+    device.assignRoom(handle);
+}
+
+void Room::detach(const Device& device) {
+    DeviceStateTable& table = DeviceStateTable::instance();
+    uint32_t slot = device.getStateIndex();
+    uint32_t position = table.roomPosition(slot);
+    uint32_t last = members.back();
+    members[position] = last;
+    table.setRoomPosition(last, position);
+    members.pop_back();
+    table.setRoom(slot, DeviceStateTable::NO_ROOM);
+}
+
+void Room::renumber() {
+    DeviceStateTable& table = DeviceStateTable::instance();
+    for (size_t i = 0; i < members.size(); i++) {
+        table.setRoomPosition(members[i], static_cast<uint32_t>(i));
+    }
 }
 
 Room& Room::operator+=(std::shared_ptr<Device> device) {
-    devices.push_back(device);
+    addDevice(device);
     return *this;
 }
 
 Room& Room::operator-=(std::shared_ptr<Device> device) {
-    for (auto it = devices.begin(); it != devices.end(); ++it) {
-        if (*it == device) {
-            devices.erase(it);
-            break;
-        }
-    }
+    removeDevice(device);
     return *this;
 }
 
 std::shared_ptr<Device> Room::operator[](size_t index) const {
-    if (index >= devices.size()) {
+    std::shared_lock<std::shared_mutex> lock(membersMutex);
+    if (index >= members.size()) {
         throw std::out_of_range("Индекс выходит за пределы диапазона");
     }
-    return devices[index];
+    return pin(members[index]);
 }
 
 std::ostream& operator<<(std::ostream& os, const Room& room) {
     os << "Комната: " << room.name << " (ID: " << room.id << ")\n";
     os << "  Площадь: " << room.area << " м²\n";
-    os << "  Устройств: " << room.devices.size();
+    os << "  Устройств: " << room.getDeviceCount();
     return os;
 }
 
 void Room::addDevice(std::shared_ptr<Device> device) {
-    devices.push_back(device);
+    if (!device || containsDevice(*device)) return;
+    // Из прежней комнаты устройство уходит до блокировки этой: две комнаты
+    // никогда не блокируются одновременно
+    Room* previous = atSlot(DeviceStateTable::instance().room(device->getStateIndex()));
+    if (previous) {
+        previous->removeDevice(*device);
+    }
+    touch();
+    std::unique_lock<std::shared_mutex> lock(membersMutex);
+    attach(*device);
 }
 
 void Room::removeDevice(std::shared_ptr<Device> device) {
-    for (auto it = devices.begin(); it != devices.end(); ++it) {
-        if (*it == device) {
-            devices.erase(it);
-            break;
-        }
+    if (device) {
+        removeDevice(*device);
     }
 }
 
+void Room::removeDevice(const Device& device) {
+    std::unique_lock<std::shared_mutex> lock(membersMutex);
+    if (!containsDevice(device)) return;
+    touch();
+    detach(device);
+}
+
+bool Room::containsDevice(const Device& device) const {
+    return DeviceStateTable::instance().room(device.getStateIndex()) == handle.index;
+}
+
+size_t Room::getDeviceCount() const {
+    std::shared_lock<std::shared_mutex> lock(membersMutex);
+    return members.size();
+}
+
+size_t Room::getActiveDeviceCount() const {
+    return DeviceStateTable::instance().roomLoad(handle.index).activeCount;
+}
+
 std::vector<std::shared_ptr<Device>> Room::getDevices() const {
-    return devices;
+    std::shared_lock<std::shared_mutex> lock(membersMutex);
+    std::vector<std::shared_ptr<Device>> result;
+    result.reserve(members.size());
+    for (uint32_t slot : members) {
+        std::shared_ptr<Device> device = pin(slot);
+        if (device) {
+            result.push_back(std::move(device));
+        }
+    }
+    return result;
 }
 
-double Room::calculateRoomPowerConsumption() const {
-    double totalPower = 0.0;
-    for (const auto& device : devices) {
-        if (device->getIsOn()) {
-            totalPower += device->getPowerConsumption();
+void Room::forEachDevice(const std::function<void(const Device&)>& func) const {
+    std::shared_lock<std::shared_mutex> lock(membersMutex);
+    for (uint32_t slot : members) {
+        std::shared_ptr<Device> device = pin(slot);
+        if (device) {
+            func(*device);
         }
     }
-    return totalPower;
+}
+
+double Room::calculateRoomPowerConsumption() const {
+    return DeviceStateTable::instance().roomLoad(handle.index).activePower;
 }
 
 void Room::displayDevices() const {
     std::cout << "Устройства в " << name << ":\n";
-    for (size_t i = 0; i < devices.size(); i++) {
-        std::cout << "  " << i + 1 << ". " << devices[i]->getName()
-            << " (" << devices[i]->getStatus() << ")\n";
+    std::shared_lock<std::shared_mutex> lock(membersMutex);
+    size_t number = 0;
+    for (uint32_t slot : members) {
+        std::shared_ptr<Device> device = pin(slot);
+        if (!device) continue;
+        std::cout << "  " << ++number << ". " << device->getName()
+            << " (" << device->getStatus() << ")\n";
     }
 }
 
@@ -89,50 +185,70 @@ double Room::getArea() const {
     return area;
 }
 
+uint32_t Room::getStateIndex() const {
+    return handle.index;
+}
+
+Handle<Room> Room::getHandle() const {
+    return handle;
+}
+
 // Новые методы для поиска и сортировки
 std::shared_ptr<Device> Room::findDeviceByName(const std::string& name) const {
-    auto it = find_if(devices.begin(), devices.end(),
-        [&name](const std::shared_ptr<Device>& device) {
-            return device->getName() == name;
-        });
-
-    if (it != devices.end()) {
-        return *it;
+    std::shared_lock<std::shared_mutex> lock(membersMutex);
+    for (uint32_t slot : members) {
+        std::shared_ptr<Device> device = pin(slot);
+        if (device && device->getName() == name) {
+            return device;
+        }
     }
     return nullptr;
 }
 
 std::vector<std::shared_ptr<Device>> Room::findDevicesByType(DeviceType type) const {
     std::vector<std::shared_ptr<Device>> result;
+    const DeviceStateTable& table = DeviceStateTable::instance();
 
-    copy_if(devices.begin(), devices.end(), back_inserter(result),
-        [type](const std::shared_ptr<Device>& device) {
-            return device->getDeviceType() == type;
-        });
+    std::shared_lock<std::shared_mutex> lock(membersMutex);
+    for (uint32_t slot : members) {
+        if (table.type(slot) != type) continue;
+        std::shared_ptr<Device> device = pin(slot);
+        if (device) {
+            result.push_back(std::move(device));
+        }
+    }
 
     return result;
 }
 
 void Room::sortDevicesByPower(bool ascending) {
+    touch();
+    const DeviceStateTable& table = DeviceStateTable::instance();
+    std::unique_lock<std::shared_mutex> lock(membersMutex);
     if (ascending) {
-        sort(devices.begin(), devices.end(),
-            [](const std::shared_ptr<Device>& a, const std::shared_ptr<Device>& b) {
-                return a->getPowerConsumption() < b->getPowerConsumption();
+        sort(members.begin(), members.end(),
+            [&table](uint32_t a, uint32_t b) {
+                return table.power(a) < table.power(b);
             });
     }
     else {
-        sort(devices.begin(), devices.end(),
-            [](const std::shared_ptr<Device>& a, const std::shared_ptr<Device>& b) {
-                return a->getPowerConsumption() > b->getPowerConsumption();
+        sort(members.begin(), members.end(),
+            [&table](uint32_t a, uint32_t b) {
+                return table.power(a) > table.power(b);
             });
     }
+    renumber();
 }
 
 void Room::sortDevicesByName() {
-    sort(devices.begin(), devices.end(),
-        [](const std::shared_ptr<Device>& a, const std::shared_ptr<Device>& b) {
-            return a->getName() < b->getName();
-        });
+    touch();
+    std::unique_lock<std::shared_mutex> lock(membersMutex);
+    CollationKey::sort(members.begin(), members.end(),
+        [](uint32_t slot) -> const CollationKey& {
+            return Device::atSlot(slot)->getNameKey();
+        },
+        std::less<uint32_t>());
+    renumber();
 }
 
 std::string Room::serialize() const {
@@ -144,7 +260,7 @@ std::string Room::serialize() const {
 void Room::displayInfo() const {
     std::cout << "Комната: " << name << " (ID: " << id << ")" << std::endl;
     std::cout << "  Площадь: " << area << " м²" << std::endl;
-    std::cout << "  Устройств: " << devices.size() << std::endl;
+    std::cout << "  Устройств: " << getDeviceCount() << std::endl;
     std::cout << "  Текущее потребление: " << calculateRoomPowerConsumption() << " Вт" << std::endl;
 }
 
@@ -153,18 +269,19 @@ BaseEntity* Room::clone() const {
 }
 
 std::shared_ptr<Room> Room::deserialize(const std::string& data) {
-    try {
-        std::stringstream ss(data);
-        std::string id, name, areaStr;
-
-        std::getline(ss, id, '|');
-        std::getline(ss, name, '|');
-        std::getline(ss, areaStr, '|');
-
-        return std::make_shared<Room>(id, name, std::stod(areaStr));
-    }
-    catch (const std::exception& e) {
-        std::cerr << "Ошибка десериализации комнаты: " << e.what() << std::endl;
+    FieldTokenizer fields(data);
+    double area = 0.0;
+    if (!fields.getDouble(2, area)) {
+        std::cerr << "Ошибка десериализации комнаты: " << fields.errorText() << std::endl;
         return nullptr;
     }
+    return std::make_shared<Room>(fields.text(0), fields.text(1), area);
+}
+
+Room* Room::find(Handle<Room> handle) {
+    return slots().get(handle);
+}
+
+Room* Room::atSlot(uint32_t index) {
+    return slots().at(index);
 }
\ No newline at end of file
@@ -4,19 +4,47 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <cstdint>
+#include <shared_mutex>
+#include <functional>
 #include "BaseEntity.hpp"
+#include "Versioned.hpp"
+#include "SlotMap.hpp"
 #include "deviceType.hpp"
 
 class Device;
 
-class Room : public BaseEntity {
+// Комната не владеет устройствами: ими владеют система и реестр, а комната
+// хранит плотный список их слотов. Позиция устройства в этом списке лежит в
+// DeviceStateTable, поэтому проверка принадлежности и удаление - O(1).
+// Владелец выводит устройство из комнаты до удаления; деструктор Device делает
+// это сам, если владелец не успел.
+//
+// Список защищен блокировкой чтения/записи комнаты: читать его можно из других
+// потоков (отчеты, сценарии). Устройства выдаются закрепленными (shared_ptr),
+// а устройство, чья последняя ссылка уже освобождена, пропускается. Сами
+// устройства из другого потока только читаются. Две комнаты одновременно не
+// блокируются
+class Room : public BaseEntity, public Versioned<Room> {
 private:
     double area;
-    std::vector<std::shared_ptr<Device>> devices;
+    std::vector<uint32_t> members;
+    mutable std::shared_mutex membersMutex;
+    // Копии устройств из конструктора копирования: кроме комнаты, ими никто не владеет
+    std::vector<std::shared_ptr<Device>> ownedClones;
+    Handle<Room> handle;
+
+    // Вызываются под membersMutex на запись. attach заодно переводит location
+    // устройства на эту комнату
+    void attach(Device& device);
+    void detach(const Device& device);
+    // Записывает позиции после перестановки списка
+    void renumber();
 
 public:
     Room(const std::string& id, const std::string& roomName, double roomArea);
     Room(const Room& other);
+    Room& operator=(const Room& other) = delete;
     ~Room();
 
     Room& operator+=(std::shared_ptr<Device> device);
@@ -24,14 +52,25 @@ public:
     std::shared_ptr<Device> operator[](size_t index) const;
     friend std::ostream& operator<<(std::ostream& os, const Room& room);
 
+    // Устройство из другой комнаты переносится; повторное добавление ничего не меняет
     void addDevice(std::shared_ptr<Device> device);
+    // Последнее устройство списка занимает место удаленного
     void removeDevice(std::shared_ptr<Device> device);
+    void removeDevice(const Device& device);
+    bool containsDevice(const Device& device) const;
+    size_t getDeviceCount() const;
+    size_t getActiveDeviceCount() const;
+    // Копия списка; для простого обхода дешевле forEachDevice
     std::vector<std::shared_ptr<Device>> getDevices() const;
+    // Обход под блокировкой списка: колбэк не должен менять комнату
+    void forEachDevice(const std::function<void(const Device&)>& func) const;
     double calculateRoomPowerConsumption() const;
     void displayDevices() const;
     double getArea() const;
+    uint32_t getStateIndex() const;
+    Handle<Room> getHandle() const;
 
-    //      
+    // Новые методы для поиска и сортировки
     std::shared_ptr<Device> findDeviceByName(const std::string& name) const;
     std::vector<std::shared_ptr<Device>> findDevicesByType(DeviceType type) const;
     void sortDevicesByPower(bool ascending = true);
@@ -42,6 +81,9 @@ public:
     BaseEntity* clone() const override;
 
     static std::shared_ptr<Room> deserialize(const std::string& data);
+    // Живая комната по дескриптору или по индексу слота; nullptr, если удалена
+    static Room* find(Handle<Room> handle);
+    static Room* atSlot(uint32_t index);
 };
 
 #endif
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "scenarioAction.hpp"
 #include "device.hpp"
+#include "EntityRegistry.hpp"
+#include "FieldTokenizer.hpp"
 #include <iostream>
 #include <sstream>
 #include <memory>
@@ -12,7 +14,7 @@ ScenarioAction::~ScenarioAction() {
 }
 
 void ScenarioAction::execute() {
-    std::cout << " : " << command << "  : ";
+    std::cout << "Выполнение действия: " << command << " на устройстве: ";
     if (targetDevice) {
         std::cout << targetDevice->getName() << std::endl;
 
@@ -24,7 +26,7 @@ void ScenarioAction::execute() {
         }
     }
     else {
-        std::cout << "  " << std::endl;
+        std::cout << "Устройство не найдено" << std::endl;
     }
 }
 
@@ -33,9 +35,9 @@ void ScenarioAction::addParameter(const std::string& key, const std::string& val
 }
 
 void ScenarioAction::displayInfo() const {
-    std::cout << " " << actionId << ": " << command;
+    std::cout << "Действие " << actionId << ": " << command;
     if (targetDevice) {
-        std::cout << "  " << targetDevice->getName();
+        std::cout << " на " << targetDevice->getName();
     }
     std::cout << std::endl;
 }
@@ -67,10 +69,12 @@ std::string ScenarioAction::serialize() const {
 }
 
 std::unique_ptr<ScenarioAction> ScenarioAction::deserialize(const std::string& data, std::shared_ptr<Device> device) {
-    std::stringstream ss(data);
-    std::string id, deviceId, command;
-    std::getline(ss, id, '|');
-    std::getline(ss, deviceId, '|');
-    std::getline(ss, command, '|');
-    return std::make_unique<ScenarioAction>(id, device, command);
+    FieldTokenizer fields(data);
+    return std::make_unique<ScenarioAction>(fields.text(0), device, fields.text(2));
+}
+
+// Целевое устройство находится по ID через реестр
+std::unique_ptr<ScenarioAction> ScenarioAction::deserialize(const std::string& data, const EntityRegistry& registry) {
+    FieldTokenizer fields(data);
+    return std::make_unique<ScenarioAction>(fields.text(0), registry.findDevice(fields.text(1)), fields.text(2));
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <memory>
 
 class Device;
+class EntityRegistry;
 
 class ScenarioAction {
 private:
@@ -29,6 +30,7 @@ public:
 
     std::string serialize() const;
     static std::unique_ptr<ScenarioAction> deserialize(const std::string& data, std::shared_ptr<Device> device);
+    static std::unique_ptr<ScenarioAction> deserialize(const std::string& data, const EntityRegistry& registry);
 };
 
 #endif
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "securityDevice.hpp"
 #include "room.hpp"
+#include "BinaryIO.hpp"
+#include "ObjectPool.hpp"
 #include <sstream>
 #include <iostream>
 #include <algorithm>
@@ -16,56 +18,57 @@ SecurityDevice::SecurityDevice(const std::string& id, const std::string& deviceN
 
 SecurityDevice::SecurityDevice(const SecurityDevice& other)
     : Device(other.id + "_copy", other.name + " (Copy)", other.manufacturer,
-        other.deviceType, other.location, other.powerConsumption),
+        other.getDeviceType(), other.location, other.getPowerConsumption()),
     isArmed(other.isArmed),
     accessCodes(other.accessCodes),
     sensitivityLevel(other.sensitivityLevel),
     motionDetected(other.motionDetected) {
-    this->isOn = other.isOn;
-    this->isOnline = other.isOnline;
+    copyState(other);
 }
 
 SecurityDevice::~SecurityDevice() {
 }
 
 void SecurityDevice::turnOn() {
-    isOn = true;
-    std::cout << "  " << name << " " << std::endl;
+    touch();
+    setOnFlag(true);
+    std::cout << "Устройство безопасности " << name << " активировано" << std::endl;
 }
 
 void SecurityDevice::turnOff() {
-    isOn = false;
+    touch();
+    setOnFlag(false);
     isArmed = false;
-    std::cout << "  " << name << " " << std::endl;
+    std::cout << "Устройство безопасности " << name << " деактивировано" << std::endl;
 }
 
 std::string SecurityDevice::getDetails() const {
     std::string baseInfo = Device::getDetails();
     std::stringstream ss;
     ss << baseInfo
-        << " : " << (isArmed ? "" : "") << "\n"
-        << ": " << sensitivityLevel << "\n"
-        << " : " << (motionDetected ? "" : "") << "\n"
-        << " : " << accessCodes.size() << "\n";
+        << "Состояние охраны: " << (isArmed ? "АКТИВИРОВАНА" : "ОТКЛЮЧЕНА") << "\n"
+        << "Чувствительность: " << sensitivityLevel << "\n"
+        << "Обнаружено движение: " << (motionDetected ? "ДА" : "НЕТ") << "\n"
+        << "Кодов доступа: " << accessCodes.size() << "\n";
     return ss.str();
 }
 
 void SecurityDevice::performSelfCheck() const {
-    std::cout << "  : " << name << std::endl;
-    std::cout << "  : " << (isOn ? "" : "") << std::endl;
-    std::cout << "  : " << (isArmed ? "" : "") << std::endl;
-    std::cout << "  : " << sensitivityLevel << "/10" << std::endl;
-    std::cout << "   : " << (motionDetected ? "" : "") << std::endl;
+    std::cout << "Проверка устройства безопасности: " << name << std::endl;
+    std::cout << "  Статус: " << (getIsOn() ? "ВКЛ" : "ВЫКЛ") << std::endl;
+    std::cout << "  Охрана: " << (isArmed ? "АКТИВИРОВАНА" : "ОТКЛЮЧЕНА") << std::endl;
+    std::cout << "  Чувствительность: " << sensitivityLevel << "/10" << std::endl;
+    std::cout << "  Обнаружено движение: " << (motionDetected ? "ДА" : "НЕТ") << std::endl;
 }
 
 double SecurityDevice::calculateEfficiency() const {
-    if (!isOn) return 0.0;
+    if (!getIsOn()) return 0.0;
 
     double efficiency = 1.0;
     if (isArmed) efficiency *= 1.5;
     efficiency *= (sensitivityLevel / 10.0);
 
-    return powerConsumption * efficiency;
+    return getPowerConsumption() * efficiency;
 }
 
 SecurityDevice* SecurityDevice::clone() const {
@@ -73,28 +76,31 @@ SecurityDevice* SecurityDevice::clone() const {
 }
 
 void SecurityDevice::arm() {
-    if (isOn) {
+    touch();
+    if (getIsOn()) {
         isArmed = true;
-        std::cout << "    " << name << std::endl;
+        std::cout << "Охрана активирована для устройства " << name << std::endl;
     }
     else {
-        std::cout << "  :  " << std::endl;
+        std::cout << "Нельзя активировать охрану: устройство выключено" << std::endl;
     }
 }
 
 void SecurityDevice::disarm() {
+    touch();
     isArmed = false;
     motionDetected = false;
-    std::cout << "    " << name << std::endl;
+    std::cout << "Охрана отключена для устройства " << name << std::endl;
 }
 
 void SecurityDevice::addAccessCode(const std::string& code) {
+    touch();
     if (code.length() >= 4) {
         accessCodes.push_back(code);
-        std::cout << "  " << std::endl;
+        std::cout << "Код доступа добавлен" << std::endl;
     }
     else {
-        std::cout << "     4 " << std::endl;
+        std::cout << "Код должен содержать не менее 4 символов" << std::endl;
     }
 }
 
@@ -103,19 +109,21 @@ bool SecurityDevice::checkAccessCode(const std::string& code) const {
 }
 
 void SecurityDevice::setSensitivity(int level) {
+    touch();
     if (level >= 1 && level <= 10) {
         sensitivityLevel = level;
-        std::cout << "    " << level << std::endl;
+        std::cout << "Чувствительность установлена на уровень " << level << std::endl;
     }
     else {
-        std::cout << "    1  10" << std::endl;
+        std::cout << "Чувствительность должна быть от 1 до 10" << std::endl;
     }
 }
 
 void SecurityDevice::motionDetection(bool detected) {
+    touch();
     motionDetected = detected;
     if (detected && isArmed) {
-        std::cout << "!     !" << std::endl;
+        std::cout << "ВНИМАНИЕ! Обнаружено движение в охраняемой зоне!" << std::endl;
     }
 }
 
@@ -131,11 +139,49 @@ bool SecurityDevice::getMotionDetected() const {
     return motionDetected;
 }
 
+bool SecurityDevice::hasExtraState() const {
+    return true;
+}
+
+void SecurityDevice::writeExtraState(BinaryWriter& out) const {
+    out.write(static_cast<uint8_t>(isArmed));
+    out.write(static_cast<int32_t>(sensitivityLevel));
+    out.write(static_cast<uint8_t>(motionDetected));
+    out.write(static_cast<uint32_t>(accessCodes.size()));
+    for (const auto& code : accessCodes) {
+        out.write(static_cast<uint32_t>(code.size()));
+        out.writeBytes(code.data(), code.size());
+    }
+}
+
+bool SecurityDevice::readExtraState(BinaryReader& in) {
+    touch();
+    uint8_t armed = 0, motion = 0;
+    int32_t sensitivity = 0;
+    uint32_t codeCount = 0;
+    if (!in.read(armed) || !in.read(sensitivity) || !in.read(motion) || !in.read(codeCount)) {
+        return false;
+    }
+
+    std::vector<std::string> codes(codeCount);
+    for (auto& code : codes) {
+        uint32_t length = 0;
+        if (!in.read(length) || !in.readString(code, length)) return false;
+    }
+
+    isArmed = armed != 0;
+    sensitivityLevel = sensitivity;
+    motionDetected = motion != 0;
+    accessCodes = std::move(codes);
+    return true;
+}
+
 std::string SecurityDevice::serialize() const {
+    Room* room = getLocation();
     std::stringstream ss;
     ss << id << "|" << name << "|" << manufacturer << "|"
-        << static_cast<int>(deviceType) << "|" << (location ? location->getId() : "NULL") << "|"
-        << isOn << "|" << isOnline << "|" << powerConsumption << "|"
+        << static_cast<int>(getDeviceType()) << "|" << (room ? room->getId() : "NULL") << "|"
+        << getIsOn() << "|" << getIsOnline() << "|" << getPowerConsumption() << "|"
         << isArmed << "|" << sensitivityLevel << "|" << motionDetected;
 
     for (const auto& code : accessCodes) {
@@ -146,55 +192,56 @@ std::string SecurityDevice::serialize() const {
 }
 
 void SecurityDevice::displayInfo() const {
-    std::cout << " : " << name << " (ID: " << id << ")" << std::endl;
-    std::cout << "  : " << manufacturer << std::endl;
-    std::cout << "  : " << getStatus() << std::endl;
-    std::cout << "  : " << powerConsumption << " " << std::endl;
-    std::cout << "  : " << (isArmed ? "" : "") << std::endl;
-    std::cout << "  : " << sensitivityLevel << "/10" << std::endl;
-    std::cout << "   : " << (motionDetected ? "" : "") << std::endl;
-    std::cout << "   : " << accessCodes.size() << std::endl;
+    std::cout << "Устройство безопасности: " << name << " (ID: " << id << ")" << std::endl;
+    std::cout << "  Производитель: " << manufacturer << std::endl;
+    std::cout << "  Статус: " << getStatus() << std::endl;
+    std::cout << "  Потребление: " << getPowerConsumption() << " Вт" << std::endl;
+    std::cout << "  Охрана: " << (isArmed ? "АКТИВИРОВАНА" : "ОТКЛЮЧЕНА") << std::endl;
+    std::cout << "  Чувствительность: " << sensitivityLevel << "/10" << std::endl;
+    std::cout << "  Обнаружено движение: " << (motionDetected ? "ДА" : "НЕТ") << std::endl;
+    std::cout << "  Кодов доступа: " << accessCodes.size() << std::endl;
 }
 
 std::shared_ptr<SecurityDevice> SecurityDevice::deserialize(const std::string& data,
     std::shared_ptr<Room> location) {
-    try {
-        std::stringstream ss(data);
-        std::string id, name, manufacturer, typeStr, locationId, isOnStr, isOnlineStr,
-            powerStr, isArmedStr, sensitivityStr, motionStr;
-
-        std::getline(ss, id, '|');
-        std::getline(ss, name, '|');
-        std::getline(ss, manufacturer, '|');
-        std::getline(ss, typeStr, '|');
-        std::getline(ss, locationId, '|');
-        std::getline(ss, isOnStr, '|');
-        std::getline(ss, isOnlineStr, '|');
-        std::getline(ss, powerStr, '|');
-        std::getline(ss, isArmedStr, '|');
-        std::getline(ss, sensitivityStr, '|');
-        std::getline(ss, motionStr, '|');
-
-        auto device = std::make_shared<SecurityDevice>(id, name, manufacturer, location,
-            std::stod(powerStr));
-
-        device->setIsOnline(isOnlineStr == "1");
-        if (isOnStr == "1") device->turnOn();
-        if (isArmedStr == "1") device->arm();
-        device->setSensitivity(std::stoi(sensitivityStr));
-        if (motionStr == "1") device->motionDetection(true);
-
-        std::string code;
-        while (std::getline(ss, code, '|')) {
-            if (!code.empty()) {
-                device->addAccessCode(code);
-            }
-        }
-
-        return device;
+    DeviceFields fields(data);
+    std::shared_ptr<SecurityDevice> device;
+    if (fields.require(FIELD_COUNT)) {
+        device = fromFields(fields, location);
+    }
+    if (!device) {
+        std::cerr << "Ошибка десериализации устройства безопасности: " << fields.errorText() << std::endl;
     }
-    catch (const std::exception& e) {
-        std::cerr << "   : " << e.what() << std::endl;
+    return device;
+}
+
+std::shared_ptr<SecurityDevice> SecurityDevice::fromFields(DeviceFields& fields,
+    std::shared_ptr<Room> location) {
+    double power = 0.0;
+    int sensitivity = 0;
+    if (!fields.getDouble(7, power) || !fields.getInt(9, sensitivity)) {
         return nullptr;
     }
+
+    auto device = makePooled<SecurityDevice>(fields.text(0), fields.text(1), fields.text(2), location,
+        power);
+
+    // Поля переносятся напрямую, без сообщений arm()/setSensitivity()
+    device->restoreState(fields.flag(5), fields.flag(6));
+    device->isArmed = fields.flag(8);
+    device->sensitivityLevel = sensitivity;
+    device->motionDetected = fields.flag(10);
+
+    // Сохраненные коды заменяют код по умолчанию, а не дописываются к нему
+    std::vector<std::string> codes;
+    for (size_t i = FIELD_COUNT; i < fields.size(); ++i) {
+        if (!fields.view(i).empty()) {
+            codes.push_back(fields.text(i));
+        }
+    }
+    if (!codes.empty()) {
+        device->accessCodes = std::move(codes);
+    }
+
+    return device;
 }
\ No newline at end of file
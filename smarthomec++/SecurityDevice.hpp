@@ -1,4 +1,4 @@
-#ifndef SECURITYDEVICE_HPP
+﻿#ifndef SECURITYDEVICE_HPP
 #define SECURITYDEVICE_HPP
 
 #include "device.hpp"
@@ -6,7 +6,7 @@
 #include <memory>
 #include <vector>
 
-class SecurityDevice : public Device {
+class SecurityDevice final : public Device {
 private:
     bool isArmed;
     std::vector<std::string> accessCodes;
@@ -14,6 +14,9 @@ private:
     bool motionDetected;
 
 public:
+    // Базовые поля + охрана, чувствительность, движение; далее коды доступа
+    static const size_t FIELD_COUNT = 11;
+
     SecurityDevice(const std::string& id, const std::string& deviceName,
         const std::string& manuf, std::shared_ptr<Room> room,
         double power = 0.0);
@@ -42,11 +45,17 @@ public:
     int getSensitivityLevel() const;
     bool getMotionDetected() const;
 
+    bool hasExtraState() const override;
+    void writeExtraState(BinaryWriter& out) const override;
+    bool readExtraState(BinaryReader& in) override;
+
     std::string serialize() const override;
     void displayInfo() const override;
 
     static std::shared_ptr<SecurityDevice> deserialize(const std::string& data,
         std::shared_ptr<Room> location);
+    static std::shared_ptr<SecurityDevice> fromFields(DeviceFields& fields,
+        std::shared_ptr<Room> location);
 };
 
 #endif
\ No newline at end of file
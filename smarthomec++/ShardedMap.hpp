@@ -0,0 +1,107 @@
+﻿#ifndef SHARDEDMAP_HPP
+#define SHARDEDMAP_HPP
+
+#include <cstddef>
+#include <atomic>
+#include <functional>
+#include <shared_mutex>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Хеш-таблица, разделенная на SHARD_COUNT независимых частей.
+//
+// Ключ попадает в часть по хешу; у каждой части своя блокировка чтения/записи,
+// поэтому поиск из разных потоков не блокирует друг друга, а запись блокирует
+// только одну часть. Значения возвращаются копией (shared_ptr), так что объект
+// остается жив, даже если его параллельно удалили из таблицы
+template <typename Key, typename Value, size_t SHARD_COUNT = 16>
+class ShardedMap {
+private:
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<Key, Value> entries;
+    };
+
+    Shard shards[SHARD_COUNT];
+    std::atomic<size_t> count;
+
+    Shard& shardFor(const Key& key) {
+        return shards[std::hash<Key>()(key) % SHARD_COUNT];
+    }
+
+    const Shard& shardFor(const Key& key) const {
+        return shards[std::hash<Key>()(key) % SHARD_COUNT];
+    }
+
+public:
+    ShardedMap() : count(0) {}
+
+    ShardedMap(const ShardedMap&) = delete;
+    ShardedMap& operator=(const ShardedMap&) = delete;
+
+    // Добавляет значение, только если ключа еще нет
+    bool insert(const Key& key, const Value& value) {
+        Shard& shard = shardFor(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        if (!shard.entries.emplace(key, value).second) return false;
+        count.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool erase(const Key& key) {
+        Shard& shard = shardFor(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        if (shard.entries.erase(key) == 0) return false;
+        count.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Значение по ключу или Value(), если ключа нет
+    Value find(const Key& key) const {
+        const Shard& shard = shardFor(key);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.entries.find(key);
+        return it != shard.entries.end() ? it->second : Value();
+    }
+
+    // Обход под блокировкой чтения по одной части за раз; func не должна менять таблицу
+    template <typename Func>
+    void forEach(Func func) const {
+        for (const Shard& shard : shards) {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            for (const auto& entry : shard.entries) {
+                func(entry.second);
+            }
+        }
+    }
+
+    // Копия всех значений; таблицу можно менять, пока копия обрабатывается
+    std::vector<Value> values() const {
+        std::vector<Value> result;
+        result.reserve(size());
+        forEach([&result](const Value& value) { result.push_back(value); });
+        return result;
+    }
+
+    void reserve(size_t total) {
+        for (Shard& shard : shards) {
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            shard.entries.reserve(total / SHARD_COUNT + 1);
+        }
+    }
+
+    void clear() {
+        for (Shard& shard : shards) {
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            count.fetch_sub(shard.entries.size(), std::memory_order_relaxed);
+            shard.entries.clear();
+        }
+    }
+
+    size_t size() const {
+        return count.load(std::memory_order_relaxed);
+    }
+};
+
+#endif
@@ -0,0 +1,168 @@
+﻿#ifndef SLOTMAP_HPP
+#define SLOTMAP_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <stdexcept>
+
+// Дескриптор объекта в SlotMap: индекс слота и поколение.
+// После удаления объекта поколение слота растет, и старые дескрипторы
+// перестают разрешаться, даже если слот занял новый объект
+template <typename T>
+struct Handle {
+    static const uint32_t NONE = 0xFFFFFFFF;
+
+    uint32_t index;
+    uint32_t generation;
+
+    Handle() : index(NONE), generation(0) {}
+    Handle(uint32_t slot, uint32_t gen) : index(slot), generation(gen) {}
+
+    bool isNull() const {
+        return index == NONE;
+    }
+
+    bool operator==(const Handle& other) const {
+        return index == other.index && generation == other.generation;
+    }
+
+    bool operator!=(const Handle& other) const {
+        return !(*this == other);
+    }
+};
+
+// Таблица живых объектов с плотными индексами и поколениями.
+//
+// Объекты не принадлежат таблице: они регистрируются в конструкторе и снимаются
+// в деструкторе. Слоты лежат блоками по CHUNK_SIZE, блоки не перемещаются, поэтому
+// get() не берет блокировку и не трогает счетчики ссылок. Вставка и удаление
+// идут под мьютексом (устройства создаются и в потоках загрузчика).
+// Индекс слота совпадает с индексом в колонках DeviceStateTable
+template <typename T>
+class SlotMap {
+public:
+    static const size_t CHUNK_BITS = 12;
+    static const size_t CHUNK_SIZE = size_t(1) << CHUNK_BITS;
+    static const size_t MAX_CHUNKS = 1024;
+
+private:
+    struct Entry {
+        std::atomic<T*> object;
+        std::atomic<uint32_t> generation;
+    };
+
+    struct Chunk {
+        Entry entries[CHUNK_SIZE];
+
+        Chunk() {
+            for (auto& entry : entries) {
+                entry.object.store(nullptr, std::memory_order_relaxed);
+                entry.generation.store(0, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    std::atomic<Chunk*> chunks[MAX_CHUNKS];
+    std::atomic<uint32_t> used;
+    std::atomic<size_t> live;
+    std::vector<uint32_t> freeSlots;
+    std::mutex mutex;
+
+    Entry* find(uint32_t index) const {
+        if (index >= used.load(std::memory_order_acquire)) return nullptr;
+        Chunk* chunk = chunks[index >> CHUNK_BITS].load(std::memory_order_acquire);
+        return chunk ? &chunk->entries[index & (CHUNK_SIZE - 1)] : nullptr;
+    }
+
+public:
+    SlotMap() : used(0), live(0) {
+        for (auto& entry : chunks) {
+            entry.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    ~SlotMap() {
+        for (auto& entry : chunks) {
+            delete entry.load(std::memory_order_relaxed);
+        }
+    }
+
+    SlotMap(const SlotMap&) = delete;
+    SlotMap& operator=(const SlotMap&) = delete;
+
+    Handle<T> insert(T* object) {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint32_t index;
+        if (!freeSlots.empty()) {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else {
+            index = used.load(std::memory_order_relaxed);
+            size_t chunkIndex = index >> CHUNK_BITS;
+            if (chunkIndex >= MAX_CHUNKS) {
+                throw std::length_error("Превышено максимальное число объектов");
+            }
+            if (!chunks[chunkIndex].load(std::memory_order_relaxed)) {
+                chunks[chunkIndex].store(new Chunk(), std::memory_order_release);
+            }
+        }
+        Entry& entry = chunks[index >> CHUNK_BITS].load(std::memory_order_relaxed)->entries[index & (CHUNK_SIZE - 1)];
+        entry.object.store(object, std::memory_order_release);
+        if (index >= used.load(std::memory_order_relaxed)) {
+            used.store(index + 1, std::memory_order_release);
+        }
+        live++;
+        return Handle<T>(index, entry.generation.load(std::memory_order_relaxed));
+    }
+
+    void erase(Handle<T> handle) {
+        std::lock_guard<std::mutex> lock(mutex);
+        Entry* entry = find(handle.index);
+        if (!entry || entry->generation.load(std::memory_order_relaxed) != handle.generation) return;
+        entry->object.store(nullptr, std::memory_order_release);
+        entry->generation.fetch_add(1, std::memory_order_release);
+        freeSlots.push_back(handle.index);
+        live--;
+    }
+
+    // Объект по дескриптору; nullptr, если он уже удален
+    T* get(Handle<T> handle) const {
+        const Entry* entry = find(handle.index);
+        if (!entry || entry->generation.load(std::memory_order_acquire) != handle.generation) return nullptr;
+        return entry->object.load(std::memory_order_acquire);
+    }
+
+    // Живой объект слота или nullptr
+    T* at(uint32_t index) const {
+        const Entry* entry = find(index);
+        return entry ? entry->object.load(std::memory_order_acquire) : nullptr;
+    }
+
+    // Дескриптор текущего объекта слота
+    Handle<T> handleAt(uint32_t index) const {
+        const Entry* entry = find(index);
+        if (!entry || !entry->object.load(std::memory_order_acquire)) return Handle<T>();
+        return Handle<T>(index, entry->generation.load(std::memory_order_acquire));
+    }
+
+    // Граница занятых слотов
+    uint32_t bound() const {
+        return used.load(std::memory_order_acquire);
+    }
+
+    size_t size() const {
+        return live.load();
+    }
+};
+
+template <typename T>
+const uint32_t Handle<T>::NONE;
+
+template <typename T>
+const size_t SlotMap<T>::CHUNK_SIZE;
+
+#endif
@@ -0,0 +1,660 @@
+﻿#include "Snapshot.hpp"
+#include "BinaryIO.hpp"
+#include "Room.hpp"
+#include "Device.hpp"
+#include "DeviceFactory.hpp"
+#include "User.hpp"
+#include "AutomationScenario.hpp"
+#include "Notification.hpp"
+#include "EntityRegistry.hpp"
+#include "LoadTimings.hpp"
+#include "MappedFile.hpp"
+#include <iostream>
+#include <fstream>
+#include <unordered_map>
+#include <future>
+#include <algorithm>
+
+// 1 - базовые поля устройств; 2 - добавлено дополнительное состояние подклассов;
+// 3 - секции разбиты на сегменты
+const uint32_t Snapshot::FORMAT_VERSION = 3;
+const size_t Snapshot::SEGMENT_RECORDS;
+
+namespace {
+
+const char SNAPSHOT_MAGIC[4] = { 'S', 'H', 'S', 'N' };
+const uint32_t NO_STRING = 0xFFFFFFFF;
+
+// Таблица строк секции: одинаковые строки (производители, id комнат) хранятся один раз
+class StringTable {
+private:
+    std::unordered_map<std::string, uint32_t> indices;
+    std::vector<const std::string*> ordered;
+
+public:
+    uint32_t add(const std::string& value) {
+        auto it = indices.find(value);
+        if (it != indices.end()) {
+            return it->second;
+        }
+        uint32_t index = static_cast<uint32_t>(ordered.size());
+        auto inserted = indices.emplace(value, index).first;
+        ordered.push_back(&inserted->first);
+        return index;
+    }
+
+    void writeTo(BinaryWriter& out) const {
+        out.write(static_cast<uint32_t>(ordered.size()));
+        for (const auto* value : ordered) {
+            out.write(static_cast<uint32_t>(value->size()));
+            out.writeBytes(value->data(), value->size());
+        }
+    }
+};
+
+class StringTableReader {
+private:
+    std::vector<std::string> strings;
+
+public:
+    bool read(BinaryReader& in) {
+        uint32_t count = 0;
+        if (!in.read(count)) return false;
+        strings.resize(count);
+        for (auto& value : strings) {
+            uint32_t length = 0;
+            if (!in.read(length) || !in.readString(value, length)) return false;
+        }
+        return true;
+    }
+
+    bool get(uint32_t index, std::string& out) const {
+        if (index == NO_STRING) {
+            out.clear();
+            return true;
+        }
+        if (index >= strings.size()) return false;
+        out = strings[index];
+        return true;
+    }
+};
+
+struct SectionView {
+    SnapshotSection type;
+    uint32_t count;
+    const char* payload;
+    size_t size;
+};
+
+// Непрерывный диапазон элементов коллекции - записи одного сегмента
+template <typename Ptr>
+struct Slice {
+    const Ptr* first;
+    size_t count;
+
+    const Ptr* begin() const { return first; }
+    const Ptr* end() const { return first + count; }
+};
+
+void writeSegment(BinaryWriter& out, const StringTable& strings, const BinaryWriter& records) {
+    strings.writeTo(out);
+    out.writeBytes(records.data().data(), records.size());
+}
+
+// Подпись сегмента - хеш версий его записей (FNV-1a)
+template <typename Ptr>
+uint64_t segmentSignature(const Slice<Ptr>& items) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const auto& item : items) {
+        hash = (hash ^ item->getVersion()) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Обновляет кэш секции: кодирует только сегменты с измененными записями.
+// Возвращает true, если содержимое секции изменилось с прошлого сохранения
+template <typename Ptr, typename Encode>
+bool updateSection(SnapshotCache& cache, SnapshotSection type, const std::vector<Ptr>& items, Encode encode) {
+    typedef typename Ptr::element_type Entity;
+    SnapshotCache::Section& section = cache.sections[static_cast<uint32_t>(type) - 1];
+    size_t segmentCount = (items.size() + Snapshot::SEGMENT_RECORDS - 1) / Snapshot::SEGMENT_RECORDS;
+
+    // Ни один объект класса не менялся и коллекция та же - не нужно даже проверять записи
+    uint64_t collectionVersion = Entity::collectionVersion();
+    if (section.valid && section.collectionVersion == collectionVersion &&
+        section.items == items.data() && section.count == items.size()) {
+        cache.reusedSegments += segmentCount;
+        return false;
+    }
+
+    bool changed = !section.valid || section.segments.size() != segmentCount;
+    section.segments.resize(segmentCount);
+    for (size_t i = 0; i < segmentCount; ++i) {
+        size_t first = i * Snapshot::SEGMENT_RECORDS;
+        Slice<Ptr> slice = { items.data() + first, std::min(Snapshot::SEGMENT_RECORDS, items.size() - first) };
+        SnapshotCache::Segment& segment = section.segments[i];
+
+        uint64_t signature = segmentSignature(slice);
+        if (!segment.bytes.empty() && segment.signature == signature && segment.count == slice.count) {
+            cache.reusedSegments++;
+            continue;
+        }
+
+        BinaryWriter writer;
+        encode(writer, slice);
+        segment.bytes = writer.data();
+        segment.signature = signature;
+        segment.count = static_cast<uint32_t>(slice.count);
+        cache.encodedSegments++;
+        changed = true;
+    }
+
+    section.valid = true;
+    section.collectionVersion = collectionVersion;
+    section.items = items.data();
+    section.count = items.size();
+    return changed;
+}
+
+void writeSection(BinaryWriter& out, SnapshotSection type, const SnapshotCache::Section& section) {
+    out.write(static_cast<uint32_t>(type));
+    out.write(static_cast<uint32_t>(section.count));
+    size_t sizeOffset = out.size();
+    out.write(static_cast<uint64_t>(0));
+
+    size_t start = out.size();
+    out.write(static_cast<uint32_t>(section.segments.size()));
+    for (const auto& segment : section.segments) {
+        out.write(segment.count);
+        out.write(static_cast<uint64_t>(segment.bytes.size()));
+        out.writeBytes(segment.bytes.data(), segment.bytes.size());
+    }
+    out.patch(sizeOffset, static_cast<uint64_t>(out.size() - start));
+}
+
+void encodeRooms(BinaryWriter& out, const Slice<std::shared_ptr<Room>>& rooms) {
+    StringTable strings;
+    BinaryWriter records;
+    for (const auto& room : rooms) {
+        records.write(strings.add(room->getId()));
+        records.write(strings.add(room->getName()));
+        records.write(room->getArea());
+    }
+    writeSegment(out, strings, records);
+}
+
+void encodeDevices(BinaryWriter& out, const Slice<std::shared_ptr<Device>>& devices) {
+    StringTable strings;
+    BinaryWriter records;
+    BinaryWriter extra;
+    for (const auto& device : devices) {
+        auto location = device->getLocation();
+        records.write(strings.add(device->getId()));
+        records.write(strings.add(device->getName()));
+        records.write(strings.add(device->getManufacturer()));
+        records.write(static_cast<int32_t>(device->getDeviceType()));
+        records.write(location ? strings.add(location->getId()) : NO_STRING);
+        records.write(static_cast<uint8_t>(device->getIsOn()));
+        records.write(static_cast<uint8_t>(device->getIsOnline()));
+        records.write(device->getPowerConsumption());
+
+        // Состояние подкласса с длиной, чтобы незнакомый тип можно было пропустить
+        extra.clear();
+        if (device->hasExtraState()) {
+            device->writeExtraState(extra);
+        }
+        records.write(static_cast<uint32_t>(extra.size()));
+        records.writeBytes(extra.data().data(), extra.size());
+    }
+    writeSegment(out, strings, records);
+}
+
+void encodeUsers(BinaryWriter& out, const Slice<std::shared_ptr<User>>& users) {
+    StringTable strings;
+    BinaryWriter records;
+    for (const auto& user : users) {
+        records.write(strings.add(user->getUserId()));
+        records.write(strings.add(user->getUsername()));
+        records.write(strings.add(user->getPasswordHash()));
+        records.write(static_cast<int32_t>(user->getAccessLevel()));
+        records.write(strings.add(user->getEmail()));
+        records.write(strings.add(user->getPhone()));
+    }
+    writeSegment(out, strings, records);
+}
+
+void encodeScenarios(BinaryWriter& out, const Slice<std::unique_ptr<AutomationScenario>>& scenarios) {
+    StringTable strings;
+    BinaryWriter records;
+    for (const auto& scenario : scenarios) {
+        records.write(strings.add(scenario->getScenarioId()));
+        records.write(strings.add(scenario->getName()));
+        records.write(strings.add(scenario->getTriggerTime()));
+        records.write(static_cast<uint8_t>(scenario->getIsActive()));
+        records.write(static_cast<int64_t>(scenario->getCreatedDate()));
+    }
+    writeSegment(out, strings, records);
+}
+
+void encodeNotifications(BinaryWriter& out, const Slice<std::unique_ptr<Notification>>& notifications) {
+    StringTable strings;
+    BinaryWriter records;
+    for (const auto& notification : notifications) {
+        auto device = notification->getRelatedDevice();
+        std::string scenarioId = notification->getRelatedScenarioId();
+        records.write(strings.add(notification->getNotificationId()));
+        records.write(static_cast<int32_t>(notification->getType()));
+        records.write(strings.add(notification->getMessage()));
+        records.write(device ? strings.add(device->getId()) : NO_STRING);
+        records.write(scenarioId.empty() ? NO_STRING : strings.add(scenarioId));
+        records.write(static_cast<int64_t>(notification->getTimestamp()));
+        records.write(static_cast<uint8_t>(notification->getIsRead()));
+    }
+    writeSegment(out, strings, records);
+}
+
+bool decodeRooms(const SectionView& section, SnapshotData& data, EntityRegistry& registry) {
+    BinaryReader in(section.payload, section.size);
+    StringTableReader strings;
+    if (!strings.read(in)) return false;
+
+    for (uint32_t i = 0; i < section.count; ++i) {
+        uint32_t idRef = 0, nameRef = 0;
+        double area = 0.0;
+        std::string id, name;
+        if (!in.read(idRef) || !in.read(nameRef) || !in.read(area)) return false;
+        if (!strings.get(idRef, id) || !strings.get(nameRef, name)) return false;
+        auto room = std::make_shared<Room>(id, name, area);
+        if (registry.addRoom(room)) {
+            data.rooms.push_back(room);
+        }
+    }
+    return true;
+}
+
+bool decodeDevices(const SectionView& section, uint16_t version, SnapshotData& data, EntityRegistry& registry) {
+    BinaryReader in(section.payload, section.size);
+    StringTableReader strings;
+    if (!strings.read(in)) return false;
+
+    for (uint32_t i = 0; i < section.count; ++i) {
+        uint32_t idRef = 0, nameRef = 0, manufacturerRef = 0, locationRef = 0;
+        int32_t type = 0;
+        uint8_t isOn = 0, isOnline = 0;
+        double power = 0.0;
+        if (!in.read(idRef) || !in.read(nameRef) || !in.read(manufacturerRef) || !in.read(type) ||
+            !in.read(locationRef) || !in.read(isOn) || !in.read(isOnline) || !in.read(power)) {
+            return false;
+        }
+
+        uint32_t extraSize = 0;
+        const char* extra = nullptr;
+        if (version >= 2) {
+            if (!in.read(extraSize) || extraSize > in.remaining()) return false;
+            extra = in.current();
+            in.skip(extraSize);
+        }
+
+        std::string id, name, manufacturer, locationId;
+        if (!strings.get(idRef, id) || !strings.get(nameRef, name) ||
+            !strings.get(manufacturerRef, manufacturer) || !strings.get(locationRef, locationId)) {
+            return false;
+        }
+
+        // Как и в текстовом формате, устройства без комнаты не загружаются
+        auto location = registry.findRoom(locationId);
+        if (!location) continue;
+
+        auto device = DeviceFactory::createBlank(static_cast<DeviceType>(type), id, name, manufacturer,
+            location, power);
+        device->restoreState(isOn != 0, isOnline != 0);
+        if (extraSize > 0 && device->hasExtraState()) {
+            BinaryReader extraIn(extra, extraSize);
+            if (!device->readExtraState(extraIn)) return false;
+        }
+
+        if (!registry.addDevice(device)) continue;
+        data.devices.push_back(device);
+        location->addDevice(device);
+    }
+    return true;
+}
+
+bool decodeUsers(const SectionView& section, SnapshotData& data, EntityRegistry& registry) {
+    BinaryReader in(section.payload, section.size);
+    StringTableReader strings;
+    if (!strings.read(in)) return false;
+
+    for (uint32_t i = 0; i < section.count; ++i) {
+        uint32_t idRef = 0, nameRef = 0, passwordRef = 0, emailRef = 0, phoneRef = 0;
+        int32_t level = 0;
+        if (!in.read(idRef) || !in.read(nameRef) || !in.read(passwordRef) || !in.read(level) ||
+            !in.read(emailRef) || !in.read(phoneRef)) {
+            return false;
+        }
+
+        std::string id, username, password, email, phone;
+        if (!strings.get(idRef, id) || !strings.get(nameRef, username) || !strings.get(passwordRef, password) ||
+            !strings.get(emailRef, email) || !strings.get(phoneRef, phone)) {
+            return false;
+        }
+        auto user = std::make_shared<User>(id, username, password, static_cast<AccessLevel>(level), email, phone);
+        if (registry.addUser(user)) {
+            data.users.push_back(user);
+        }
+    }
+    return true;
+}
+
+bool decodeScenarios(const SectionView& section, SnapshotData& data, EntityRegistry& registry) {
+    BinaryReader in(section.payload, section.size);
+    StringTableReader strings;
+    if (!strings.read(in)) return false;
+
+    for (uint32_t i = 0; i < section.count; ++i) {
+        uint32_t idRef = 0, nameRef = 0, timeRef = 0;
+        uint8_t isActive = 0;
+        int64_t createdDate = 0;
+        if (!in.read(idRef) || !in.read(nameRef) || !in.read(timeRef) ||
+            !in.read(isActive) || !in.read(createdDate)) {
+            return false;
+        }
+
+        std::string id, name, time;
+        if (!strings.get(idRef, id) || !strings.get(nameRef, name) || !strings.get(timeRef, time)) {
+            return false;
+        }
+        auto scenario = AutomationScenario::restore(id, name, time,
+            isActive != 0, static_cast<std::time_t>(createdDate));
+        if (registry.addScenario(scenario.get())) {
+            data.scenarios.push_back(std::move(scenario));
+        }
+    }
+    return true;
+}
+
+bool decodeNotifications(const SectionView& section, SnapshotData& data, EntityRegistry& registry) {
+    BinaryReader in(section.payload, section.size);
+    StringTableReader strings;
+    if (!strings.read(in)) return false;
+
+    for (uint32_t i = 0; i < section.count; ++i) {
+        uint32_t idRef = 0, messageRef = 0, deviceRef = 0, scenarioRef = 0;
+        int32_t type = 0;
+        int64_t timestamp = 0;
+        uint8_t isRead = 0;
+        if (!in.read(idRef) || !in.read(type) || !in.read(messageRef) || !in.read(deviceRef) ||
+            !in.read(scenarioRef) || !in.read(timestamp) || !in.read(isRead)) {
+            return false;
+        }
+
+        std::string id, message, deviceId, scenarioId;
+        if (!strings.get(idRef, id) || !strings.get(messageRef, message) ||
+            !strings.get(deviceRef, deviceId) || !strings.get(scenarioRef, scenarioId)) {
+            return false;
+        }
+
+        auto notification = Notification::restore(id, static_cast<NotificationType>(type),
+            message, static_cast<std::time_t>(timestamp), isRead != 0);
+        if (deviceRef != NO_STRING) {
+            notification->setRelatedDevice(registry.findDevice(deviceId));
+        }
+        if (scenarioRef != NO_STRING) {
+            notification->setRelatedScenario(registry.findScenario(scenarioId));
+        }
+        data.notifications.push_back(std::move(notification));
+    }
+    return true;
+}
+
+bool readFile(const std::string& path, std::vector<char>& buffer) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return false;
+
+    std::streamsize size = file.tellg();
+    if (size < 0) return false;
+    buffer.resize(static_cast<size_t>(size));
+    file.seekg(0);
+    return size == 0 || file.read(buffer.data(), size).good();
+}
+
+// Обновляет кэш сегментов; true, если хотя бы одна секция изменилась
+bool updateSections(SnapshotCache& cache,
+    const std::vector<std::shared_ptr<Room>>& rooms,
+    const std::vector<std::shared_ptr<Device>>& devices,
+    const std::vector<std::shared_ptr<User>>& users,
+    const std::vector<std::unique_ptr<AutomationScenario>>& scenarios,
+    const std::vector<std::unique_ptr<Notification>>& notifications) {
+    cache.encodedSegments = 0;
+    cache.reusedSegments = 0;
+    cache.writeSkipped = false;
+
+    bool changed = false;
+    changed |= updateSection(cache, SnapshotSection::ROOMS, rooms, encodeRooms);
+    changed |= updateSection(cache, SnapshotSection::DEVICES, devices, encodeDevices);
+    changed |= updateSection(cache, SnapshotSection::USERS, users, encodeUsers);
+    changed |= updateSection(cache, SnapshotSection::SCENARIOS, scenarios, encodeScenarios);
+    changed |= updateSection(cache, SnapshotSection::NOTIFICATIONS, notifications, encodeNotifications);
+    return changed;
+}
+
+// Сборка файла из закодированных сегментов
+void assembleImage(const SnapshotCache& cache, BinaryWriter& out) {
+    out.writeBytes(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    out.write(static_cast<uint16_t>(Snapshot::FORMAT_VERSION));
+    out.write(static_cast<uint16_t>(0));
+    out.write(static_cast<uint32_t>(5));
+
+    const SnapshotSection order[] = { SnapshotSection::ROOMS, SnapshotSection::DEVICES,
+        SnapshotSection::USERS, SnapshotSection::SCENARIOS, SnapshotSection::NOTIFICATIONS };
+    for (SnapshotSection type : order) {
+        writeSection(out, type, cache.sections[static_cast<uint32_t>(type) - 1]);
+    }
+}
+
+} // namespace
+
+bool Snapshot::save(const std::string& path,
+    const std::vector<std::shared_ptr<Room>>& rooms,
+    const std::vector<std::shared_ptr<Device>>& devices,
+    const std::vector<std::shared_ptr<User>>& users,
+    const std::vector<std::unique_ptr<AutomationScenario>>& scenarios,
+    const std::vector<std::unique_ptr<Notification>>& notifications,
+    SnapshotCache* cache) {
+    SnapshotCache local;
+    SnapshotCache& segments = cache ? *cache : local;
+    bool changed = updateSections(segments, rooms, devices, users, scenarios, notifications);
+
+    // Файл уже совпадает с текущим состоянием
+    if (!changed && segments.writtenPath == path && exists(path)) {
+        segments.writeSkipped = true;
+        return true;
+    }
+    segments.writtenPath.clear();
+
+    BinaryWriter out;
+    assembleImage(segments, out);
+    if (!writeImage(path, out.data())) {
+        return false;
+    }
+    segments.writtenPath = path;
+    return true;
+}
+
+bool Snapshot::encode(const std::vector<std::shared_ptr<Room>>& rooms,
+    const std::vector<std::shared_ptr<Device>>& devices,
+    const std::vector<std::shared_ptr<User>>& users,
+    const std::vector<std::unique_ptr<AutomationScenario>>& scenarios,
+    const std::vector<std::unique_ptr<Notification>>& notifications,
+    SnapshotCache& cache, std::vector<char>& image) {
+    // Файл пишет вызывающий код, поэтому путь прошлой записи здесь неизвестен
+    cache.writtenPath.clear();
+    if (!updateSections(cache, rooms, devices, users, scenarios, notifications)) {
+        cache.writeSkipped = true;
+        return false;
+    }
+
+    BinaryWriter out;
+    assembleImage(cache, out);
+    image = out.data();
+    return true;
+}
+
+bool Snapshot::writeImage(const std::string& path, const std::vector<char>& image) {
+    // Сначала пишем во временный файл, чтобы сбой записи не испортил предыдущий снимок
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Ошибка записи снимка: не удалось открыть " << tempPath << std::endl;
+            return false;
+        }
+        file.write(image.data(), static_cast<std::streamsize>(image.size()));
+        if (!file.good()) {
+            std::cerr << "Ошибка записи снимка: " << tempPath << std::endl;
+            return false;
+        }
+    }
+
+    // Прежний снимок не удаляется заранее: сбой до замены оставляет его целым
+    if (!replaceFile(tempPath, path)) {
+        std::cerr << "Ошибка записи снимка: не удалось переименовать " << tempPath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Snapshot::load(const std::string& path, SnapshotData& data, EntityRegistry& registry,
+    LoadTimings* timings) {
+    std::vector<char> buffer;
+    auto read = [&]() { return readFile(path, buffer); };
+    if (!(timings ? timings->measure("чтение снимка", read) : read())) {
+        std::cerr << "Ошибка чтения снимка: не удалось открыть " << path << std::endl;
+        return false;
+    }
+
+    BinaryReader in(buffer.data(), buffer.size());
+    char magic[4];
+    uint16_t version = 0, flags = 0;
+    uint32_t sectionCount = 0;
+    if (!in.readBytes(magic, sizeof(magic)) || !in.read(version) || !in.read(flags) || !in.read(sectionCount)) {
+        std::cerr << "Ошибка чтения снимка: повреждён заголовок" << std::endl;
+        return false;
+    }
+    if (std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0) {
+        std::cerr << "Ошибка чтения снимка: неизвестный формат файла" << std::endl;
+        return false;
+    }
+    if (version == 0 || version > FORMAT_VERSION) {
+        std::cerr << "Ошибка чтения снимка: версия " << version << " не поддерживается" << std::endl;
+        return false;
+    }
+
+    std::vector<SectionView> sections;
+    for (uint32_t i = 0; i < sectionCount; ++i) {
+        uint32_t type = 0, count = 0;
+        uint64_t size = 0;
+        if (!in.read(type) || !in.read(count) || !in.read(size) || size > in.remaining()) {
+            std::cerr << "Ошибка чтения снимка: повреждена секция " << i + 1 << std::endl;
+            return false;
+        }
+        SectionView whole = { static_cast<SnapshotSection>(type), count, in.current(), static_cast<size_t>(size) };
+        in.skip(static_cast<size_t>(size));
+        if (version < 3) {
+            sections.push_back(whole);
+            continue;
+        }
+
+        // Сегменты разбираются как отдельные секции того же типа, по порядку
+        BinaryReader segments(whole.payload, whole.size);
+        uint32_t segmentCount = 0;
+        if (!segments.read(segmentCount)) {
+            std::cerr << "Ошибка чтения снимка: повреждена секция " << i + 1 << std::endl;
+            return false;
+        }
+        for (uint32_t j = 0; j < segmentCount; ++j) {
+            uint32_t segmentRecords = 0;
+            uint64_t segmentSize = 0;
+            if (!segments.read(segmentRecords) || !segments.read(segmentSize) || segmentSize > segments.remaining()) {
+                std::cerr << "Ошибка чтения снимка: повреждена секция " << i + 1 << std::endl;
+                return false;
+            }
+            sections.push_back({ whole.type, segmentRecords, segments.current(), static_cast<size_t>(segmentSize) });
+            segments.skip(static_cast<size_t>(segmentSize));
+        }
+    }
+
+    auto decodeAll = [&](SnapshotSection type, const char* stage) {
+        auto run = [&]() {
+            for (const auto& section : sections) {
+                if (section.type != type) continue;
+
+                bool ok = false;
+                switch (type) {
+                case SnapshotSection::ROOMS: ok = decodeRooms(section, data, registry); break;
+                case SnapshotSection::DEVICES: ok = decodeDevices(section, version, data, registry); break;
+                case SnapshotSection::USERS: ok = decodeUsers(section, data, registry); break;
+                case SnapshotSection::SCENARIOS: ok = decodeScenarios(section, data, registry); break;
+                case SnapshotSection::NOTIFICATIONS: ok = decodeNotifications(section, data, registry); break;
+                }
+                if (!ok) {
+                    std::cerr << "Ошибка чтения снимка: повреждены данные секции "
+                        << static_cast<uint32_t>(type) << std::endl;
+                    return false;
+                }
+            }
+            return true;
+        };
+        return timings ? timings->measure(stage, run) : run();
+    };
+
+    // Устройствам нужны комнаты, уведомлениям - устройства и сценарии.
+    // Пользователи и сценарии ни от чего не зависят и разбираются в отдельных потоках.
+    // Каждая секция пишет только в свой вектор SnapshotData и свою таблицу реестра
+    auto users = std::async(std::launch::async, decodeAll, SnapshotSection::USERS, "пользователи");
+    auto scenarios = std::async(std::launch::async, decodeAll, SnapshotSection::SCENARIOS, "сценарии");
+
+    bool ok = decodeAll(SnapshotSection::ROOMS, "комнаты");
+    ok = ok && decodeAll(SnapshotSection::DEVICES, "устройства");
+    // Оба потока нужно дождаться в любом случае: они пишут в data и registry
+    bool usersOk = users.get();
+    bool scenariosOk = scenarios.get();
+    ok = ok && usersOk && scenariosOk;
+    return ok && decodeAll(SnapshotSection::NOTIFICATIONS, "уведомления");
+}
+
+void SnapshotCache::clear() {
+    for (auto& section : sections) {
+        section = Section();
+    }
+    writtenPath.clear();
+    encodedSegments = 0;
+    reusedSegments = 0;
+    writeSkipped = false;
+}
+
+bool Snapshot::exists(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return file.is_open();
+}
+
+void Snapshot::encodeNotificationSegment(const std::vector<std::unique_ptr<Notification>>& notifications,
+    size_t first, size_t count, std::vector<char>& bytes) {
+    BinaryWriter out;
+    Slice<std::unique_ptr<Notification>> slice = { notifications.data() + first, count };
+    encodeNotifications(out, slice);
+    bytes = out.data();
+}
+
+bool Snapshot::decodeNotificationSegment(const char* bytes, size_t size, uint32_t count,
+    EntityRegistry& registry, std::vector<std::unique_ptr<Notification>>& out) {
+    SectionView section = { SnapshotSection::NOTIFICATIONS, count, bytes, size };
+    SnapshotData data;
+    if (!decodeNotifications(section, data, registry)) {
+        return false;
+    }
+    for (auto& notification : data.notifications) {
+        out.push_back(std::move(notification));
+    }
+    return true;
+}
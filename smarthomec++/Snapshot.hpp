@@ -0,0 +1,115 @@
+﻿#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+class Room;
+class Device;
+class User;
+class AutomationScenario;
+class Notification;
+class EntityRegistry;
+class LoadTimings;
+
+// Типы секций бинарного снимка
+enum class SnapshotSection : uint32_t {
+    ROOMS = 1,
+    DEVICES = 2,
+    USERS = 3,
+    SCENARIOS = 4,
+    NOTIFICATIONS = 5
+};
+
+// Данные, восстановленные из снимка
+struct SnapshotData {
+    std::vector<std::shared_ptr<Room>> rooms;
+    std::vector<std::shared_ptr<Device>> devices;
+    std::vector<std::shared_ptr<User>> users;
+    std::vector<std::unique_ptr<AutomationScenario>> scenarios;
+    std::vector<std::unique_ptr<Notification>> notifications;
+};
+
+// Закодированные сегменты прошлого сохранения (см. Snapshot::save).
+// Сегмент кодируется заново, только если изменилась версия хотя бы одной его записи;
+// если не изменилось ничего и файл уже записан, сохранение не пишет на диск
+struct SnapshotCache {
+    struct Segment {
+        uint64_t signature = 0;
+        uint32_t count = 0;
+        std::vector<char> bytes;
+    };
+
+    struct Section {
+        bool valid = false;
+        uint64_t collectionVersion = 0;
+        const void* items = nullptr;
+        size_t count = 0;
+        std::vector<Segment> segments;
+    };
+
+    Section sections[5];
+    std::string writtenPath;
+
+    // Статистика последнего сохранения
+    size_t encodedSegments = 0;
+    size_t reusedSegments = 0;
+    bool writeSkipped = false;
+
+    void clear();
+};
+
+// Бинарный снимок состояния умного дома.
+//
+// Формат файла:
+//   заголовок: "SHSN", uint16 версия, uint16 флаги, uint32 число секций
+//   секция:    uint32 тип, uint32 число записей, uint64 размер данных, данные
+//   данные:    uint32 число сегментов, затем сегменты (с версии 3)
+//   сегмент:   uint32 число записей, uint64 размер, таблица строк (uint32 число строк,
+//              затем uint32 длина + байты), за ней записи; строки хранятся как индекс в таблице
+//
+// Каждый сегмент самодостаточен (своя таблица строк), поэтому неизвестные секции
+// можно пропустить, а неизмененные сегменты - переписать из кэша без кодирования.
+// В версиях 1-2 данные секции - один сегмент без заголовка.
+class Snapshot {
+public:
+    static const uint32_t FORMAT_VERSION;
+    // Записей в одном сегменте секции
+    static const size_t SEGMENT_RECORDS = 4096;
+
+    static bool save(const std::string& path,
+        const std::vector<std::shared_ptr<Room>>& rooms,
+        const std::vector<std::shared_ptr<Device>>& devices,
+        const std::vector<std::shared_ptr<User>>& users,
+        const std::vector<std::unique_ptr<AutomationScenario>>& scenarios,
+        const std::vector<std::unique_ptr<Notification>>& notifications,
+        SnapshotCache* cache = nullptr);
+
+    // Образ файла снимка для записи в другом потоке (см. PersistenceWorker).
+    // false - с прошлого вызова с этим cache ничего не изменилось, image не заполняется
+    static bool encode(const std::vector<std::shared_ptr<Room>>& rooms,
+        const std::vector<std::shared_ptr<Device>>& devices,
+        const std::vector<std::shared_ptr<User>>& users,
+        const std::vector<std::unique_ptr<AutomationScenario>>& scenarios,
+        const std::vector<std::unique_ptr<Notification>>& notifications,
+        SnapshotCache& cache, std::vector<char>& image);
+
+    // Запись готового образа: сначала во временный файл, затем переименование
+    static bool writeImage(const std::string& path, const std::vector<char>& image);
+
+    // Загруженные сущности регистрируются в registry, через него же восстанавливаются связи
+    // Независимые секции разбираются параллельно; timings (если задан) получает время секций
+    static bool load(const std::string& path, SnapshotData& data, EntityRegistry& registry,
+        LoadTimings* timings = nullptr);
+    static bool exists(const std::string& path);
+
+    // Сегмент уведомлений в формате снимка (таблица строк и записи); используется архивом
+    static void encodeNotificationSegment(const std::vector<std::unique_ptr<Notification>>& notifications,
+        size_t first, size_t count, std::vector<char>& bytes);
+    static bool decodeNotificationSegment(const char* bytes, size_t size, uint32_t count,
+        EntityRegistry& registry, std::vector<std::unique_ptr<Notification>>& out);
+};
+
+#endif
@@ -0,0 +1,191 @@
+﻿#include "TelemetryPipeline.hpp"
+#include "Device.hpp"
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+namespace {
+
+// Номер потока-производителя: определяет его очередь в любом конвейере
+std::atomic<size_t> producerCounter(0);
+
+size_t producerIndex() {
+    thread_local size_t index = producerCounter++;
+    return index;
+}
+
+size_t roundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+} // namespace
+
+TelemetryStats::TelemetryStats()
+    : accepted(0), rejected(0), applied(0), clamped(0), invalid(0), stale(0), batches(0) {}
+
+const size_t TelemetryRing::CACHE_LINE;
+
+TelemetryRing::TelemetryRing(size_t capacity)
+    : tail(0), head(0), accepted(0), rejected(0) {
+    size_t size = roundUpToPowerOfTwo(std::max<size_t>(capacity, 2));
+    cells.reset(new Cell[size]);
+    mask = size - 1;
+    for (size_t i = 0; i < size; i++) {
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool TelemetryRing::push(const TelemetrySample& sample) noexcept {
+    size_t position = tail.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell& cell = cells[position & mask];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+        if (difference == 0) {
+            if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                cell.sample = sample;
+                cell.sequence.store(position + 1, std::memory_order_release);
+                accepted.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        else if (difference < 0) {
+            // Ячейку еще не освободил потребитель - очередь заполнена
+            rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else {
+            position = tail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+size_t TelemetryRing::pop(TelemetrySample* out, size_t maxCount) noexcept {
+    size_t count = 0;
+    while (count < maxCount) {
+        Cell& cell = cells[head & mask];
+        if (cell.sequence.load(std::memory_order_acquire) != head + 1) break;
+        out[count++] = cell.sample;
+        // Ячейка снова свободна для записи на следующем круге
+        cell.sequence.store(head + mask + 1, std::memory_order_release);
+        head++;
+    }
+    return count;
+}
+
+size_t TelemetryRing::capacity() const {
+    return mask + 1;
+}
+
+uint64_t TelemetryRing::acceptedCount() const {
+    return accepted.load(std::memory_order_relaxed);
+}
+
+uint64_t TelemetryRing::rejectedCount() const {
+    return rejected.load(std::memory_order_relaxed);
+}
+
+const size_t TelemetryPipeline::DEFAULT_RING_CAPACITY;
+const size_t TelemetryPipeline::BATCH_SIZE;
+
+TelemetryPipeline::TelemetryPipeline(size_t ringCount, size_t ringCapacity)
+    : batch(BATCH_SIZE), applied(0), clamped(0), invalid(0), stale(0), batches(0) {
+    if (ringCount == 0) {
+        ringCount = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    for (size_t i = 0; i < ringCount; i++) {
+        rings.emplace_back(new TelemetryRing(ringCapacity));
+    }
+    budget.resize(ringCount);
+}
+
+bool TelemetryPipeline::submit(Handle<Device> device, double value, int64_t timestamp) noexcept {
+    TelemetrySample sample;
+    sample.device = device;
+    sample.value = value;
+    sample.timestamp = timestamp;
+    return submit(sample);
+}
+
+bool TelemetryPipeline::submit(const TelemetrySample& sample) noexcept {
+    return rings[producerIndex() % rings.size()]->push(sample);
+}
+
+size_t TelemetryPipeline::drain(size_t maxSamples) noexcept {
+    // Очереди обходятся по кругу пакетами, чтобы один активный производитель не
+    // задерживал остальных; из каждой за вызов берется не больше ее емкости,
+    // иначе при непрерывном потоке drain() не вернулся бы
+    for (size_t i = 0; i < rings.size(); i++) {
+        budget[i] = rings[i]->capacity();
+    }
+
+    size_t total = 0;
+    bool progress = true;
+    while (progress && total < maxSamples) {
+        progress = false;
+        for (size_t i = 0; i < rings.size() && total < maxSamples; i++) {
+            size_t limit = std::min(std::min(BATCH_SIZE, budget[i]), maxSamples - total);
+            size_t count = rings[i]->pop(batch.data(), limit);
+            if (count == 0) continue;
+            apply(batch.data(), count);
+            budget[i] -= count;
+            total += count;
+            progress = true;
+        }
+    }
+    return total;
+}
+
+void TelemetryPipeline::apply(const TelemetrySample* samples, size_t count) noexcept {
+    uint64_t appliedCount = 0;
+    uint64_t clampedCount = 0;
+    uint64_t invalidCount = 0;
+    uint64_t staleCount = 0;
+    for (size_t i = 0; i < count; i++) {
+        Device* device = Device::find(samples[i].device);
+        if (!device) {
+            staleCount++;
+            continue;
+        }
+        switch (device->applyReading(samples[i].value)) {
+        case ReadingStatus::OK:
+            appliedCount++;
+            break;
+        case ReadingStatus::INVALID:
+            invalidCount++;
+            break;
+        default:
+            appliedCount++;
+            clampedCount++;
+            break;
+        }
+    }
+    applied.fetch_add(appliedCount, std::memory_order_relaxed);
+    clamped.fetch_add(clampedCount, std::memory_order_relaxed);
+    invalid.fetch_add(invalidCount, std::memory_order_relaxed);
+    stale.fetch_add(staleCount, std::memory_order_relaxed);
+    batches.fetch_add(1, std::memory_order_relaxed);
+}
+
+TelemetryStats TelemetryPipeline::stats() const {
+    TelemetryStats result;
+    for (const auto& ring : rings) {
+        result.accepted += ring->acceptedCount();
+        result.rejected += ring->rejectedCount();
+    }
+    result.applied = applied.load(std::memory_order_relaxed);
+    result.clamped = clamped.load(std::memory_order_relaxed);
+    result.invalid = invalid.load(std::memory_order_relaxed);
+    result.stale = stale.load(std::memory_order_relaxed);
+    result.batches = batches.load(std::memory_order_relaxed);
+    return result;
+}
+
+int64_t TelemetryPipeline::now() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,115 @@
+﻿#ifndef TELEMETRYPIPELINE_HPP
+#define TELEMETRYPIPELINE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "SlotMap.hpp"
+
+class Device;
+
+// Показание мощности устройства
+struct TelemetrySample {
+    Handle<Device> device;
+    double value;           // Вт
+    int64_t timestamp;      // мкс, время источника
+};
+
+struct TelemetryStats {
+    uint64_t accepted;      // помещено в очереди
+    uint64_t rejected;      // отклонено: очередь заполнена
+    uint64_t applied;       // применено к устройствам (включая приведенные)
+    uint64_t clamped;       // приведено к диапазону 0..Device::MAX_POWER
+    uint64_t invalid;       // NaN или бесконечность
+    uint64_t stale;         // устройство уже удалено
+    uint64_t batches;
+
+    TelemetryStats();
+};
+
+// Ограниченная очередь показаний: много производителей, один потребитель.
+//
+// Без блокировок: производитель занимает ячейку сдвигом tail (CAS) и публикует ее
+// номером последовательности, потребитель читает ячейки по порядку. Заполненная
+// очередь не ждет и не растет - push возвращает false, отказ учитывается
+class TelemetryRing {
+public:
+    static const size_t CACHE_LINE = 64;
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        TelemetrySample sample;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(CACHE_LINE) std::atomic<size_t> tail;
+    alignas(CACHE_LINE) size_t head;          // только поток потребителя
+    alignas(CACHE_LINE) std::atomic<uint64_t> accepted;
+    std::atomic<uint64_t> rejected;
+
+public:
+    // Емкость округляется вверх до степени двойки
+    explicit TelemetryRing(size_t capacity);
+
+    TelemetryRing(const TelemetryRing&) = delete;
+    TelemetryRing& operator=(const TelemetryRing&) = delete;
+
+    bool push(const TelemetrySample& sample) noexcept;
+    // Забирает до maxCount показаний в порядке push; только поток потребителя
+    size_t pop(TelemetrySample* out, size_t maxCount) noexcept;
+
+    size_t capacity() const;
+    uint64_t acceptedCount() const;
+    uint64_t rejectedCount() const;
+};
+
+// Прием показаний от датчиков из любых потоков и пакетное применение.
+//
+// Каждый поток-производитель закреплен за одной из очередей, поэтому показания
+// одного источника применяются в порядке отправки. drain() вызывает поток,
+// который владеет устройствами (основной цикл меню): значения проверяются и
+// приводятся к диапазону без исключений, удаленные устройства пропускаются по
+// поколению дескриптора
+class TelemetryPipeline {
+private:
+    std::vector<std::unique_ptr<TelemetryRing>> rings;
+    std::vector<TelemetrySample> batch;
+    std::vector<size_t> budget;     // остаток показаний очереди на текущий drain()
+
+    std::atomic<uint64_t> applied;
+    std::atomic<uint64_t> clamped;
+    std::atomic<uint64_t> invalid;
+    std::atomic<uint64_t> stale;
+    std::atomic<uint64_t> batches;
+
+    void apply(const TelemetrySample* samples, size_t count) noexcept;
+
+public:
+    static const size_t DEFAULT_RING_CAPACITY = 1 << 16;
+    static const size_t BATCH_SIZE = 1024;
+
+    // ringCount 0 - по числу аппаратных потоков
+    explicit TelemetryPipeline(size_t ringCount = 0, size_t ringCapacity = DEFAULT_RING_CAPACITY);
+
+    TelemetryPipeline(const TelemetryPipeline&) = delete;
+    TelemetryPipeline& operator=(const TelemetryPipeline&) = delete;
+
+    // Из любого потока; false - очередь заполнена, показание отброшено
+    bool submit(Handle<Device> device, double value, int64_t timestamp) noexcept;
+    bool submit(const TelemetrySample& sample) noexcept;
+
+    // Применяет до maxSamples накопленных показаний пакетами по BATCH_SIZE, не больше
+    // емкости каждой очереди за вызов; возвращает число обработанных показаний
+    size_t drain(size_t maxSamples = static_cast<size_t>(-1)) noexcept;
+
+    TelemetryStats stats() const;
+
+    // Текущее время в микросекундах для timestamp
+    static int64_t now();
+};
+
+#endif
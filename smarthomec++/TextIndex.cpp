@@ -0,0 +1,267 @@
+﻿#include "TextIndex.hpp"
+#include <algorithm>
+
+namespace {
+    const uint32_t ROOT = 0;
+    const size_t MAX_GRAM = 3;
+
+    // Верхняя половина CP1251, 0x80-0xBF; 0xC0-0xFF - А-я подряд
+    const char16_t CP1251_HIGH[64] = {
+        0x0402, 0x0403, 0x201A, 0x0453, 0x201E, 0x2026, 0x2020, 0x2021,
+        0x20AC, 0x2030, 0x0409, 0x2039, 0x040A, 0x040C, 0x040B, 0x040F,
+        0x0452, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+        0xFFFD, 0x2122, 0x0459, 0x203A, 0x045A, 0x045C, 0x045B, 0x045F,
+        0x00A0, 0x040E, 0x045E, 0x0408, 0x00A4, 0x0490, 0x00A6, 0x00A7,
+        0x0401, 0x00A9, 0x0404, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x0407,
+        0x00B0, 0x00B1, 0x0406, 0x0456, 0x0491, 0x00B5, 0x00B6, 0x00B7,
+        0x0451, 0x2116, 0x0454, 0x00BB, 0x0458, 0x0405, 0x0455, 0x0457
+    };
+
+    char32_t foldSymbol(char32_t symbol) {
+        if (symbol >= U'A' && symbol <= U'Z') return symbol + 0x20;
+        if (symbol >= 0x0410 && symbol <= 0x042F) symbol += 0x20;         // А-Я
+        else if (symbol >= 0x0400 && symbol <= 0x040F) symbol += 0x50;    // Ѐ-Џ, в т.ч. Ё
+        else if (symbol == 0x0490) symbol = 0x0491;                        // Ґ
+        if (symbol == 0x0451) symbol = 0x0435;                             // ё -> е
+        return symbol;
+    }
+}
+
+TextIndex::TextIndex() : nodes(1) {
+}
+
+bool TextIndex::isUtf8(std::string_view text) {
+    size_t i = 0;
+    while (i < text.size()) {
+        unsigned char lead = static_cast<unsigned char>(text[i]);
+        size_t length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : (lead >> 3) == 0x1E ? 4 : 0;
+        if (length == 0 || i + length > text.size()) return false;
+        for (size_t j = 1; j < length; j++) {
+            if ((static_cast<unsigned char>(text[i + j]) & 0xC0) != 0x80) return false;
+        }
+        i += length;
+    }
+    return true;
+}
+
+std::u32string TextIndex::fold(std::string_view text) {
+    std::u32string result;
+    result.reserve(text.size());
+    if (isUtf8(text)) {
+        size_t i = 0;
+        while (i < text.size()) {
+            unsigned char lead = static_cast<unsigned char>(text[i]);
+            size_t length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : 4;
+            char32_t symbol = length == 1 ? lead : lead & (0x7F >> length);
+            for (size_t j = 1; j < length; j++) {
+                symbol = (symbol << 6) | (static_cast<unsigned char>(text[i + j]) & 0x3F);
+            }
+            result.push_back(foldSymbol(symbol));
+            i += length;
+        }
+        return result;
+    }
+    for (char ch : text) {
+        unsigned char byte = static_cast<unsigned char>(ch);
+        char32_t symbol = byte < 0x80 ? byte : byte >= 0xC0 ? 0x0410 + (byte - 0xC0) : CP1251_HIGH[byte - 0x80];
+        result.push_back(foldSymbol(symbol));
+    }
+    return result;
+}
+
+uint64_t TextIndex::gramKey(const char32_t* text, size_t length) {
+    // До трех символов по 21 биту; символ 0 в текстах не встречается,
+    // поэтому n-граммы разной длины не совпадают
+    uint64_t key = 0;
+    for (size_t i = 0; i < length; i++) {
+        key = (key << 21) | static_cast<uint64_t>(text[i] & 0x1FFFFF);
+    }
+    return key;
+}
+
+void TextIndex::collectGrams(const std::u32string& text, std::vector<uint64_t>& out) {
+    out.clear();
+    for (size_t length = 1; length <= MAX_GRAM; length++) {
+        for (size_t i = 0; i + length <= text.size(); i++) {
+            out.push_back(gramKey(text.data() + i, length));
+        }
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+uint32_t TextIndex::child(uint32_t node, char32_t symbol) const {
+    const auto& children = nodes[node].children;
+    auto it = std::lower_bound(children.begin(), children.end(), std::make_pair(symbol, uint32_t(0)));
+    return it != children.end() && it->first == symbol ? it->second : ROOT;
+}
+
+void TextIndex::link(uint32_t entry) {
+    const std::u32string& text = entries[entry].folded;
+    uint32_t node = ROOT;
+    nodes[node].subtreeCount++;
+    for (char32_t symbol : text) {
+        uint32_t next = child(node, symbol);
+        if (next == ROOT) {
+            next = static_cast<uint32_t>(nodes.size());
+            nodes.emplace_back();
+            auto& children = nodes[node].children;
+            children.insert(std::lower_bound(children.begin(), children.end(), std::make_pair(symbol, uint32_t(0))),
+                std::make_pair(symbol, next));
+        }
+        node = next;
+        nodes[node].subtreeCount++;
+    }
+    nodes[node].entries.push_back(entry);
+
+    std::vector<uint64_t> keys;
+    collectGrams(text, keys);
+    for (uint64_t key : keys) {
+        auto& posting = grams[key];
+        posting.insert(std::lower_bound(posting.begin(), posting.end(), entry), entry);
+    }
+}
+
+void TextIndex::unlink(uint32_t entry) {
+    // Узлы дерева не удаляются: опустевшая ветвь пропускается по subtreeCount
+    // и снова используется при вставке того же начала
+    const std::u32string& text = entries[entry].folded;
+    uint32_t node = ROOT;
+    nodes[node].subtreeCount--;
+    for (char32_t symbol : text) {
+        node = child(node, symbol);
+        nodes[node].subtreeCount--;
+    }
+    auto& list = nodes[node].entries;
+    list.erase(std::find(list.begin(), list.end(), entry));
+
+    std::vector<uint64_t> keys;
+    collectGrams(text, keys);
+    for (uint64_t key : keys) {
+        auto it = grams.find(key);
+        auto& posting = it->second;
+        posting.erase(std::lower_bound(posting.begin(), posting.end(), entry));
+        if (posting.empty()) {
+            grams.erase(it);
+        }
+    }
+}
+
+void TextIndex::insert(const std::string& key, const std::string& text) {
+    auto it = byKey.find(key);
+    uint32_t entry;
+    if (it != byKey.end()) {
+        entry = it->second;
+        unlink(entry);
+    }
+    else if (!freeEntries.empty()) {
+        entry = freeEntries.back();
+        freeEntries.pop_back();
+        byKey[key] = entry;
+    }
+    else {
+        entry = static_cast<uint32_t>(entries.size());
+        entries.emplace_back();
+        byKey[key] = entry;
+    }
+    entries[entry].key = key;
+    entries[entry].folded = fold(text);
+    link(entry);
+}
+
+void TextIndex::erase(const std::string& key) {
+    auto it = byKey.find(key);
+    if (it == byKey.end()) return;
+    uint32_t entry = it->second;
+    unlink(entry);
+    entries[entry].key.clear();
+    entries[entry].folded.clear();
+    freeEntries.push_back(entry);
+    byKey.erase(it);
+}
+
+void TextIndex::clear() {
+    nodes.assign(1, Node());
+    entries.clear();
+    freeEntries.clear();
+    byKey.clear();
+    grams.clear();
+}
+
+void TextIndex::collectSubtree(uint32_t node, std::vector<uint32_t>& out) const {
+    // Обход без рекурсии: глубина дерева равна длине самого длинного текста
+    std::vector<uint32_t> pending(1, node);
+    while (!pending.empty()) {
+        uint32_t current = pending.back();
+        pending.pop_back();
+        out.insert(out.end(), nodes[current].entries.begin(), nodes[current].entries.end());
+        for (const auto& link : nodes[current].children) {
+            if (nodes[link.second].subtreeCount > 0) {
+                pending.push_back(link.second);
+            }
+        }
+    }
+}
+
+std::vector<std::string> TextIndex::keysOf(std::vector<uint32_t>& found) const {
+    std::vector<std::string> keys;
+    keys.reserve(found.size());
+    for (uint32_t entry : found) {
+        keys.push_back(entries[entry].key);
+    }
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+std::vector<std::string> TextIndex::find(const std::string& query, TextMatch mode) const {
+    return mode == TextMatch::PREFIX ? findPrefix(query) : findSubstring(query);
+}
+
+std::vector<std::string> TextIndex::findPrefix(const std::string& prefix) const {
+    uint32_t node = ROOT;
+    for (char32_t symbol : fold(prefix)) {
+        node = child(node, symbol);
+        if (node == ROOT) return {};
+    }
+    std::vector<uint32_t> found;
+    if (nodes[node].subtreeCount > 0) {
+        found.reserve(nodes[node].subtreeCount);
+        collectSubtree(node, found);
+    }
+    return keysOf(found);
+}
+
+std::vector<std::string> TextIndex::findSubstring(const std::string& fragment) const {
+    std::u32string folded = fold(fragment);
+    if (folded.empty()) {
+        return findPrefix(fragment);
+    }
+
+    // Самый короткий список среди n-грамм запроса максимальной длины
+    size_t length = std::min(folded.size(), MAX_GRAM);
+    const std::vector<uint32_t>* shortest = nullptr;
+    for (size_t i = 0; i + length <= folded.size(); i++) {
+        auto it = grams.find(gramKey(folded.data() + i, length));
+        if (it == grams.end()) return {};
+        if (!shortest || it->second.size() < shortest->size()) {
+            shortest = &it->second;
+        }
+    }
+
+    std::vector<uint32_t> found;
+    if (folded.size() <= MAX_GRAM) {
+        found = *shortest;
+    }
+    else {
+        for (uint32_t entry : *shortest) {
+            if (entries[entry].folded.find(folded) != std::u32string::npos) {
+                found.push_back(entry);
+            }
+        }
+    }
+    return keysOf(found);
+}
+
+size_t TextIndex::size() const {
+    return byKey.size();
+}
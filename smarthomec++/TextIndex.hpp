@@ -0,0 +1,79 @@
+﻿#ifndef TEXTINDEX_HPP
+#define TEXTINDEX_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+// Режим текстового поиска
+enum class TextMatch {
+    PREFIX,         // текст начинается с запроса
+    SUBSTRING       // запрос встречается в тексте
+};
+
+// Индекс строк для поиска по началу и по подстроке без учета регистра.
+//
+// Тексты приводятся к общему виду функцией fold: строка разбирается как UTF-8,
+// если это корректный UTF-8, иначе как CP1251 (данные и консоль программы), затем
+// латиница и кириллица переводятся в нижний регистр, а "ё" считается "е".
+//
+// Поиск по началу - префиксное дерево по кодовым точкам: спуск по запросу и
+// обход поддерева, в каждом узле хранится число записей в поддереве, чтобы
+// пропускать опустевшие ветви. Поиск по подстроке - списки записей по n-граммам
+// (1-3 символа): берется самый короткий список среди n-грамм запроса, кандидаты
+// проверяются по сохраненному тексту. Списки отсортированы по номеру записи.
+//
+// Каждой записи соответствует ключ (ID сущности); результаты - ключи по
+// возрастанию. Индекс не потокобезопасен
+class TextIndex {
+private:
+    struct Node {
+        std::vector<std::pair<char32_t, uint32_t>> children;   // по символу
+        std::vector<uint32_t> entries;      // записи, текст которых кончается здесь
+        size_t subtreeCount;
+
+        Node() : subtreeCount(0) {}
+    };
+
+    struct Entry {
+        std::string key;
+        std::u32string folded;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Entry> entries;
+    std::vector<uint32_t> freeEntries;
+    std::unordered_map<std::string, uint32_t> byKey;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> grams;
+
+    static uint64_t gramKey(const char32_t* text, size_t length);
+    static void collectGrams(const std::u32string& text, std::vector<uint64_t>& out);
+
+    uint32_t child(uint32_t node, char32_t symbol) const;
+    void link(uint32_t entry);
+    void unlink(uint32_t entry);
+    void collectSubtree(uint32_t node, std::vector<uint32_t>& out) const;
+    std::vector<std::string> keysOf(std::vector<uint32_t>& found) const;
+
+public:
+    TextIndex();
+
+    // Добавляет или заменяет текст записи key
+    void insert(const std::string& key, const std::string& text);
+    void erase(const std::string& key);
+    void clear();
+
+    std::vector<std::string> find(const std::string& query, TextMatch mode) const;
+    std::vector<std::string> findPrefix(const std::string& prefix) const;
+    std::vector<std::string> findSubstring(const std::string& fragment) const;
+
+    size_t size() const;
+
+    // Приведение текста к виду для сравнения (см. описание класса)
+    static std::u32string fold(std::string_view text);
+    static bool isUtf8(std::string_view text);
+};
+
+#endif
@@ -0,0 +1,28 @@
+﻿#include "TextLoader.hpp"
+#include <algorithm>
+
+size_t TextLoader::workerCount(size_t bytes) {
+    size_t cores = std::max<size_t>(1, std::thread::hardware_concurrency());
+    size_t bySize = std::max<size_t>(1, bytes / MIN_CHUNK_BYTES);
+    return std::min(cores, bySize);
+}
+
+std::vector<std::string_view> TextLoader::splitChunks(const char* data, size_t size, size_t parts) {
+    std::vector<std::string_view> chunks;
+    if (!data || size == 0) {
+        return chunks;
+    }
+
+    size_t target = std::max<size_t>(1, size / std::max<size_t>(1, parts));
+    size_t start = 0;
+    while (start < size) {
+        size_t end = (chunks.size() + 1 >= parts) ? size : std::min(size, start + target);
+        // Граница сдвигается до конца строки, чтобы строка не попала в две части
+        while (end < size && data[end - 1] != '\n') {
+            end++;
+        }
+        chunks.emplace_back(data + start, end - start);
+        start = end;
+    }
+    return chunks;
+}
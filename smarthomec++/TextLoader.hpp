@@ -0,0 +1,90 @@
+﻿#ifndef TEXTLOADER_HPP
+#define TEXTLOADER_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <thread>
+#include <utility>
+#include "MappedFile.hpp"
+
+// Параллельная загрузка текстовых .dat файлов.
+//
+// Файл отображается в память и делится на части по границам строк; каждая часть
+// разбирается в своем потоке в отдельный вектор. Затем векторы объединяются
+// в порядке частей, поэтому порядок записей совпадает с порядком строк в файле.
+//
+// Функция разбора вызывается одновременно из нескольких потоков и не должна
+// изменять общие данные: привязка к комнатам и регистрация в реестре
+// выполняются вызывающим кодом после объединения
+class TextLoader {
+public:
+    // Меньшие файлы разбираются в текущем потоке
+    static const size_t MIN_CHUNK_BYTES = 256 * 1024;
+
+    static size_t workerCount(size_t bytes);
+    static std::vector<std::string_view> splitChunks(const char* data, size_t size, size_t parts);
+
+    // parse: (const std::string& line) -> T; пустой результат (nullptr) пропускается.
+    // false, если файл не удалось открыть
+    template <typename T, typename Parse>
+    static bool load(const std::string& path, std::vector<T>& out, const Parse& parse) {
+        MappedFile file;
+        if (!file.open(path)) {
+            return false;
+        }
+
+        std::vector<std::string_view> chunks = splitChunks(file.data(), file.size(), workerCount(file.size()));
+        std::vector<std::vector<T>> parts(chunks.size());
+
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < chunks.size(); ++i) {
+            workers.emplace_back([&, i]() { parseChunk(chunks[i], parts[i], parse); });
+        }
+        if (!chunks.empty()) {
+            parseChunk(chunks[0], parts[0], parse);
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        size_t total = out.size();
+        for (const auto& part : parts) {
+            total += part.size();
+        }
+        out.reserve(total);
+        for (auto& part : parts) {
+            for (auto& item : part) {
+                out.push_back(std::move(item));
+            }
+        }
+        return true;
+    }
+
+private:
+    template <typename T, typename Parse>
+    static void parseChunk(std::string_view chunk, std::vector<T>& out, const Parse& parse) {
+        // Буфер строки переиспользуется: после первых строк выделений памяти нет
+        std::string line;
+        size_t start = 0;
+        while (start < chunk.size()) {
+            size_t end = chunk.find('\n', start);
+            if (end == std::string_view::npos) {
+                end = chunk.size();
+            }
+            line.assign(chunk.data() + start, end - start);
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (!line.empty()) {
+                T item = parse(line);
+                if (item) {
+                    out.push_back(std::move(item));
+                }
+            }
+            start = end + 1;
+        }
+    }
+};
+
+#endif
@@ -1,5 +1,7 @@
 #include "user.hpp"
 #include "activity.hpp"
+#include "FieldTokenizer.hpp"
+#include "TextIndex.hpp"
 #include <iostream>
 #include <sstream>
 #include <memory>
@@ -8,12 +10,13 @@
 User::User(const std::string& id, const std::string& uname,
     const std::string& pwdHash, AccessLevel level,
     const std::string& userEmail, const std::string& userPhone)
-    : userId(id), username(uname), passwordHash(pwdHash),
+    : userId(id), username(uname), usernameKey(uname), passwordHash(pwdHash),
     accessLevel(level), email(userEmail), phone(userPhone) {}
 
 User::User(const User& other)
-    : userId(other.userId + "_copy"),
+    : Versioned<User>(other), userId(other.userId + "_copy"),
     username(other.username + " (Copy)"),
+    usernameKey(username),
     passwordHash(other.passwordHash),
     accessLevel(other.accessLevel),
     email(other.email),
@@ -33,8 +36,10 @@ User::~User() {
 
 User& User::operator=(const User& other) {
     if (this != &other) {
+        touch();
         userId = other.userId + "_assigned";
         username = other.username + " (Assigned)";
+        usernameKey = CollationKey(username);
         passwordHash = other.passwordHash;
         accessLevel = other.accessLevel;
         email = other.email;
@@ -63,30 +68,31 @@ User::operator bool() const {
 bool User::login(const std::string& password) {
     bool success = (password == passwordHash);
     if (success) {
-        addActivity("   ");
+        addActivity("Пользователь вошел в систему");
     }
     return success;
 }
 
 void User::logout() {
-    addActivity("   ");
+    addActivity("Пользователь вышел из системы");
 }
 
 bool User::changePassword(const std::string& newPassword) {
+    touch();
     try {
         if (newPassword.length() < 3) {
-            throw std::invalid_argument("    3 ");
+            throw std::invalid_argument("Пароль должен содержать минимум 3 символа");
         }
         if (newPassword.find(' ') != std::string::npos) {
-            throw std::invalid_argument("    ");
+            throw std::invalid_argument("Пароль не должен содержать пробелов");
         }
 
         passwordHash = newPassword;
-        addActivity(" ");
+        addActivity("Пароль изменен");
         return true;
     }
     catch (const std::invalid_argument& e) {
-        std::cerr << "  : " << e.what() << std::endl;
+        std::cerr << "Ошибка изменения пароля: " << e.what() << std::endl;
         return false;
     }
 }
@@ -108,8 +114,8 @@ void User::addActivity(const std::string& action) {
 }
 
 void User::displayInfo() const {
-    std::cout << ": " << username << " ("
-        << (accessLevel == AccessLevel::ADMIN ? "" : "") << ")\n";
+    std::cout << "Пользователь: " << username << " ("
+        << (accessLevel == AccessLevel::ADMIN ? "Администратор" : "Пользователь") << ")\n";
 }
 
 std::string User::getUserId() const {
@@ -120,6 +126,14 @@ std::string User::getUsername() const {
     return username;
 }
 
+const CollationKey& User::getUsernameKey() const {
+    return usernameKey;
+}
+
+std::string User::getPasswordHash() const {
+    return passwordHash;
+}
+
 AccessLevel User::getAccessLevel() const {
     return accessLevel;
 }
@@ -133,56 +147,61 @@ std::string User::getPhone() const {
 }
 
 void User::setAccessLevel(AccessLevel level) {
+    touch();
     accessLevel = level;
 }
 
 std::string User::getFullInfo() const {
     std::string info = "ID: " + userId + "\n";
-    info += ": " + username + "\n";
+    info += "Имя: " + username + "\n";
 
-    info += ": " + (accessLevel == AccessLevel::ADMIN ? std::string("") :
-        std::string("")) + "\n";
+    info += "Роль: " + (accessLevel == AccessLevel::ADMIN ? std::string("Администратор") :
+        std::string("Пользователь")) + "\n";
 
     if (!email.empty()) {
         info += "Email: " + email + "\n";
     }
     if (!phone.empty()) {
-        info += ": " + phone + "\n";
+        info += "Телефон: " + phone + "\n";
     }
 
     std::string lowerUsername = username;
     std::transform(lowerUsername.begin(), lowerUsername.end(), lowerUsername.begin(), ::tolower);
     if (lowerUsername.find("admin") != std::string::npos) {
-        info += ":   'admin'\n";
+        info += "Примечание: Имя содержит 'admin'\n";
     }
 
     return info;
 }
 
 bool User::containsInInfo(const std::string& search) const {
-    std::string allInfo = getFullInfo();
-    std::string lowerAllInfo = allInfo;
-    std::string lowerSearch = search;
-
-    std::transform(lowerAllInfo.begin(), lowerAllInfo.end(), lowerAllInfo.begin(), ::tolower);
-    std::transform(lowerSearch.begin(), lowerSearch.end(), lowerSearch.begin(), ::tolower);
-
-    return lowerAllInfo.find(lowerSearch) != std::string::npos;
+    // Поля проверяются по отдельности, без сборки getFullInfo(). Регистр кириллицы
+    // тоже не учитывается (::tolower менял только латиницу). Поиск по всем
+    // пользователям - EntityRegistry::searchUsers
+    std::u32string needle = TextIndex::fold(search);
+    std::string role = accessLevel == AccessLevel::ADMIN ? "Администратор" : "Пользователь";
+    const std::string* fields[] = { &userId, &username, &role, &email, &phone };
+    for (const std::string* field : fields) {
+        if (TextIndex::fold(*field).find(needle) != std::u32string::npos) {
+            return true;
+        }
+    }
+    return false;
 }
 
 std::string User::getFormattedContactInfo() const {
     std::string contacts;
     if (!email.empty() && !phone.empty()) {
-        contacts = ": " + email + ", " + phone;
+        contacts = "Контакты: " + email + ", " + phone;
     }
     else if (!email.empty()) {
         contacts = "Email: " + email;
     }
     else if (!phone.empty()) {
-        contacts = ": " + phone;
+        contacts = "Телефон: " + phone;
     }
     else {
-        contacts = "  ";
+        contacts = "Контакты не указаны";
     }
     return contacts;
 }
@@ -195,22 +214,12 @@ std::string User::serialize() const {
 }
 
 std::shared_ptr<User> User::deserialize(const std::string& data) {
-    try {
-        std::stringstream ss(data);
-        std::string id, username, password, levelStr, email, phone;
-
-        std::getline(ss, id, '|');
-        std::getline(ss, username, '|');
-        std::getline(ss, password, '|');
-        std::getline(ss, levelStr, '|');
-        std::getline(ss, email, '|');
-        std::getline(ss, phone, '|');
-
-        AccessLevel level = static_cast<AccessLevel>(std::stoi(levelStr));
-        return std::make_shared<User>(id, username, password, level, email, phone);
-    }
-    catch (const std::exception& e) {
-        std::cerr << "  : " << e.what() << std::endl;
+    FieldTokenizer fields(data);
+    int level = 0;
+    if (!fields.getInt(3, level)) {
+        std::cerr << "Ошибка десериализации пользователя: " << fields.errorText() << std::endl;
         return nullptr;
     }
+    return std::make_shared<User>(fields.text(0), fields.text(1), fields.text(2),
+        static_cast<AccessLevel>(level), fields.text(4), fields.text(5));
 }
\ No newline at end of file
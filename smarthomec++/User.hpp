@@ -6,13 +6,16 @@
 #include <memory>
 #include <stdexcept>
 #include "accessLevel.hpp"
+#include "Versioned.hpp"
+#include "CollationKey.hpp"
 
 class Activity;
 
-class User {
+class User : public Versioned<User> {
 private:
     std::string userId;
     std::string username;
+    CollationKey usernameKey;
     std::string passwordHash;
     AccessLevel accessLevel;
     std::string email;
@@ -39,6 +42,8 @@ public:
 
     std::string getUserId() const;
     std::string getUsername() const;
+    const CollationKey& getUsernameKey() const;
+    std::string getPasswordHash() const;
     AccessLevel getAccessLevel() const;
     std::string getEmail() const;
     std::string getPhone() const;
@@ -0,0 +1,55 @@
+﻿#ifndef VERSIONED_HPP
+#define VERSIONED_HPP
+
+#include <cstdint>
+#include <atomic>
+
+// Счетчики изменений для инкрементального сохранения снимка.
+//
+// collectionVersion() - общий счетчик класса T: растет при любом изменении, создании
+// или удалении объекта этого класса. Если он не изменился с прошлого сохранения,
+// ни один объект класса не менялся.
+// getVersion() - значение этого счетчика при последнем изменении объекта (touch()).
+// Версии уникальны в пределах класса, поэтому новый объект, созданный по адресу
+// удаленного, не совпадет с ним по версии.
+//
+// Версия атомарна: устройство, последняя ссылка на которое освободилась в другом
+// потоке, отмечает изменение своей комнаты при выходе из нее
+template <typename T>
+class Versioned {
+private:
+    std::atomic<uint64_t> version;
+    static std::atomic<uint64_t> collectionCounter;
+
+protected:
+    Versioned() : version(++collectionCounter) {}
+
+    Versioned(const Versioned&) : version(++collectionCounter) {}
+
+    Versioned& operator=(const Versioned&) {
+        touch();
+        return *this;
+    }
+
+    ~Versioned() {
+        ++collectionCounter;
+    }
+
+    void touch() {
+        version.store(++collectionCounter, std::memory_order_relaxed);
+    }
+
+public:
+    uint64_t getVersion() const {
+        return version.load(std::memory_order_relaxed);
+    }
+
+    static uint64_t collectionVersion() {
+        return collectionCounter.load();
+    }
+};
+
+template <typename T>
+std::atomic<uint64_t> Versioned<T>::collectionCounter(0);
+
+#endif